@@ -0,0 +1,135 @@
+// utf8_bench.cpp
+// 主机基准：src/utf8.cpp 的字级快路径与逐字节实现（原 main.cpp 中的 looksLikeUtf8）比较吞吐量，
+// 并在随机输入上核对两者结果一致。
+//
+//   g++ -O2 -std=gnu++11 -Isrc bench/utf8_bench.cpp src/utf8.cpp -o utf8_bench && ./utf8_bench
+//
+// 主机上的机器字为 8 字节，ESP32 上为 4 字节，快路径的收益在设备上约为这里的一半。
+
+#include "utf8.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// 原 looksLikeUtf8()：逐字节，只检查首字节与续字节的形状
+static bool byteValid(const char *p, size_t len)
+{
+    size_t i = 0;
+    while (i < len)
+    {
+        uint8_t c = (uint8_t)p[i];
+        size_t n = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+        if (n == 0 || i + n > len)
+            return false;
+        for (size_t k = 1; k < n; k++)
+        {
+            if (((uint8_t)p[i + k] & 0xC0) != 0x80)
+                return false;
+        }
+        i += n;
+    }
+    return true;
+}
+
+static size_t byteCount(const char *p, size_t len)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++)
+        n += ((uint8_t)p[i] & 0xC0) != 0x80;
+    return n;
+}
+
+// 按码点逐个解码的严格校验，用来核对 utf8Valid()
+static bool strictValid(const char *p, size_t len)
+{
+    size_t i = 0;
+    while (i < len)
+    {
+        size_t at = i;
+        uint32_t cp = utf8Decode(p, len, &i);
+        if (cp == 0xFFFD && !(i - at == 3 && (uint8_t)p[at] == 0xEF))
+            return false;
+        size_t n = i - at;
+        uint32_t minCp = n == 2 ? 0x80 : n == 3 ? 0x800 : n == 4 ? 0x10000 : 0;
+        if (cp < minCp || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+            return false;
+    }
+    return true;
+}
+
+static std::string makeText(size_t bytes, int hanziPercent, unsigned seed)
+{
+    static const char *HANZI[] = {"你", "好", "收", "到", "路", "由", "消", "息"};
+    static const char *ASCII = "The quick brown fox jumps over the lazy dog 0123456789 ";
+    srand(seed);
+    std::string s;
+    while (s.size() < bytes)
+    {
+        if (rand() % 100 < hanziPercent)
+            s += HANZI[rand() % 8];
+        else
+            s += ASCII[rand() % 55];
+    }
+    return s;
+}
+
+template <class F>
+static double mbPerSec(const std::string &s, F f, int rounds)
+{
+    volatile size_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+        sink += f(s.data(), s.size());
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    (void)sink;
+    return s.size() * (double)rounds / sec / 1e6;
+}
+
+static int check()
+{
+    int bad = 0;
+    srand(7);
+    for (int t = 0; t < 200000; t++)
+    {
+        char buf[16];
+        size_t len = rand() % sizeof(buf);
+        for (size_t i = 0; i < len; i++)
+        {
+            // 偏向 UTF-8 相关的字节值，才能覆盖边界情况
+            static const uint8_t PICK[] = {'a', 0x80, 0xBF, 0xC0, 0xC2, 0xDF, 0xE0, 0xE4, 0xED,
+                                           0xEF, 0xF0, 0xF4, 0xF5, 0x9F, 0xA0, 0x8F, 0x90};
+            buf[i] = (char)(rand() % 3 ? PICK[rand() % sizeof(PICK)] : rand());
+        }
+        if (utf8Valid(buf, len) != strictValid(buf, len) || utf8Count(buf, len) != byteCount(buf, len))
+            bad++;
+        size_t cut = rand() % (len + 1);
+        size_t f = utf8Floor(buf, len, cut);
+        if (f > cut || (f < len && utf8IsCont((uint8_t)buf[f]) && f != 0))
+            bad++;
+    }
+    return bad;
+}
+
+int main()
+{
+    int bad = check();
+    printf("cross-check: %s\n", bad ? "FAILED" : "ok");
+
+    printf("%-22s %12s %12s %12s %12s\n", "text (64 KB)", "valid byte", "valid word", "count byte", "count word");
+    const int PERCENT[] = {0, 10, 50, 100};
+    for (int pct : PERCENT)
+    {
+        std::string s = makeText(64 * 1024, pct, 1);
+        char name[32];
+        snprintf(name, sizeof(name), "%d%% hanzi", pct);
+        printf("%-22s %9.0f MB/s %7.0f MB/s %7.0f MB/s %7.0f MB/s\n", name, mbPerSec(s, byteValid, 200),
+               mbPerSec(s, utf8Valid, 200), mbPerSec(s, byteCount, 200), mbPerSec(s, utf8Count, 200));
+    }
+    // 无线帧大小的短消息：固定开销占主导
+    std::string msg = makeText(48, 10, 2);
+    printf("%-22s %9.0f MB/s %7.0f MB/s %7.0f MB/s %7.0f MB/s\n", "48-byte message", mbPerSec(msg, byteValid, 1000000),
+           mbPerSec(msg, utf8Valid, 1000000), mbPerSec(msg, byteCount, 1000000), mbPerSec(msg, utf8Count, 1000000));
+    return bad ? 1 : 0;
+}
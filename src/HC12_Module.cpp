@@ -8,6 +8,43 @@
 #include "HC12_Module.h"
 #include <Arduino.h>
 #include <HardwareSerial.h>
+#include "metrics.h"
+#include "trace.h"
+#include "stall.h"
+#include "power.h"
+#include <driver/gpio.h>
+
+/**
+ * @brief 在作用域内持有模块的递归互斥锁（锁尚未创建时不做任何事）
+ */
+class HC12BusGuard
+{
+public:
+    explicit HC12BusGuard(SemaphoreHandle_t lock) : lock(lock)
+    {
+        if (lock)
+            xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+    }
+    ~HC12BusGuard()
+    {
+        if (lock)
+            xSemaphoreGiveRecursive(lock);
+    }
+
+private:
+    SemaphoreHandle_t lock;
+};
+
+/**
+ * @brief 设置本地 UART 接收缓冲大小
+ * @param size 字节数；必须在 init() 之前设置（UART 运行后不能再调整）
+ *
+ * 主机浅睡眠唤醒期间任务暂停运行，较大的缓冲可避免突发数据溢出
+ */
+void HC12Module::setRxBufferSize(size_t size)
+{
+    rxBufferSize = size;
+}
 
 /**
  * @brief 初始化HC-12模块
@@ -19,6 +56,25 @@
  * @return 初始化是否成功
  */
 bool HC12Module::init(int setPin, int uartNum, int rxPin, int txPin, int baudRate)
+{
+    if (!attach(setPin, uartNum, rxPin, txPin, baudRate))
+        return false;
+    HC12BusGuard guard(busLock);
+    setMode(COMM_MODE); // 默认设置为通信模式
+
+    delay(100); // 等待模块稳定
+
+    // 测试连接
+    return testConnection();
+}
+
+/**
+ * @brief 只配置 SET 引脚（通信模式电平）与本地 UART，不等待、不测试连接
+ * @return uartNum 无效时返回 false
+ *
+ * 深度睡眠唤醒时使用：波特率来自 RTC 快照，模块仍在 AT+SLEEP 睡眠中，随后调用 wake()
+ */
+bool HC12Module::attach(int setPin, int uartNum, int rxPin, int txPin, int baudRate)
 {
     this->setPin = setPin;
     this->uartNum = uartNum;
@@ -26,19 +82,28 @@ bool HC12Module::init(int setPin, int uartNum, int rxPin, int txPin, int baudRat
     this->rxPin = rxPin;
     this->txPin = txPin;
     this->currentBaud = baudRate;
+    if (!busLock)
+        busLock = xSemaphoreCreateRecursiveMutex();
+    HC12BusGuard guard(busLock);
 
-    // 初始化SET引脚
+    // 初始化SET引脚（先解除深度睡眠期间的电平保持）
+    gpio_hold_dis((gpio_num_t)setPin);
+    digitalWrite(setPin, HIGH);
     pinMode(setPin, OUTPUT);
-    setMode(COMM_MODE); // 默认设置为通信模式
+    currentMode = COMM_MODE;
 
     // 初始化串口
     if (uartNum == 1)
     {
+        if (rxBufferSize > 0)
+            Serial1.setRxBufferSize(rxBufferSize);
         Serial1.begin(baudRate, SERIAL_8N1, rxPin, txPin);
         hc12Serial = &Serial1;
     }
     else if (uartNum == 2)
     {
+        if (rxBufferSize > 0)
+            Serial2.setRxBufferSize(rxBufferSize);
         Serial2.begin(baudRate, SERIAL_8N1, rxPin, txPin);
         hc12Serial = &Serial2;
     }
@@ -46,11 +111,30 @@ bool HC12Module::init(int setPin, int uartNum, int rxPin, int txPin, int baudRat
     {
         return false;
     }
+    return true;
+}
 
-    delay(100); // 等待模块稳定
+/**
+ * @brief 唤醒 AT+SLEEP 后睡眠的模块：进入 AT 模式再回到通信模式（约 120 ms，期间持有总线锁）
+ */
+void HC12Module::wake()
+{
+    HC12BusGuard guard(busLock);
+    setMode(AT_MODE);
+    setMode(COMM_MODE);
+}
 
-    // 测试连接
-    return testConnection();
+/**
+ * @brief 深度睡眠前保持 SET 引脚的通信模式电平
+ *
+ * 深度睡眠期间普通 GPIO 不再驱动，SET 浮空被拉低会让模块进入 AT 模式而退出睡眠
+ */
+void HC12Module::holdForDeepSleep()
+{
+    HC12BusGuard guard(busLock);
+    if (currentMode != COMM_MODE)
+        setMode(COMM_MODE);
+    gpio_hold_en((gpio_num_t)setPin);
 }
 
 /**
@@ -58,6 +142,7 @@ bool HC12Module::init(int setPin, int uartNum, int rxPin, int txPin, int baudRat
  */
 bool HC12Module::reconfigureLocalSerial(int baudRate)
 {
+    HC12BusGuard guard(busLock);
     // 保存当前波特率
     this->currentBaud = baudRate;
     if (this->uartNum == 1)
@@ -83,17 +168,23 @@ bool HC12Module::reconfigureLocalSerial(int baudRate)
  */
 void HC12Module::setMode(Mode mode)
 {
+    HC12BusGuard guard(busLock);
+    if (mode == currentMode)
+        return; // 引脚已是该电平，无需再等待
     // NOTE: Many HC-12 modules expect SET = LOW to enter AT mode and HIGH for communication mode.
     // Swap the levels so LOW -> AT_MODE, HIGH -> COMM_MODE.
     if (mode == AT_MODE)
     {
         digitalWrite(setPin, LOW);
+        asleep = false; // 进入 AT 模式即退出睡眠
+        powerSetRadioState(RADIO_ST_AT);
         delay(40); // 根据手册要求等待40ms
     }
     else
     {
         digitalWrite(setPin, HIGH);
         delay(80); // 根据手册要求等待80ms
+        powerSetRadioState(asleep ? RADIO_ST_SLEEP : RADIO_ST_RX);
     }
     currentMode = mode;
 }
@@ -106,6 +197,25 @@ void HC12Module::setMode(Mode mode)
  */
 String HC12Module::sendATCommand(const String &command, int timeout)
 {
+    char response[HC12_AT_RESPONSE_MAX];
+    sendATCommand(command.c_str(), response, sizeof(response), timeout);
+    return String(response);
+}
+
+/**
+ * @brief 发送AT指令，响应写入调用者提供的缓冲区
+ * @param command AT指令（不含结尾的 \r\n）
+ * @param response 响应缓冲区，回车换行被滤除
+ * @param cap 缓冲区大小（含结尾 '\0'）
+ * @param timeout 响应超时时间(ms)
+ * @param until 非空时，收到包含该子串的完整一行即提前返回
+ * @return 响应长度
+ */
+size_t HC12Module::sendATCommand(const char *command, char *response, size_t cap, int timeout, const char *until)
+{
+    STALL_SECTION("at command"); // 先于取总线锁：等待无线任务释放总线也算在内
+    HC12BusGuard guard(busLock);
+    TraceScope trace(TR_AT);
     // 如果当前不在 AT 模式，则进入 AT 模式并记录我们切换过来；
     bool switchedToAT = false;
     if (currentMode != AT_MODE)
@@ -124,22 +234,37 @@ String HC12Module::sendATCommand(const String &command, int timeout)
     hc12Serial->print("\r\n");
 
     // 等待响应
-    String response = "";
+    size_t len = 0;
     unsigned long startTime = millis();
+    uint32_t startUs = micros();
+    uint32_t lastByteUs = 0;
 
     while (millis() - startTime < timeout)
     {
         if (hc12Serial->available())
         {
             char c = hc12Serial->read();
+            lastByteUs = micros();
             // 过滤掉回车换行符
-            if (c != '\r' && c != '\n')
+            if (c != '\r' && c != '\n' && len + 1 < cap)
             {
-                response += c;
+                response[len++] = c;
             }
+            else if (c == '\n' && until && cap > 0)
+            {
+                response[len] = '\0';
+                if (strstr(response, until))
+                    break;
+            }
+            continue;
         }
         delay(1);
     }
+    if (cap > 0)
+        response[len] = '\0';
+    // 响应延迟按最后一个响应字节计（未指定 until 时本函数总是等满 timeout）
+    if (lastByteUs)
+        metricTime(MT_AT_CMD, lastByteUs - startUs);
 
     // 只有当本调用切换到了 AT 模式时，才在返回前切回通信模式；如果外部已经在 AT 模式（如设置界面），
     // 则不自动切换，等待外部显式退出 AT 模式以生效设置。
@@ -147,7 +272,7 @@ String HC12Module::sendATCommand(const String &command, int timeout)
     {
         setMode(COMM_MODE);
     }
-    return response;
+    return len;
 }
 
 /**
@@ -156,8 +281,9 @@ String HC12Module::sendATCommand(const String &command, int timeout)
  */
 bool HC12Module::testConnection()
 {
-    String response = sendATCommand("AT");
-    return response.indexOf("OK") >= 0;
+    char response[HC12_AT_RESPONSE_MAX];
+    sendATCommand("AT", response, sizeof(response), 1000, "OK");
+    return strstr(response, "OK") != nullptr;
 }
 
 /**
@@ -341,7 +467,13 @@ bool HC12Module::setParity(char parity)
 bool HC12Module::enterSleepMode()
 {
     String response = sendATCommand("AT+SLEEP");
-    return response.indexOf("OK") >= 0;
+    if (response.indexOf("OK") < 0)
+        return false;
+    // 模块在退出 AT 模式后进入睡眠；sendATCommand 已切回通信模式时从现在开始计
+    asleep = true;
+    if (currentMode == COMM_MODE)
+        powerSetRadioState(RADIO_ST_SLEEP);
+    return true;
 }
 
 /**
@@ -351,6 +483,18 @@ bool HC12Module::enterSleepMode()
  */
 bool HC12Module::sendData(const String &data)
 {
+    return sendData((const uint8_t *)data.c_str(), data.length());
+}
+
+/**
+ * @brief 通过HC-12发送一段字节
+ * @param data 数据指针
+ * @param len 字节数
+ * @return 发送是否成功
+ */
+bool HC12Module::sendData(const uint8_t *data, size_t len)
+{
+    HC12BusGuard guard(busLock);
     if (currentMode != COMM_MODE)
     {
         setMode(COMM_MODE);
@@ -363,8 +507,10 @@ bool HC12Module::sendData(const String &data)
     }
 
     // 发送数据
-    size_t bytesWritten = hc12Serial->print(data);
+    powerSetRadioState(RADIO_ST_TX);
+    size_t bytesWritten = hc12Serial->write(data, len);
     hc12Serial->flush(); // 确保数据发送完成
+    powerSetRadioState(asleep ? RADIO_ST_SLEEP : RADIO_ST_RX);
 
     return bytesWritten > 0;
 }
@@ -384,6 +530,7 @@ bool HC12Module::available()
  */
 String HC12Module::readData()
 {
+    HC12BusGuard guard(busLock);
     String data = "";
     while (hc12Serial->available())
     {
@@ -392,11 +539,47 @@ String HC12Module::readData()
     return data;
 }
 
+/**
+ * @brief 读取数据到调用者提供的缓冲区
+ * @param buf 目标缓冲区（不追加 '\0'）
+ * @param cap 最多读取的字节数
+ * @return 实际读取的字节数；剩余数据留在串口缓冲中供下次读取
+ */
+size_t HC12Module::readData(char *buf, size_t cap)
+{
+    HC12BusGuard guard(busLock);
+    size_t avail = (size_t)hc12Serial->available();
+    if (avail == 0 || cap == 0)
+        return 0;
+    return hc12Serial->read((uint8_t *)buf, avail < cap ? avail : cap);
+}
+
+/**
+ * @brief 注册接收回调
+ * @param cb 回调函数；仅在 UART 接收超时（线路空闲）时触发，一次回调对应一段连续到达的数据
+ */
+void HC12Module::onReceive(OnReceiveCb cb)
+{
+    HC12BusGuard guard(busLock);
+    hc12Serial->onReceive(cb, true);
+}
+
+/**
+ * @brief 注册接收错误回调
+ * @param cb 回调函数；参数为错误类型（UART_FIFO_OVF_ERROR、UART_BUFFER_FULL_ERROR 等）
+ */
+void HC12Module::onReceiveError(OnReceiveErrorCb cb)
+{
+    HC12BusGuard guard(busLock);
+    hc12Serial->onReceiveError(cb);
+}
+
 /**
  * @brief 硬件诊断函数
  */
 void HC12Module::diagnoseHardware()
 {
+    HC12BusGuard guard(busLock);
     Serial.println("\n=== HC-12 Hardware Diagnosis ===");
 
     // 1. 检查SET引脚状态
@@ -8,6 +8,11 @@
 
 #include <Arduino.h>
 #include <HardwareSerial.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// AT 响应缓冲大小（AT+RX 的多行响应约 60 字节）
+constexpr size_t HC12_AT_RESPONSE_MAX = 128;
 
 class HC12Module
 {
@@ -18,20 +23,35 @@ public:
         COMM_MODE
     };
 
+    // 设置本地 UART 接收缓冲大小（在 init 之前调用；0 为使用默认值）
+    void setRxBufferSize(size_t size);
+
     // 初始化函数
     bool init(int setPin, int uartNum = 2, int rxPin = 16, int txPin = 17, int baudRate = 9600);
+    // 不探测模块，只配置引脚与本地 UART（深度睡眠唤醒，波特率已知）
+    bool attach(int setPin, int uartNum, int rxPin, int txPin, int baudRate);
+    // 唤醒 AT+SLEEP 后的模块
+    void wake();
+    // 深度睡眠前保持 SET 引脚电平
+    void holdForDeepSleep();
 
     // 模式控制
     void setMode(Mode mode);
 
     // AT指令功能
     String sendATCommand(const String &command, int timeout = 1000);
+    // 同上，响应写入 response（以 '\0' 结尾，超出 cap-1 的部分丢弃），返回响应长度；不分配堆内存。
+    // until 非空时，收到包含该子串的完整一行即返回，不再等满 timeout
+    size_t sendATCommand(const char *command, char *response, size_t cap, int timeout = 1000,
+                         const char *until = nullptr);
     bool testConnection();
     String getVersion();
     String getBaudRate();
     bool setBaudRate(int baudRate);
     // 在主机端重新配置本地 UART（不发送 AT 指令，仅本地重设）
     bool reconfigureLocalSerial(int baudRate);
+    // 本地 UART 当前波特率
+    int localBaud() const { return currentBaud; }
     String getChannel();
     bool setChannel(String channel);
     String getMode();
@@ -45,8 +65,15 @@ public:
 
     // 数据收发
     bool sendData(const String &data);
+    bool sendData(const uint8_t *data, size_t len);
     bool available();
     String readData();
+    // 读取至多 cap 字节到 buf，返回实际读取数；不分配堆内存
+    size_t readData(char *buf, size_t cap);
+    // 注册接收回调（UART 接收超时即一帧结束后触发，运行在 UART 事件任务中）
+    void onReceive(OnReceiveCb cb);
+    // 注册接收错误回调（FIFO/缓冲溢出、帧错误等，运行在 UART 事件任务中）
+    void onReceiveError(OnReceiveErrorCb cb);
 
     // 诊断功能
     void diagnoseHardware();
@@ -63,6 +90,11 @@ private:
     int rxPin = -1;
     int txPin = -1;
     int currentBaud = 9600;
+    size_t rxBufferSize = 0;
+    // 串口与 SET 引脚的递归互斥锁：无线任务与界面任务共享模块时，保证一次 AT 交互或发送不被打断
+    SemaphoreHandle_t busLock = nullptr;
+    // AT+SLEEP 成功后为 true，直到再次进入 AT 模式（能耗统计用）
+    bool asleep = false;
 };
 
 #endif // HC12_MODULE_H
@@ -0,0 +1,209 @@
+// alloc_count.cpp
+// malloc/calloc/realloc/free 的 --wrap 包装与调用点统计（包装仅在定义 WM_ALLOC_COUNT 时编译）
+
+#include "alloc_count.h"
+#include "config.h"
+#include "stall.h"
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// 每轮 loop() 的分配统计（只由 UI 任务读写）
+static uint32_t loopPasses = 0;
+static uint32_t loopAllocSum = 0;
+static uint32_t loopAllocMax = 0;
+
+static HeapSample samples[ALLOC_SAMPLES];
+static size_t sampleHead = 0;
+static size_t sampleCount = 0;
+
+#ifdef WM_ALLOC_COUNT
+
+static AllocSite sites[ALLOC_SITES_MAX];
+static AllocSite overflow; // 表满后的分配
+static uint32_t frees = 0;
+static portMUX_TYPE siteLock = portMUX_INITIALIZER_UNLOCKED;
+
+// 在分配钩子中运行：不能分配、不能打日志
+static void recordAlloc(void *returnAddress, size_t bytes)
+{
+    metricInc(MC_HEAP_ALLOCS);
+    if (xPortGetCoreID() == ARDUINO_RUNNING_CORE)
+        metricInc(MC_UI_ALLOCS);
+
+    uint32_t caller = stallCallerAddress(returnAddress);
+    const char *tag = stallSection();
+    if (!tag && xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+        tag = pcTaskGetTaskName(nullptr);
+
+    portENTER_CRITICAL(&siteLock);
+    AllocSite *site = &overflow;
+    size_t h = (caller ^ (uint32_t)(uintptr_t)tag) % ALLOC_SITES_MAX;
+    for (size_t i = 0; i < ALLOC_SITES_MAX; i++)
+    {
+        AllocSite &s = sites[(h + i) % ALLOC_SITES_MAX];
+        if (s.count == 0)
+        {
+            s.caller = caller;
+            s.tag = tag;
+        }
+        if (s.caller == caller && s.tag == tag)
+        {
+            site = &s;
+            break;
+        }
+    }
+    site->count++;
+    site->bytes += bytes;
+    portEXIT_CRITICAL(&siteLock);
+}
+
+extern "C"
+{
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t n, size_t size);
+    void *__real_realloc(void *ptr, size_t size);
+    void __real_free(void *ptr);
+
+    void *__wrap_malloc(size_t size)
+    {
+        recordAlloc(__builtin_return_address(0), size);
+        return __real_malloc(size);
+    }
+
+    void *__wrap_calloc(size_t n, size_t size)
+    {
+        recordAlloc(__builtin_return_address(0), n * size);
+        return __real_calloc(n, size);
+    }
+
+    // realloc(ptr, 0) 是释放，计入释放次数
+    void *__wrap_realloc(void *ptr, size_t size)
+    {
+        if (size)
+            recordAlloc(__builtin_return_address(0), size);
+        else if (ptr)
+            __atomic_add_fetch(&frees, 1, __ATOMIC_RELAXED);
+        return __real_realloc(ptr, size);
+    }
+
+    void __wrap_free(void *ptr)
+    {
+        if (ptr)
+            __atomic_add_fetch(&frees, 1, __ATOMIC_RELAXED);
+        __real_free(ptr);
+    }
+}
+
+bool allocTrackingEnabled()
+{
+    return true;
+}
+
+static void printSites()
+{
+    // 先复制快照，打印期间的分配不影响排序
+    static AllocSite snapshot[ALLOC_SITES_MAX];
+    portENTER_CRITICAL(&siteLock);
+    memcpy(snapshot, sites, sizeof(snapshot));
+    AllocSite other = overflow;
+    portEXIT_CRITICAL(&siteLock);
+
+    Serial.printf("allocs %lu, frees %lu; top sites by bytes (caller, tag):\n",
+                  (unsigned long)metricGet(MC_HEAP_ALLOCS), (unsigned long)frees);
+    for (size_t n = 0; n < ALLOC_SITES_PRINT; n++)
+    {
+        AllocSite *top = nullptr;
+        for (auto &s : snapshot)
+        {
+            if (s.count && (!top || s.bytes > top->bytes))
+                top = &s;
+        }
+        if (!top)
+            break;
+        Serial.printf("  0x%08lx %-12s %8lu x %10lu B\n", (unsigned long)top->caller, top->tag ? top->tag : "-",
+                      (unsigned long)top->count, (unsigned long)top->bytes);
+        top->count = 0;
+    }
+    if (other.count)
+        Serial.printf("  (table full) %lu x %lu B\n", (unsigned long)other.count, (unsigned long)other.bytes);
+}
+
+static void resetSites()
+{
+    portENTER_CRITICAL(&siteLock);
+    memset(sites, 0, sizeof(sites));
+    memset(&overflow, 0, sizeof(overflow));
+    portEXIT_CRITICAL(&siteLock);
+    frees = 0;
+}
+
+#else
+
+bool allocTrackingEnabled()
+{
+    return false;
+}
+
+static void printSites()
+{
+    Serial.println("allocation tracking compiled out (WM_ALLOC_COUNT)");
+}
+
+static void resetSites() {}
+
+#endif
+
+void allocLoopEnd(uint32_t allocsAtStart)
+{
+    uint32_t n = allocCountUi() - allocsAtStart;
+    loopPasses++;
+    if (n == 0)
+        return;
+    metricInc(MC_LOOP_ALLOCS);
+    loopAllocSum += n;
+    if (n > loopAllocMax)
+        loopAllocMax = n;
+}
+
+void allocSampleHeap()
+{
+    HeapSample &s = samples[sampleHead];
+    s.atSec = millis() / 1000;
+    s.freeBytes = ESP.getFreeHeap();
+    s.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    sampleHead = (sampleHead + 1) % ALLOC_SAMPLES;
+    if (sampleCount < ALLOC_SAMPLES)
+        sampleCount++;
+}
+
+void allocPrintReport()
+{
+    printSites();
+
+    uint32_t allocPasses = metricGet(MC_LOOP_ALLOCS);
+    Serial.printf("loop: %lu passes, %lu allocated (%.1f%%), %.2f allocs/pass avg, max %lu\n",
+                  (unsigned long)loopPasses, (unsigned long)allocPasses,
+                  loopPasses ? 100.0 * allocPasses / loopPasses : 0.0,
+                  loopPasses ? (double)loopAllocSum / loopPasses : 0.0, (unsigned long)loopAllocMax);
+
+    // 最大空闲块相对空闲总量越小，碎片越多
+    Serial.printf("heap trend (free / largest block / fragmentation), last %u samples:\n", (unsigned)sampleCount);
+    for (size_t i = 0; i < sampleCount; i++)
+    {
+        const HeapSample &s = samples[(sampleHead + ALLOC_SAMPLES - sampleCount + i) % ALLOC_SAMPLES];
+        Serial.printf("  %6lu s %7lu %7lu %3lu%%\n", (unsigned long)s.atSec, (unsigned long)s.freeBytes,
+                      (unsigned long)s.largestBlock,
+                      s.freeBytes ? (unsigned long)(100 - (uint64_t)s.largestBlock * 100 / s.freeBytes) : 0UL);
+    }
+}
+
+void allocReset()
+{
+    resetSites();
+    loopPasses = 0;
+    loopAllocSum = 0;
+    loopAllocMax = 0;
+    sampleHead = 0;
+    sampleCount = 0;
+}
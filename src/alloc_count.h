@@ -0,0 +1,58 @@
+// alloc_count.h
+// 可选的堆分配统计：链接时用 --wrap 拦截 malloc/calloc/realloc/free，
+//   - 计入 metrics.h 的计数器（`stats` 中的 heap allocs / ui allocs / loop allocs）；
+//   - 按调用点归类：调用者地址 + 标签（UI 任务上为当前 STALL_SECTION 区段名，其它任务为任务名），
+//     累计次数与字节数，用于找出 String / std::map 反复分配的来源；
+//   - 每轮 loop() 的分配次数（平均、最大、发生分配的轮数比例）；
+//   - 定期采样空闲堆与最大空闲块，观察碎片化趋势。
+// 控制台 `heap` 查看，`heap reset` 清零。调用者地址用 addr2line 解析（同 stall.h）。
+//
+// 启用方法（platformio.ini 的 build_flags）：
+//   -DWM_ALLOC_COUNT -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc -Wl,--wrap=free
+// 未启用时计数恒为 0，不影响链接。主机端对应工具见 tools/alloc_interpose.c。
+
+#ifndef WM_ALLOC_COUNT_H
+#define WM_ALLOC_COUNT_H
+
+#include <Arduino.h>
+#include "metrics.h"
+
+// 一个分配调用点
+struct AllocSite
+{
+    uint32_t caller; // malloc 等的返回地址
+    const char *tag; // 区段名或任务名，可为 nullptr
+    uint32_t count;
+    uint32_t bytes;
+};
+
+// 一次堆采样
+struct HeapSample
+{
+    uint32_t atSec;
+    uint32_t freeBytes;
+    uint32_t largestBlock; // 最大可分配连续块
+};
+
+// 运行在 UI 核（loop() 所在核）上的分配次数；loop() 比较一轮前后的值判断该轮是否分配
+static inline uint32_t allocCountUi()
+{
+    return metricGet(MC_UI_ALLOCS);
+}
+
+// loop() 每轮结束时调用，allocsAtStart 为该轮开始时的 allocCountUi()
+void allocLoopEnd(uint32_t allocsAtStart);
+
+// 采样一次空闲堆与最大空闲块（周期调用，见 ALLOC_SAMPLE_MS）
+void allocSampleHeap();
+
+// 是否编译了统计（WM_ALLOC_COUNT）
+bool allocTrackingEnabled();
+
+// 打印调用点（按字节数降序，最多 ALLOC_SITES_PRINT 个）、每轮分配率与堆采样
+void allocPrintReport();
+
+// 清零调用点、每轮统计与堆采样
+void allocReset();
+
+#endif // WM_ALLOC_COUNT_H
@@ -0,0 +1,515 @@
+// app_tasks.cpp
+// FreeRTOS 任务与队列实现
+//
+// 无线任务由 UART 接收超时回调唤醒（一帧数据接收完毕、线路空闲约 2 个字符时间后触发），
+// 因此收包到 UI 任务被唤醒不依赖任何轮询周期；发送请求同样通过任务通知立即处理。
+// 键盘任务平时阻塞在行中断上，事件入队后立即通知 UI 任务。
+
+#include "app_tasks.h"
+#include "config.h"
+#include "logger.h"
+#include "HC12_Module.h"
+#include "metrics.h"
+#include "radio_crypto.h"
+#include "rip.h"
+#include "trace.h"
+#include "stall.h"
+#include <SPIFFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+
+extern HC12Module hc12;
+
+// I/O 任务放在 core 0（与 WiFi/BT 协议栈同核，本项目未使用），UI 与键盘和 loop 同核；
+// 单核芯片上 ARDUINO_RUNNING_CORE 也为 0
+static const BaseType_t IO_CORE = 0;
+static const BaseType_t UI_CORE = ARDUINO_RUNNING_CORE;
+
+// 持久化请求：写文件（content 由持久化任务写完后释放），或 fn 不为空时执行 fn(data)
+struct PersistJob
+{
+    char path[32];
+    String *content;
+    void (*fn)(const void *data);
+    uint8_t data[PERSIST_DATA_MAX];
+};
+
+static QueueHandle_t radioRxQueue = nullptr;
+static QueueHandle_t radioTxQueue = nullptr;
+static QueueHandle_t inputQueue = nullptr;
+static QueueHandle_t persistQueue = nullptr;
+
+static TaskHandle_t uiTask = nullptr;
+static TaskHandle_t radioTask = nullptr; // radioTaskStart() 之前为空
+static volatile bool radioBusy = false;
+static volatile bool persistBusy = false;
+
+// 唤醒前导：对端可能处于浅睡眠，由 UART RX 活动唤醒，触发唤醒的前几个字节会丢失。
+// 前导由若干 0x55 与一个 STX 组成；接收时去掉“0x55* STX”开头（前导可能只剩一部分）
+static const char WAKE_PREAMBLE_BYTE = 0x55;
+static const char WAKE_PREAMBLE_END = 0x02;
+
+static size_t wakePreambleLength(const char *data, size_t len)
+{
+    size_t i = 0;
+    while (i < len && data[i] == WAKE_PREAMBLE_BYTE)
+        i++;
+    if (i < len && data[i] == WAKE_PREAMBLE_END)
+        return i + 1;
+    return 0; // 没有前导（旧版本发送方），原样保留
+}
+
+// 加密帧在空中为 [0x55…] STX LEN 加密帧[LEN]：接收方按 LEN 从字节流中切分，一次读取可含多帧，
+// 一帧也可分几次到达。不论是否加前导都有 STX，作为帧头
+static const size_t SEALED_MAX = RADIO_FRAME_MAX + RADIO_CRYPTO_OVERHEAD;
+static_assert(SEALED_MAX <= 0xFF, "sealed frame length must fit in one byte");
+
+// 加密帧重组缓冲（只在无线任务中访问）：解析后只留下未收完的一帧，再读入时至少还有一帧的空间
+static uint8_t rxBuf[2 * (2 + SEALED_MAX)];
+static size_t rxFill = 0;
+static uint32_t rxLastMs = 0; // 最近一次读入的时刻
+
+// 加上唤醒前导（并在启用时加密）后经 HC-12 发送
+static bool sendWithPreamble(const char *data, size_t len)
+{
+    TraceScope trace(TR_TX, len);
+    // 前导与数据拼在栈上一次写出（len 不超过 RADIO_FRAME_MAX）
+    uint8_t out[HC12_WAKE_PREAMBLE_LEN + 2 + SEALED_MAX];
+    size_t n = 0;
+    if (HC12_WAKE_PREAMBLE_LEN > 0)
+    {
+        memset(out, WAKE_PREAMBLE_BYTE, HC12_WAKE_PREAMBLE_LEN);
+        n = HC12_WAKE_PREAMBLE_LEN;
+        out[n++] = WAKE_PREAMBLE_END;
+    }
+    if (cryptoEnabled())
+    {
+        if (HC12_WAKE_PREAMBLE_LEN == 0)
+            out[n++] = WAKE_PREAMBLE_END;
+        size_t sealed = cryptoSeal((const uint8_t *)data, len, out + n + 1);
+        if (sealed == 0)
+        {
+            metricInc(MC_TX_FAILED);
+            return false;
+        }
+        out[n++] = (uint8_t)sealed;
+        n += sealed;
+    }
+    else
+    {
+        memcpy(out + n, data, len);
+        n += len;
+    }
+    bool ok = hc12.sendData(out, n); // 不在通信模式时由 sendData() 切换
+    if (ok)
+    {
+        metricInc(MC_TX_FRAMES);
+        metricInc(MC_TX_BYTES, len);
+    }
+    else
+    {
+        metricInc(MC_TX_FAILED);
+    }
+    return ok;
+}
+
+// 执行 AT 指令或 AT 作业并把响应作为 AT 帧送回 UI 任务（frame 被复用为响应，atFn 保留）
+static void runAtCommand(RadioFrame &frame)
+{
+    char resp[HC12_AT_RESPONSE_MAX];
+    size_t n;
+    if (frame.atFn)
+    {
+        n = frame.atFn(frame.data, resp, sizeof(resp));
+    }
+    else
+    {
+        n = hc12.sendATCommand(frame.data, resp, sizeof(resp), HC12_AT_TIMEOUT_MS);
+        if (n == 0)
+            n = strlcpy(resp, "(no response)", sizeof(resp));
+    }
+    n = min(n, RADIO_FRAME_MAX);
+    memcpy(frame.data, resp, n);
+    frame.data[n] = '\0';
+    frame.len = (uint16_t)n;
+    frame.kind = RADIO_FRAME_AT;
+    if (xQueueSend(radioRxQueue, &frame, 0) != pdTRUE)
+        LOGW(LM_RADIO, "RX queue full, AT response dropped");
+    uiNotify();
+}
+
+static void writeFileNow(const char *path, const String &content)
+{
+    TraceScope trace(TR_FLASH_WRITE, content.length());
+    STALL_SECTION("flash write");
+    if (!SPIFFS.begin(true))
+        return;
+    File f = SPIFFS.open(path, FILE_WRITE);
+    if (!f)
+        return;
+    f.print(content);
+    f.close();
+}
+
+// UART 接收超时回调（运行在 UART 事件任务中）
+static void onRadioReceive()
+{
+    if (radioTask)
+        xTaskNotifyGive(radioTask);
+}
+
+// UART 接收错误回调（运行在 UART 事件任务中）
+static void onRadioReceiveError(hardwareSerial_error_t err)
+{
+    if (err == UART_FIFO_OVF_ERROR || err == UART_BUFFER_FULL_ERROR)
+        metricInc(MC_UART_OVERRUN);
+    else if (err != UART_NO_ERROR)
+        metricInc(MC_UART_ERROR);
+}
+
+// 把明文帧交给 UI 任务；队列满时返回 false
+static bool queueRx(RadioFrame &frame, size_t n)
+{
+    frame.data[n] = '\0';
+    frame.len = (uint16_t)n;
+    frame.kind = RADIO_FRAME_DATA;
+    if (xQueueSend(radioRxQueue, &frame, 0) != pdTRUE)
+    {
+        metricInc(MC_RX_DROPPED);
+        LOGW(LM_RADIO, "RX queue full, frame dropped");
+        return false;
+    }
+    metricInc(MC_RX_FRAMES);
+    return true;
+}
+
+// 从重组缓冲中切出完整的加密帧，认证解密后入队；未收完的帧留在缓冲开头等待后续字节
+static void drainSealed(RadioFrame &frame)
+{
+    size_t pos = 0;
+    while (pos < rxFill)
+    {
+        // 帧头之前只会是前导或噪声
+        const uint8_t *stx = (const uint8_t *)memchr(rxBuf + pos, WAKE_PREAMBLE_END, rxFill - pos);
+        if (!stx)
+        {
+            pos = rxFill;
+            break;
+        }
+        pos = stx - rxBuf;
+        if (pos + 2 > rxFill)
+            break; // 长度字节还没到
+        size_t len = rxBuf[pos + 1];
+        if (len < RADIO_CRYPTO_OVERHEAD || len > SEALED_MAX)
+        {
+            pos++; // 不是帧头（噪声或密文中的 0x02）
+            continue;
+        }
+        if (pos + 2 + len > rxFill)
+            break; // 帧还没收完
+        uint8_t tag = 0;
+        int n = cryptoOpen(rxBuf + pos + 2, len, (uint8_t *)frame.data, RADIO_FRAME_MAX, &tag);
+        if (n < 0)
+        {
+            pos++; // 认证失败时只跳过帧头，以免误把密文中的 0x02 当成帧头时吞掉后面的真帧
+            continue;
+        }
+        pos += 2 + len;
+        const char *id;
+        size_t idLen;
+        if (ripUpdateSender(frame.data, n, &id, &idLen) && !cryptoCheckSender(tag, id, idLen))
+            continue;
+        if (!queueRx(frame, n))
+            break;
+    }
+    memmove(rxBuf, rxBuf + pos, rxFill - pos);
+    rxFill -= pos;
+}
+
+static void radioTaskMain(void *)
+{
+    RadioFrame frame;
+    for (;;)
+    {
+        // 超时兜底：即便回调丢失也能在 50ms 内取走数据
+        radioBusy = false;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+        radioBusy = true;
+
+        // 先收后发：sendData() 发送前会清空接收缓冲
+        if (hc12.available() && cryptoEnabled())
+        {
+            // 加密帧读入重组缓冲，按长度字节切分
+            size_t total = 0;
+            traceBegin(TR_RX);
+            while (hc12.available())
+            {
+                size_t n = hc12.readData((char *)rxBuf + rxFill, sizeof(rxBuf) - rxFill);
+                rxFill += n;
+                total += n;
+                drainSealed(frame);
+                if (rxFill == sizeof(rxBuf))
+                    rxFill = 0; // 不会发生：解析后至多剩一帧
+            }
+            rxLastMs = millis();
+            traceEnd(TR_RX, total);
+            metricInc(MC_RX_BYTES, total);
+            uiNotify();
+        }
+        else if (hc12.available())
+        {
+            // 明文直接读入队列元素，按 RADIO_FRAME_MAX 分块；只有第一块可能带唤醒前导
+            bool first = true;
+            size_t total = 0;
+            traceBegin(TR_RX);
+            while (hc12.available())
+            {
+                size_t n = hc12.readData(frame.data, RADIO_FRAME_MAX);
+                if (first)
+                {
+                    size_t off = wakePreambleLength(frame.data, n);
+                    memmove(frame.data, frame.data + off, n - off);
+                    n -= off;
+                    first = false;
+                }
+                if (n == 0)
+                    continue;
+                total += n;
+                if (!queueRx(frame, n))
+                    break;
+            }
+            traceEnd(TR_RX, total);
+            metricInc(MC_RX_BYTES, total);
+            uiNotify();
+        }
+
+        // 帧的其余字节迟迟不来（丢失）：跳过当前帧头重新解析，直到缓冲中不再有未收完的帧
+        if (rxFill > 0 && millis() - rxLastMs >= RADIO_RX_REASSEMBLY_MS)
+        {
+            while (rxFill > 0)
+            {
+                memmove(rxBuf, rxBuf + 1, --rxFill);
+                drainSealed(frame);
+            }
+            uiNotify();
+        }
+
+        while (xQueueReceive(radioTxQueue, &frame, 0) == pdTRUE)
+        {
+            if (frame.kind == RADIO_FRAME_AT)
+                runAtCommand(frame);
+            else
+                sendWithPreamble(frame.data, frame.len);
+        }
+
+        // 收发完毕后为接下来的发送预先算好密钥流
+        cryptoRefill();
+    }
+}
+
+static void inputTaskMain(void *)
+{
+    keypadScanBegin();
+    KeyEvent ev;
+    for (;;)
+    {
+        keypadScanNext(ev);
+        if (xQueueSend(inputQueue, &ev, 0) != pdTRUE)
+            LOGW(LM_MAIN, "input queue full, key event dropped");
+        uiNotify();
+    }
+}
+
+static void persistTaskMain(void *)
+{
+    PersistJob job;
+    for (;;)
+    {
+        if (xQueueReceive(persistQueue, &job, portMAX_DELAY) != pdTRUE)
+            continue;
+        persistBusy = true;
+        if (job.fn)
+        {
+            job.fn(job.data);
+        }
+        else
+        {
+            writeFileNow(job.path, *job.content);
+            delete job.content;
+        }
+        persistBusy = false;
+    }
+}
+
+// 无线任务在队列创建（tasksStart）且 HC-12 就绪（radioTaskStart）之后启动，两者先后不定
+static portMUX_TYPE startLock = portMUX_INITIALIZER_UNLOCKED;
+static bool queuesReady = false;
+static bool radioWanted = false;
+static bool radioStarted = false;
+
+static void startRadioIfReady()
+{
+    portENTER_CRITICAL(&startLock);
+    bool go = queuesReady && radioWanted && !radioStarted;
+    if (go)
+        radioStarted = true;
+    portEXIT_CRITICAL(&startLock);
+    if (!go)
+        return;
+    TaskHandle_t h = nullptr;
+    xTaskCreatePinnedToCore(radioTaskMain, "radio", 6144, nullptr, RADIO_TASK_PRIO, &h, IO_CORE);
+    radioTask = h;
+    hc12.onReceive(onRadioReceive);
+    hc12.onReceiveError(onRadioReceiveError);
+    xTaskNotifyGive(radioTask); // 取走启动前排队的发送
+}
+
+void tasksStart()
+{
+    uiTask = xTaskGetCurrentTaskHandle();
+
+    radioRxQueue = xQueueCreate(RADIO_RX_QUEUE_LEN, sizeof(RadioFrame));
+    radioTxQueue = xQueueCreate(RADIO_TX_QUEUE_LEN, sizeof(RadioFrame));
+    inputQueue = xQueueCreate(INPUT_QUEUE_LEN, sizeof(KeyEvent));
+    persistQueue = xQueueCreate(PERSIST_QUEUE_LEN, sizeof(PersistJob));
+
+    xTaskCreatePinnedToCore(inputTaskMain, "input", 2048, nullptr, INPUT_TASK_PRIO, nullptr, UI_CORE);
+    xTaskCreatePinnedToCore(persistTaskMain, "persist", 4096, nullptr, PERSIST_TASK_PRIO, nullptr, IO_CORE);
+    Serial.onReceive(uiNotify);
+
+    portENTER_CRITICAL(&startLock);
+    queuesReady = true;
+    portEXIT_CRITICAL(&startLock);
+    startRadioIfReady();
+}
+
+void radioTaskStart()
+{
+    portENTER_CRITICAL(&startLock);
+    radioWanted = true;
+    portEXIT_CRITICAL(&startLock);
+    startRadioIfReady();
+}
+
+static bool queueTx(const char *data, size_t len, RadioFrameKind kind, RadioAtFn atFn = nullptr)
+{
+    RadioFrame frame;
+    memcpy(frame.data, data, len);
+    frame.data[len] = '\0';
+    frame.len = (uint16_t)len;
+    frame.kind = kind;
+    frame.atFn = atFn;
+    if (xQueueSend(radioTxQueue, &frame, 0) != pdTRUE)
+        return false;
+    if (radioTask)
+        xTaskNotifyGive(radioTask); // 无线任务未启动时留在队列中，启动后发送
+    return true;
+}
+
+bool radioSend(const char *data, size_t len)
+{
+    if (len == 0 || len > RADIO_FRAME_MAX)
+        return false;
+    if (!radioTxQueue)
+    {
+        // 任务尚未启动（如开机阶段）：直接发送
+        return sendWithPreamble(data, len);
+    }
+    if (!queueTx(data, len, RADIO_FRAME_DATA))
+    {
+        metricInc(MC_TX_FAILED);
+        return false;
+    }
+    return true;
+}
+
+bool radioAtCommand(const char *cmd, size_t len)
+{
+    if (len == 0 || len > RADIO_FRAME_MAX || !radioTxQueue)
+        return false;
+    return queueTx(cmd, len, RADIO_FRAME_AT);
+}
+
+bool radioAtRun(RadioAtFn fn, const char *arg, size_t len)
+{
+    if (!fn || len > RADIO_FRAME_MAX || !radioTxQueue)
+        return false;
+    return queueTx(arg, len, RADIO_FRAME_AT, fn);
+}
+
+bool radioReceive(RadioFrame &out)
+{
+    return radioRxQueue && xQueueReceive(radioRxQueue, &out, 0) == pdTRUE;
+}
+
+bool inputReceive(KeyEvent &ev)
+{
+    return inputQueue && xQueueReceive(inputQueue, &ev, 0) == pdTRUE;
+}
+
+void persistWriteFile(const char *path, String *content)
+{
+    if (persistQueue)
+    {
+        PersistJob job;
+        strncpy(job.path, path, sizeof(job.path) - 1);
+        job.path[sizeof(job.path) - 1] = '\0';
+        job.content = content;
+        job.fn = nullptr;
+        if (xQueueSend(persistQueue, &job, 0) == pdTRUE)
+            return;
+        LOGW(LM_MAIN, "persist queue full, writing synchronously");
+    }
+    writeFileNow(path, *content);
+    delete content;
+}
+
+bool persistRun(void (*fn)(const void *data), const void *data, size_t len)
+{
+    if (len > PERSIST_DATA_MAX)
+        return false;
+    PersistJob job;
+    job.path[0] = '\0';
+    job.content = nullptr;
+    job.fn = fn;
+    if (len)
+        memcpy(job.data, data, len);
+    if (persistQueue)
+    {
+        if (xQueueSend(persistQueue, &job, 0) == pdTRUE)
+            return true;
+        LOGW(LM_MAIN, "persist queue full, running synchronously");
+    }
+    STALL_SECTION("persist run");
+    fn(job.data);
+    return true;
+}
+
+bool tasksIdle()
+{
+    if (!uiTask || !radioTask)
+        return false; // HC-12 检测期间不睡眠
+    return !radioBusy && !persistBusy && keypadIdle() &&
+           uxQueueMessagesWaiting(radioTxQueue) == 0 &&
+           uxQueueMessagesWaiting(radioRxQueue) == 0 &&
+           uxQueueMessagesWaiting(inputQueue) == 0 &&
+           uxQueueMessagesWaiting(persistQueue) == 0 &&
+           !hc12.available() && logIdle();
+}
+
+void uiWaitEvent(uint32_t timeoutMs)
+{
+    if (!uiTask)
+    {
+        delay(timeoutMs);
+        return;
+    }
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs));
+}
+
+void uiNotify()
+{
+    if (uiTask)
+        xTaskNotifyGive(uiTask);
+}
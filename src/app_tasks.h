@@ -0,0 +1,86 @@
+// app_tasks.h
+// FreeRTOS 任务划分：无线收发、按键输入、界面/输入法（Arduino loop 任务）与持久化
+//
+//   任务        核心  优先级  职责
+//   radio       0     高      HC-12 串口收帧（UART 空闲中断唤醒）与发送队列；
+//                             发送时加唤醒前导（0x55... STX），接收时去掉
+//   input       1     中      键盘行中断唤醒扫描，带时间戳的按键事件送入队列
+//   loop(UI)    1     低      输入法、界面、RIP；等待事件通知而不是固定 delay
+//   persist     0     最低    把序列化好的内容写入 SPIFFS；飞行记录器的分区擦写
+//
+// 任务之间只通过有界队列交换定长数据；界面状态只在 UI 任务中修改。
+
+#ifndef WM_APP_TASKS_H
+#define WM_APP_TASKS_H
+
+#include <Arduino.h>
+#include "keypad_scan.h"
+
+// 单个无线帧的最大长度（字节）
+constexpr size_t RADIO_FRAME_MAX = 240;
+
+// persistRun() 可携带的数据长度
+constexpr size_t PERSIST_DATA_MAX = 32;
+
+// 帧类型：数据帧经空中收发；AT 帧为发给 HC-12 的 AT 指令（TX）及其响应（RX）
+enum RadioFrameKind : uint8_t
+{
+    RADIO_FRAME_DATA,
+    RADIO_FRAME_AT
+};
+
+// 在无线任务中执行的 AT 作业：arg 为请求携带的参数文本，结果文本写入 resp（含结尾 '\0' 最多 cap 字节），
+// 返回结果长度。用于需要多条 AT 指令或改动本地串口的操作（设置界面）
+typedef size_t (*RadioAtFn)(const char *arg, char *resp, size_t cap);
+
+// 无线帧（RX/TX 队列元素），data 以 '\0' 结尾便于按文本处理
+struct RadioFrame
+{
+    uint16_t len;
+    uint8_t kind;   // RadioFrameKind
+    RadioAtFn atFn; // AT 帧：作业函数，响应帧中原样带回；为空时 data 即 AT 指令（控制台）
+    char data[RADIO_FRAME_MAX + 1];
+};
+
+// 创建队列与键盘、持久化任务；在 setup() 末尾调用（必须在 loop 任务中调用）。
+// 无线任务等到 radioTaskStart() 之后才启动，此前的发送与 AT 指令留在队列中
+void tasksStart();
+
+// HC-12 初始化完成后调用（可在任意任务中、tasksStart() 之前或之后），启动无线任务
+void radioTaskStart();
+
+// 将数据放入发送队列，由无线任务发送；不阻塞，队列满或过长时返回 false
+bool radioSend(const char *data, size_t len);
+
+// 将 AT 指令交给无线任务执行（最长阻塞无线任务 HC12_AT_TIMEOUT_MS），响应以
+// RADIO_FRAME_AT 帧送回 radioReceive()；不阻塞调用者，队列满或过长时返回 false
+bool radioAtCommand(const char *cmd, size_t len);
+
+// 将 AT 作业 fn(arg) 交给无线任务执行，结果以 atFn 为 fn 的 RADIO_FRAME_AT 帧送回 radioReceive()；
+// 不阻塞调用者，队列满或 arg 过长时返回 false
+bool radioAtRun(RadioAtFn fn, const char *arg, size_t len);
+
+// UI 任务取出一帧收到的数据或 AT 响应（按 kind 区分）；无数据时返回 false
+bool radioReceive(RadioFrame &out);
+
+// UI 任务取出一个按键事件（按下/松开/长按重复）；无事件时返回 false
+bool inputReceive(KeyEvent &ev);
+
+// 将 content 写入 path（覆盖），由持久化任务在后台完成；接管 content 的所有权。
+// 任务尚未启动或队列已满时在调用者上下文中同步写入
+void persistWriteFile(const char *path, String *content);
+
+// 在持久化任务中执行 fn(data)，用于擦写 flash 等慢操作；data 被复制进请求（最多 PERSIST_DATA_MAX 字节）。
+// 任务尚未启动或队列已满时在调用者上下文中同步执行；len 过长时返回 false
+bool persistRun(void (*fn)(const void *data), const void *data, size_t len);
+
+// 其它任务是否都已空闲（队列为空、无正在进行的发送/写文件、无按住的键），浅睡眠前检查
+bool tasksIdle();
+
+// UI 任务等待事件（按键、收到数据、串口输入）或超时
+void uiWaitEvent(uint32_t timeoutMs);
+
+// 唤醒 UI 任务（可在任务上下文中调用）
+void uiNotify();
+
+#endif // WM_APP_TASKS_H
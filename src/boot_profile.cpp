@@ -0,0 +1,119 @@
+// boot_profile.cpp
+// 启动分阶段计时实现
+
+#include "boot_profile.h"
+#include "config.h"
+#include "logger.h"
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct BootStageRecord
+{
+    const char *name; // 静态字符串
+    uint32_t startUs;
+    uint32_t endUs; // 0 表示尚未结束
+    uint8_t core;
+};
+
+static const char READY_STAGE[] = "input ready";
+
+static BootStageRecord stages[BOOT_STAGES_MAX];
+static int stageCount = 0;
+static portMUX_TYPE bootLock = portMUX_INITIALIZER_UNLOCKED;
+
+int bootStageBegin(const char *name)
+{
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    int id = -1;
+    portENTER_CRITICAL(&bootLock);
+    if (stageCount < (int)BOOT_STAGES_MAX)
+    {
+        id = stageCount++;
+        stages[id].name = name;
+        stages[id].startUs = now;
+        stages[id].endUs = 0;
+        stages[id].core = (uint8_t)xPortGetCoreID();
+    }
+    portEXIT_CRITICAL(&bootLock);
+    return id;
+}
+
+void bootStageEnd(int stage)
+{
+    if (stage < 0)
+        return;
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    portENTER_CRITICAL(&bootLock);
+    stages[stage].endUs = now ? now : 1;
+    portEXIT_CRITICAL(&bootLock);
+}
+
+void bootMark(const char *name)
+{
+    bootStageEnd(bootStageBegin(name));
+}
+
+void bootMarkReady()
+{
+    bootMark(READY_STAGE);
+}
+
+// 取一份快照，避免输出时与仍在运行的后台阶段竞争
+static int snapshot(BootStageRecord *out)
+{
+    portENTER_CRITICAL(&bootLock);
+    int n = stageCount;
+    memcpy(out, stages, n * sizeof(BootStageRecord));
+    portEXIT_CRITICAL(&bootLock);
+    return n;
+}
+
+// “可输入”里程碑的时刻（毫秒），未到达返回 0
+static uint32_t readyMs(const BootStageRecord *s, int n)
+{
+    for (int i = 0; i < n; i++)
+        if (s[i].name == READY_STAGE)
+            return s[i].startUs / 1000;
+    return 0;
+}
+
+void bootReport()
+{
+    BootStageRecord s[BOOT_STAGES_MAX];
+    int n = snapshot(s);
+    for (int i = 0; i < n; i++)
+    {
+        if (s[i].endUs)
+            LOGI(LM_MAIN, "boot %s: %lu ms from %lu ms (core %u)", s[i].name,
+                 (unsigned long)((s[i].endUs - s[i].startUs) / 1000), (unsigned long)(s[i].startUs / 1000), s[i].core);
+        else
+            LOGI(LM_MAIN, "boot %s: running from %lu ms (core %u)", s[i].name, (unsigned long)(s[i].startUs / 1000),
+                 s[i].core);
+    }
+    uint32_t ready = readyMs(s, n);
+    if (ready > BOOT_TARGET_MS)
+        LOGW(LM_MAIN, "boot: input ready at %lu ms, target %lu ms", (unsigned long)ready,
+             (unsigned long)BOOT_TARGET_MS);
+    else if (ready)
+        LOGI(LM_MAIN, "boot: input ready at %lu ms", (unsigned long)ready);
+}
+
+void bootPrintProfile()
+{
+    BootStageRecord s[BOOT_STAGES_MAX];
+    int n = snapshot(s);
+    Serial.printf("%-14s %4s %8s %8s %8s\n", "stage", "core", "start", "end", "ms");
+    for (int i = 0; i < n; i++)
+    {
+        if (s[i].endUs)
+            Serial.printf("%-14s %4u %8lu %8lu %8lu\n", s[i].name, s[i].core, (unsigned long)(s[i].startUs / 1000),
+                          (unsigned long)(s[i].endUs / 1000), (unsigned long)((s[i].endUs - s[i].startUs) / 1000));
+        else
+            Serial.printf("%-14s %4u %8lu %8s %8s\n", s[i].name, s[i].core, (unsigned long)(s[i].startUs / 1000),
+                          "-", "-");
+    }
+    uint32_t ready = readyMs(s, n);
+    Serial.printf("input ready at %lu ms (target %lu ms, %s boot)\n", (unsigned long)ready,
+                  (unsigned long)BOOT_TARGET_MS, FAST_BOOT ? "fast" : "full");
+}
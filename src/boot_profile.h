@@ -0,0 +1,40 @@
+// boot_profile.h
+// 启动分阶段计时：每个阶段记录起止时刻与所在核，setup() 结束时经日志输出分解表，
+// 控制台 `boot` 可随时重新打印（后台阶段如词库加载完成后也会出现在表中）
+//
+// 时间取自 esp_timer（应用启动后开始计时，不含 ROM 与二级引导程序的时间）。
+// 各阶段可在不同任务中并发记录。
+
+#ifndef WM_BOOT_PROFILE_H
+#define WM_BOOT_PROFILE_H
+
+#include <Arduino.h>
+
+// 开始一个阶段，返回其编号（阶段表满时返回 -1，之后的调用被忽略）
+int bootStageBegin(const char *name);
+void bootStageEnd(int stage);
+
+// 记录一个瞬时里程碑（起止相同）
+void bootMark(const char *name);
+
+// 里程碑“可输入”：键盘任务已启动、loop() 即将开始处理按键
+void bootMarkReady();
+
+// 作用域阶段：构造时开始，析构时结束
+class BootStage
+{
+public:
+    explicit BootStage(const char *name) : stage(bootStageBegin(name)) {}
+    ~BootStage() { bootStageEnd(stage); }
+
+private:
+    int stage;
+};
+
+// 经日志输出分解表，并把“可输入”时刻与 BOOT_TARGET_MS 比较
+void bootReport();
+
+// 同上，直接打印到串口（控制台使用）
+void bootPrintProfile();
+
+#endif // WM_BOOT_PROFILE_H
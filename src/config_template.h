@@ -4,8 +4,8 @@
 
 #include <Arduino.h>
 
-// Enable debug by default; toggle here to disable global debug prints
-#define ENABLE_DEBUG
+// Event tracing ring buffer (trace.h); comment out to compile all trace points away
+#define ENABLE_TRACE
 
 // --- Keyboard / Matrix ---
 constexpr byte ROWS = 4;
@@ -13,11 +13,23 @@ constexpr byte COLS = 4;
 extern byte rowPins[ROWS];
 extern byte colPins[COLS];
 extern char keys[ROWS][COLS];
+constexpr unsigned long KEY_DEBOUNCE_MS = 5;     // 状态变化后复扫间隔（两次一致才接受）
+constexpr unsigned long KEY_SCAN_HELD_MS = 10;   // 有键按住时的扫描周期（检测松开/组合键）
+constexpr unsigned int KEY_SETTLE_US = 5;        // 切换列后等待行电平稳定
 
 // --- HC-12 ---
 // Default baud (may be changed at runtime)
 extern int HC12_BAUD_RATE;
 extern const int HC12_SET_PIN;
+// UART1，引脚经 GPIO 矩阵映射到 16/17。浅睡眠 UART 唤醒只支持 UART0/1，且经典款 ESP32 要求 RX 走 IO_MUX
+// （UART1 只能是 GPIO9，为 flash 引脚），矩阵映射时唤醒 API 返回成功却不会唤醒；因此 power.cpp 在这种情况下
+// 改用 RX 引脚的 GPIO 低电平唤醒
+constexpr int HC12_UART_NUM = 1;
+constexpr int HC12_RX_PIN = 16;
+constexpr int HC12_TX_PIN = 17;
+constexpr size_t HC12_RX_BUFFER_SIZE = 1024;   // 唤醒后任务恢复前的突发数据缓冲
+constexpr size_t HC12_WAKE_PREAMBLE_LEN = 8;   // 每帧前的 0x55 个数（38400bps 约 2ms，覆盖对端浅睡眠唤醒时间）；0 为不加前导
+constexpr int HC12_AT_TIMEOUT_MS = 800;        // 控制台与设置界面 AT 指令等待响应的上限（在无线任务中等待）
 
 // HC-12 instance is declared in main; headers may extern it if needed
 
@@ -26,11 +38,32 @@ extern const int I2C_SDA_PIN;
 extern const int I2C_SCL_PIN;
 
 // --- Display / Timing ---
-constexpr unsigned long DISPLAY_INTERVAL = 80;          // ms
-constexpr unsigned long SLEEP_DISPLAY_INTERVAL = 1000;  // ms
 constexpr unsigned long IDLE_TIMEOUT_MS = 120000;       // ms
 constexpr unsigned long INCOMING_MSG_DISPLAY_MS = 3000; // ms
 
+// --- Low power (see power.h) ---
+constexpr unsigned long LIGHT_SLEEP_MIN_MS = 3;         // 距下一截止时刻太近时不睡
+constexpr unsigned long LIGHT_SLEEP_MAX_MS = 60000;     // 单次浅睡眠上限
+constexpr unsigned long LIGHT_SLEEP_RX_HOLD_MS = 50;    // UART/按键唤醒后保持清醒，等整帧收完
+// 能耗估算用的各状态电流（mA），默认值取自手册典型值，按实测修改；控制台 `power` 查看
+constexpr float POWER_MA_CPU_ACTIVE = 40.0f;   // ESP32 运行（含空闲 WFI）
+constexpr float POWER_MA_CPU_SLEEP = 0.8f;     // 浅睡眠
+constexpr float POWER_MA_DISPLAY_ON = 12.0f;   // SSD1306，与显示内容有关
+constexpr float POWER_MA_DISPLAY_OFF = 0.01f;
+constexpr float POWER_MA_RADIO_RX = 16.0f;     // HC-12 FU3 接收
+constexpr float POWER_MA_RADIO_TX = 100.0f;    // HC-12 最大功率发送
+constexpr float POWER_MA_RADIO_AT = 16.0f;
+constexpr float POWER_MA_RADIO_SLEEP = 0.022f;
+constexpr unsigned long POWER_REPORT_INTERVAL_MS = 600000; // 周期记录能耗摘要到日志；0 为关闭
+
+// --- Deep sleep (see rtc_state.h) ---
+// 低功耗模式再持续该时长后进入深度睡眠，按键唤醒后从 RTC 快照恢复；0 为不自动进入（控制台 `deepsleep`）。
+// 深度睡眠期间 HC-12 也睡眠，节点收不到消息、不参与路由
+constexpr unsigned long DEEP_SLEEP_IDLE_MS = 0;
+constexpr size_t RTC_INPUT_MAX = 160;          // 快照保留的输入内容字节数，超出部分截断
+constexpr size_t RTC_PINYIN_MAX = 15;          // 快照保留的拼音字节数
+constexpr size_t RTC_ROUTES_MAX = 8;           // 快照保留的路由条目数（取最近见到的）
+
 // --- Filesystem ---
 extern const char *HISTORY_FILE;
 extern const char *SETTINGS_FILE;
@@ -40,12 +73,25 @@ extern const char *SETTINGS_FILE;
 constexpr size_t DEFAULT_MAX_MESSAGE_HISTORY = 50;
 constexpr int DEFAULT_CHAT_PAGE_SIZE = 3;
 
+// --- Memory placement (see mem_place.h, msg_history.h) ---
+constexpr size_t HISTORY_MAX_ENTRIES = 500;         // 历史条数上限（设置菜单可调到此值）
+constexpr size_t HISTORY_ARENA_PSRAM = 128 * 1024;  // 有 PSRAM 时的历史正文区：500 条约 250 字节的消息
+constexpr size_t HISTORY_ARENA_INTERNAL = 16 * 1024; // 没有 PSRAM 时退回内部 RAM 的大小
+constexpr uint32_t MEM_BENCH_ROUNDS = 50;           // 控制台 `membench` 每种放置的重复轮数
+
+// --- Pinyin dictionary (see input_method/pinyin_dict.h) ---
+constexpr size_t DICT_CACHE_BLOCKS = 4; // 压缩词库（格式 2）的块缓存槽数（每槽为最大块的大小，约 1.8 KB，内部 RAM）
+
 // --- Chat navigation / UI timing ---
 constexpr unsigned long CHAT_NAV_INITIAL_DELAY = 500;   // ms 首次长按延迟
-constexpr unsigned long CHAT_NAV_REPEAT = 120;          // ms 重复间隔
+constexpr unsigned long CHAT_NAV_REPEAT = 40;           // ms 长按平滑滚动每步间隔
+constexpr unsigned long CHAT_SCROLL_STEP_PX = 8;        // 每步滚动像素（8 的倍数才能由 SSD1315 起始行完成）
 constexpr unsigned long CHAT_NAV_JUMP_THRESHOLD = 1500; // ms 长按阈值，跳到最早/最新
 constexpr unsigned long CHAT_JUMP_MSG_MS = 900;         // 提示显示时长
 constexpr unsigned long RECV_SHORTCUT_WINDOW = 1200;    // ms 快捷按键窗口
+// 键盘长按重复事件（KEY_EV_REPEAT）与聊天长按滚动共用同一节奏
+constexpr unsigned long KEY_REPEAT_DELAY_MS = CHAT_NAV_INITIAL_DELAY;
+constexpr unsigned long KEY_REPEAT_INTERVAL_MS = CHAT_NAV_REPEAT;
 
 // --- Special maps / keymaps ---
 extern const char *specialMap[10];
@@ -65,6 +111,89 @@ extern const char *settingsMenu[];
 extern const int SETTINGS_MENU_COUNT;
 constexpr unsigned long SETTINGS_MSG_MS = 1500;
 
+// --- FreeRTOS tasks (see app_tasks.h) ---
+constexpr unsigned long UI_WAIT_MAX_MS = 1000; // UI 任务单次等待上限（下一截止时刻更早时提前醒来）
+constexpr UBaseType_t RADIO_TASK_PRIO = 5;     // 无线收发（core 0）
+constexpr UBaseType_t INPUT_TASK_PRIO = 3;     // 键盘事件（与 loop 同核，高于 loop 的 1）
+constexpr UBaseType_t PERSIST_TASK_PRIO = 1;   // SPIFFS 写入（core 0）
+constexpr size_t RADIO_RX_QUEUE_LEN = 8;       // 帧
+constexpr size_t RADIO_TX_QUEUE_LEN = 4;       // 帧
+constexpr size_t INPUT_QUEUE_LEN = 16;         // 按键事件
+constexpr size_t PERSIST_QUEUE_LEN = 4;        // 写文件请求
+
+// --- Radio encryption (see radio_crypto.h) ---
+constexpr bool RADIO_ENCRYPT = true;           // false 为明文收发；所有节点须一致
+// 全网共享的 AES-128 主密钥：必须改成自己的随机值，并与所有节点保持一致；
+// 仍为下面的示例密钥（"WM-demo-key-0001"）时固件拒绝加密，以明文收发
+constexpr uint8_t RADIO_KEY[16] = {0x57, 0x4d, 0x2d, 0x64, 0x65, 0x6d, 0x6f, 0x2d,
+                                   0x6b, 0x65, 0x79, 0x2d, 0x30, 0x30, 0x30, 0x31};
+constexpr uint8_t RADIO_NODE_TAG = 0;          // 帧中的节点标签（1..255，全网唯一）；0 为用控制台 `radiotag` 存入 NVS 的值
+constexpr size_t RADIO_REPLAY_PEERS = 8;       // 防重放窗口记录的发送方数
+constexpr uint32_t RADIO_FLOOR_SAVE_MS = 300000; // 防重放下限写 NVS 的最短间隔（断电后这段时间内收到的帧可被重放一次）
+constexpr uint32_t RADIO_RX_REASSEMBLY_MS = 500; // 加密帧收到一半后等待其余字节的最长时间，超时丢弃
+constexpr uint32_t RADIO_SEQ_RESERVE = 256;    // 每次写 NVS 预留的发送计数
+constexpr size_t KEYSTREAM_POOL_FRAMES = 4;    // 预计算密钥流的帧数
+constexpr size_t KEYSTREAM_POOL_BYTES = 64;    // 每帧预计算的密钥流字节（16 的倍数；更长的帧超出部分现算）
+constexpr size_t DUP_CACHE_BUCKETS = 16;       // 重复帧缓存的桶数（2 的幂，见 dup_cache.h）
+constexpr size_t DUP_CACHE_WAYS = 4;           // 每桶记住的帧数；共记住 BUCKETS × WAYS 帧
+constexpr uint32_t CRYPTO_BENCH_ROUNDS = 200;  // 控制台 `cryptobench` 每种负载的轮数
+
+// --- Metrics (see metrics.h) ---
+constexpr uint32_t TELEMETRY_INTERVAL_MS = 0;  // 周期广播 TLM| 遥测帧；0 为关闭（控制台 `stats tlm` 可手动发送）
+
+// --- Heap allocation tracking (see alloc_count.h; 调用点统计只在 WM_ALLOC_COUNT 构建中) ---
+constexpr size_t ALLOC_SITES_MAX = 64;         // 调用点表大小（调用者地址 + 标签）
+constexpr size_t ALLOC_SITES_PRINT = 16;       // `heap` 打印的调用点数
+constexpr unsigned long ALLOC_SAMPLE_MS = 30000; // 空闲堆与最大空闲块采样间隔
+constexpr size_t ALLOC_SAMPLES = 32;           // 保留的采样数
+
+// --- Flight recorder (see flight_rec.h; 需要 partitions.csv 中的 flightrec 分区) ---
+constexpr unsigned long FLIGHT_INTERVAL_S = 60; // 采样间隔；0 为关闭
+
+// --- Stall watchdog (see stall.h) ---
+constexpr uint32_t STALL_BUDGET_MS = 50;       // loop() 单轮耗时超过此值记为一次卡顿
+constexpr size_t STALL_LOG_LEN = 8;            // 内存中保留的卡顿记录条数
+constexpr size_t STALL_DEPTH = 8;              // 插桩区段最大嵌套层数
+
+// --- Boot (see boot_profile.h) ---
+// 快速启动：HC-12 检测与词库加载在 core 0 上与显示、存储初始化并行，跳过开机动画与固定等待；
+// 词库加载完成前拼音输入没有候选词。设为 false 恢复逐步显示进度的完整启动流程
+constexpr bool FAST_BOOT = true;
+constexpr uint32_t BOOT_TARGET_MS = 500;       // 启动到可输入的目标，超出时日志告警
+constexpr size_t BOOT_STAGES_MAX = 16;
+
+// --- Logging (see logger.h) ---
+// 每模块编译期日志级别：0 关闭，1 错误，2 警告，3 信息，4 调试（每个按键、每次候选词查找）
+constexpr uint8_t LOG_LEVEL_MAIN = 3;
+constexpr uint8_t LOG_LEVEL_IME = 3;
+constexpr uint8_t LOG_LEVEL_RADIO = 3;
+constexpr uint8_t LOG_LEVEL_RIP = 3;
+constexpr uint8_t LOG_LEVEL_POWER = 3;
+constexpr uint8_t LOG_LEVEL_CONSOLE = 3;
+constexpr size_t LOG_QUEUE_LEN = 64;           // 记录数（每条 52 字节）；满时丢弃新记录并计数
+constexpr size_t LOG_LINE_MAX = 160;           // 格式化后单行上限，超出截断
+constexpr UBaseType_t LOG_TASK_PRIO = 1;       // 日志输出（core 0）
+
+// --- Tracing (see trace.h) ---
+constexpr size_t TRACE_EVENTS = 512;           // 环形缓冲事件数（每个 12 字节）
+constexpr uint32_t TRACE_ANCHOR_MS = 1000;     // 周期计数器与 esp_timer 重新对齐的间隔
+
+// --- Serial console (see console.h) ---
+constexpr size_t CONSOLE_LINE_MAX = 256;       // 单行命令最大长度，超长整行丢弃
+constexpr int CONSOLE_DUMP_LINES_PER_STEP = 16; // dump 每批打印行数
+constexpr uint32_t CONSOLE_DUMP_STEP_MS = 10;  // dump 批次间隔（期间 UI 照常响应）
+constexpr uint32_t SERIAL_CONSOLE_BAUD = 115200;
+constexpr size_t SERIAL_RX_BUFFER_SIZE = 4096; // 需容纳一个传输窗口（XFER_WINDOW * XFER_CHUNK）
+
+// --- Bulk transfer over USB serial (see serial_xfer.h) ---
+constexpr uint32_t XFER_DEFAULT_BAUD = 921600; // CP2102/CH340 均支持；不稳定时用 `xfer 460800`
+constexpr size_t XFER_CHUNK = 512;             // 每个数据帧的最大负载
+constexpr uint32_t XFER_WINDOW = 6;            // 未确认帧上限（< 256）
+constexpr uint32_t XFER_RESEND_MS = 300;       // 无新确认时从窗口起点重发
+constexpr int XFER_MAX_RETRIES = 10;           // 连续重发次数上限，超过则放弃本次传输
+constexpr uint32_t XFER_IDLE_TIMEOUT_MS = 15000; // 无有效帧则退出传输模式、恢复控制台
+constexpr UBaseType_t XFER_TASK_PRIO = 2;
+
 // Keep additional configuration here as needed
 
 #endif // WM_CONFIG_H
@@ -0,0 +1,588 @@
+// console.cpp
+// 串口控制台实现
+
+#include "console.h"
+#include "config.h"
+#include "logger.h"
+#include "app_tasks.h"
+#include "scheduler.h"
+#include "power.h"
+#include "metrics.h"
+#include "trace.h"
+#include "rip.h"
+#include "serial_xfer.h"
+#include "boot_profile.h"
+#include "stall.h"
+#include "alloc_count.h"
+#include "flight_rec.h"
+#include "msg_history.h"
+#include "radio_crypto.h"
+#include "input_method/pinyin_dict.h"
+#include "input_method/input_method.h"
+#include <vector>
+#include <map>
+#include <strings.h>
+#include <esp_heap_caps.h>
+
+// 定义在 main.cpp
+extern MessageHistory messageHistory;
+extern size_t maxMessageHistory;
+extern int chatPageSize;
+extern bool rcvPersist;
+void showToast(const String &msg);
+void updateLastActivity();
+void drawUI();
+void enterDeepSleep();
+
+static char lineBuf[CONSOLE_LINE_MAX + 1];
+static size_t lineLen = 0;
+static bool lineOverflow = false;
+
+typedef void (*ConsoleHandler)(const char *args);
+
+struct ConsoleCommand
+{
+    const char *name;
+    const char *alias; // 可为 nullptr
+    const char *usage;
+    ConsoleHandler fn;
+};
+
+static void cmdHelp(const char *args);
+static void cmdAt(const char *args);
+static void cmdSend(const char *args);
+static void cmdRoutes(const char *args);
+static void cmdStats(const char *args);
+static void cmdDump(const char *args);
+static void cmdXfer(const char *args);
+static void cmdTrace(const char *args);
+static void cmdBoot(const char *args);
+static void cmdStalls(const char *args);
+static void cmdPower(const char *args);
+static void cmdHeap(const char *args);
+static void cmdFlight(const char *args);
+static void cmdDeepSleep(const char *args);
+static void cmdMemBench(const char *args);
+static void cmdCryptoBench(const char *args);
+static void cmdRekey(const char *args);
+static void cmdRadioTag(const char *args);
+
+static const ConsoleCommand COMMANDS[] = {
+    {"help", "?", "help                      list commands", cmdHelp},
+    {"at", nullptr, "at <AT...>                run AT command on HC-12 (async)", cmdAt},
+    {"send", nullptr, "send <text>               send text over HC-12", cmdSend},
+    {"routes", "?RIP", "routes                    RIP route summary (also RIP?)", cmdRoutes},
+    {"RIP?", nullptr, nullptr, cmdRoutes},
+    {"stats", nullptr, "stats [reset|tlm]         counters and timings; reset, or broadcast a TLM frame", cmdStats},
+    {"dump", nullptr, "dump history|freq|settings  print in-memory data", cmdDump},
+    {"trace", nullptr, "trace [dump|clear|on|off]  event trace ring (tools/trace2chrome.py)", cmdTrace},
+    {"xfer", nullptr, "xfer [baud]               binary file transfer mode (tools/wmxfer.py)", cmdXfer},
+    {"boot", nullptr, "boot                      boot stage timings", cmdBoot},
+    {"stalls", nullptr, "stalls [clear]            recent loop stalls and the section that caused them", cmdStalls},
+    {"power", nullptr, "power [reset]             time in each power state and estimated mAh", cmdPower},
+    {"heap", nullptr, "heap [reset]              allocation sites, allocs per loop, free-block trend (WM_ALLOC_COUNT)", cmdHeap},
+    {"flight", nullptr, "flight [dump|erase]       flight recorder in flash (tools/flight_decode.py)", cmdFlight},
+    {"deepsleep", nullptr, "deepsleep                 save state to RTC memory and deep-sleep until a key press", cmdDeepSleep},
+    {"membench", nullptr, "membench                  lookup latency of the dictionary and history in internal RAM vs PSRAM", cmdMemBench},
+    {"cryptobench", nullptr, "cryptobench               seal/open time per frame, hardware AES vs software AES", cmdCryptoBench},
+    {"rekey", nullptr, "rekey <32 hex digits>     replace the radio key until reboot (every node must use the same key)", cmdRekey},
+    {"radiotag", nullptr, "radiotag [1-255]          show or set this node's unique radio tag (applies after reboot)", cmdRadioTag},
+};
+static const size_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+static void cmdHelp(const char *)
+{
+    for (size_t i = 0; i < COMMAND_COUNT; i++)
+    {
+        if (COMMANDS[i].usage)
+            Serial.println(COMMANDS[i].usage);
+    }
+}
+
+static void cmdAt(const char *args)
+{
+    if (*args == '\0')
+    {
+        Serial.println("usage: at <AT command>");
+        return;
+    }
+    if (!radioAtCommand(args, strlen(args)))
+        Serial.println("ERR: radio busy");
+}
+
+static void cmdSend(const char *args)
+{
+    size_t len = strlen(args);
+    if (len == 0)
+    {
+        Serial.println("usage: send <text>");
+        return;
+    }
+    bool ok = radioSend(args, len);
+    Serial.println(ok ? "OK" : "ERR: radio busy");
+    showToast(String(ok ? "Sent(CMD): " : "SendFail: ") + args);
+    drawUI();
+}
+
+static void cmdRoutes(const char *)
+{
+    String rs = ripGetRoutesSummary();
+    Serial.println(rs);
+    showToast(rs);
+    drawUI();
+}
+
+static void cmdStats(const char *args)
+{
+    if (strcasecmp(args, "reset") == 0)
+    {
+        metricsReset();
+        Serial.println("OK");
+        return;
+    }
+    if (strcasecmp(args, "tlm") == 0)
+    {
+        Serial.println(metricsSendTelemetry() ? "OK" : "ERR: radio busy");
+        return;
+    }
+    metricsPrint();
+    Serial.printf("history %u/%u, freq entries %u\n", (unsigned)messageHistory.size(), (unsigned)maxMessageHistory,
+                  (unsigned)charFrequency.size());
+    powerPrintStats();
+}
+
+// --- dump：按批输出，避免一次写满串口缓冲而阻塞 UI 任务 ---
+
+enum DumpKind
+{
+    DUMP_NONE,
+    DUMP_HISTORY,
+    DUMP_FREQ,
+    DUMP_TRACE,
+    DUMP_FLIGHT
+};
+
+static DumpKind dumpKind = DUMP_NONE;
+static size_t dumpIndex = 0;
+static String dumpLastKey; // freq：按键继续，期间 map 被修改也不会失效
+static SchedId dumpJob = SCHED_INVALID;
+static bool traceWasEnabled = false; // trace：导出期间暂停记录，结束后恢复
+
+static void dumpStep(void *)
+{
+    dumpJob = SCHED_INVALID;
+    int lines = 0;
+    if (dumpKind == DUMP_HISTORY)
+    {
+        while (dumpIndex < messageHistory.size() && lines < CONSOLE_DUMP_LINES_PER_STEP)
+        {
+            Serial.println(messageHistory[dumpIndex++]);
+            lines++;
+        }
+        if (dumpIndex >= messageHistory.size())
+            dumpKind = DUMP_NONE;
+    }
+    else if (dumpKind == DUMP_FREQ)
+    {
+        auto it = dumpIndex == 0 ? charFrequency.begin() : charFrequency.upper_bound(dumpLastKey);
+        for (; it != charFrequency.end() && lines < CONSOLE_DUMP_LINES_PER_STEP; ++it)
+        {
+            Serial.print(it->first);
+            Serial.print(':');
+            Serial.println(it->second);
+            dumpLastKey = it->first;
+            dumpIndex++;
+            lines++;
+        }
+        if (it == charFrequency.end())
+            dumpKind = DUMP_NONE;
+    }
+    else if (dumpKind == DUMP_TRACE)
+    {
+        TraceEvent ev;
+        while (lines < CONSOLE_DUMP_LINES_PER_STEP && traceGet(dumpIndex, ev))
+        {
+            Serial.printf("T %lu %u %c %u %lu\n", (unsigned long)ev.tsUs, ev.core, ev.phase, ev.id,
+                          (unsigned long)ev.arg);
+            dumpIndex++;
+            lines++;
+        }
+        if (dumpIndex >= traceCount())
+        {
+            dumpKind = DUMP_NONE;
+            traceSetEnabled(traceWasEnabled);
+        }
+    }
+    else if (dumpKind == DUMP_FLIGHT)
+    {
+        // 每条记录一行十六进制；写坏的记录跳过
+        FlightRecord r;
+        size_t n = flightCount();
+        for (; dumpIndex < n && lines < CONSOLE_DUMP_LINES_PER_STEP; dumpIndex++)
+        {
+            if (!flightRead(dumpIndex, r))
+                continue;
+            const uint8_t *p = (const uint8_t *)&r;
+            char hex[sizeof(r) * 2 + 1];
+            for (size_t i = 0; i < sizeof(r); i++)
+                snprintf(hex + i * 2, 3, "%02x", p[i]);
+            Serial.print("F ");
+            Serial.println(hex);
+            lines++;
+        }
+        if (dumpIndex >= n)
+            dumpKind = DUMP_NONE;
+    }
+
+    if (dumpKind == DUMP_NONE)
+        Serial.println("-- end --");
+    else
+        dumpJob = schedAfter(CONSOLE_DUMP_STEP_MS, dumpStep);
+}
+
+// 取消进行中的导出
+static void stopDump()
+{
+    schedCancel(dumpJob);
+    dumpJob = SCHED_INVALID;
+    if (dumpKind == DUMP_TRACE)
+        traceSetEnabled(traceWasEnabled);
+    dumpKind = DUMP_NONE;
+}
+
+static void startDump(DumpKind kind)
+{
+    dumpKind = kind;
+    dumpIndex = 0;
+    dumpLastKey = "";
+    dumpStep(nullptr);
+}
+
+static void cmdDump(const char *args)
+{
+    if (strcasecmp(args, "settings") == 0)
+    {
+        Serial.printf("chatPageSize=%d\nmaxMessageHistory=%u\nrcvPersist=%d\nhc12Baud=%d\n", chatPageSize,
+                      (unsigned)maxMessageHistory, rcvPersist ? 1 : 0, HC12_BAUD_RATE);
+        return;
+    }
+
+    DumpKind kind = DUMP_NONE;
+    if (strcasecmp(args, "history") == 0)
+        kind = DUMP_HISTORY;
+    else if (strcasecmp(args, "freq") == 0)
+        kind = DUMP_FREQ;
+    if (kind == DUMP_NONE)
+    {
+        Serial.println("usage: dump history|freq|settings");
+        return;
+    }
+    if (kind == DUMP_FREQ && !dictionaryReady())
+    {
+        Serial.println("ERR: dictionary still loading");
+        return;
+    }
+
+    stopDump();
+    startDump(kind);
+}
+
+static void cmdTrace(const char *args)
+{
+    if (strcasecmp(args, "dump") == 0)
+    {
+        stopDump();
+        traceWasEnabled = traceEnabled();
+        traceSetEnabled(false);
+        // 头部带事件名表，主机工具不需要与固件同步维护 TraceId
+        Serial.printf("TRACE 1 events=%u dropped=%lu names=", (unsigned)traceCount(), (unsigned long)traceDropped());
+        for (uint8_t i = 0; i < TR_COUNT; i++)
+        {
+            if (i)
+                Serial.print(',');
+            Serial.print(traceName(i));
+        }
+        Serial.println();
+        startDump(DUMP_TRACE);
+    }
+    else if (strcasecmp(args, "clear") == 0)
+    {
+        traceClear();
+        Serial.println("OK");
+    }
+    else if (strcasecmp(args, "on") == 0 || strcasecmp(args, "off") == 0)
+    {
+        traceSetEnabled(strcasecmp(args, "on") == 0);
+        Serial.println("OK");
+    }
+    else
+    {
+#ifdef ENABLE_TRACE
+        Serial.printf("trace %s, %u events, %lu dropped\n", traceEnabled() ? "on" : "off", (unsigned)traceCount(),
+                      (unsigned long)traceDropped());
+#else
+        Serial.println("trace compiled out (ENABLE_TRACE)");
+#endif
+    }
+}
+
+static void cmdXfer(const char *args)
+{
+    uint32_t baud = *args ? strtoul(args, nullptr, 10) : XFER_DEFAULT_BAUD;
+    if (baud < 9600 || baud > 2000000)
+    {
+        Serial.println("usage: xfer [baud]");
+        return;
+    }
+    // 主机工具等待这一行，然后切换到新波特率
+    Serial.printf("XFER %lu\n", (unsigned long)baud);
+    if (!xferStart(baud))
+        Serial.println("ERR: xfer not started");
+}
+
+static void cmdBoot(const char *)
+{
+    bootPrintProfile();
+}
+
+static void cmdStalls(const char *args)
+{
+    if (strcasecmp(args, "clear") == 0)
+    {
+        stallClear();
+        Serial.println("OK");
+        return;
+    }
+    stallPrint();
+}
+
+static void cmdPower(const char *args)
+{
+    if (strcasecmp(args, "reset") == 0)
+    {
+        powerEnergyReset();
+        Serial.println("OK");
+        return;
+    }
+    powerPrintEnergy();
+    powerPrintStats();
+}
+
+static void cmdFlight(const char *args)
+{
+    if (!flightAvailable())
+    {
+        Serial.println("ERR: no flightrec partition (see partitions.csv)");
+        return;
+    }
+    if (strcasecmp(args, "dump") == 0)
+    {
+        stopDump();
+        Serial.printf("FLIGHT 1 records=%u interval=%lu size=%u\n", (unsigned)flightCount(),
+                      (unsigned long)FLIGHT_INTERVAL_S, (unsigned)sizeof(FlightRecord));
+        startDump(DUMP_FLIGHT);
+    }
+    else if (strcasecmp(args, "erase") == 0)
+    {
+        flightErase();
+        Serial.println("OK");
+    }
+    else
+    {
+        Serial.printf("flight recorder: %u records, every %lu s\n", (unsigned)flightCount(),
+                      (unsigned long)FLIGHT_INTERVAL_S);
+    }
+}
+
+static void cmdDeepSleep(const char *)
+{
+    if (xferActive())
+    {
+        Serial.println("ERR: file transfer in progress");
+        return;
+    }
+    Serial.println("deep sleep: radio off, press a key to wake");
+    enterDeepSleep();
+}
+
+// 基准在 UI 任务中同步运行（约数百毫秒），期间界面不响应
+static void cmdMemBench(const char *)
+{
+    Serial.printf("psram: %s, free internal %lu, free psram %lu\n", memPsramAvailable() ? "yes" : "no",
+                  (unsigned long)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                  (unsigned long)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    pinyinDictBench(MEM_BENCH_ROUNDS);
+
+    Serial.printf("history: %u messages, %u/%u bytes (loaded in %s)\n", (unsigned)messageHistory.size(),
+                  (unsigned)messageHistory.usedBytes(), (unsigned)messageHistory.arenaBytes(),
+                  memPlaceName(messageHistory.arenaPlace()));
+    if (messageHistory.empty())
+        return;
+    static const MemPlace PLACES[] = {MEM_INTERNAL, MEM_PSRAM};
+    for (MemPlace want : PLACES)
+    {
+        MemPlace got;
+        size_t span = messageHistory.spanBytes();
+        char *copy = (char *)memAlloc(span, want, &got);
+        if (copy && got == want)
+        {
+            memcpy(copy, messageHistory.arenaData(), span);
+            Serial.printf("  arena %-8s  read %5lu ns/message\n", memPlaceName(want),
+                          (unsigned long)messageHistory.benchReadNs(copy, MEM_BENCH_ROUNDS));
+        }
+        else
+        {
+            Serial.printf("  arena %-8s  (not available)\n", memPlaceName(want));
+        }
+        free(copy);
+    }
+}
+
+static void cmdHeap(const char *args)
+{
+    if (strcasecmp(args, "reset") == 0)
+    {
+        allocReset();
+        Serial.println("OK");
+        return;
+    }
+    Serial.printf("heap free %lu, largest block %lu, min free %lu\n", (unsigned long)ESP.getFreeHeap(),
+                  (unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT), (unsigned long)ESP.getMinFreeHeap());
+    allocPrintReport();
+}
+
+// --- 分发 ---
+
+static void dispatchLine(char *line)
+{
+    STALL_SECTION("console");
+    while (*line == ' ')
+        line++;
+    if (*line == '\0')
+        return;
+
+    // 有串口交互，更新活动时间并唤醒
+    updateLastActivity();
+    LOGD(LM_CONSOLE, "cmd %s", logStr(line));
+
+    // 兼容：直接输入的 AT 指令（"AT"、"AT+..."）
+    if ((line[0] == 'A' || line[0] == 'a') && (line[1] == 'T' || line[1] == 't') &&
+        (line[2] == '\0' || line[2] == '+'))
+    {
+        cmdAt(line);
+        return;
+    }
+
+    char *args = line;
+    while (*args && *args != ' ')
+        args++;
+    if (*args)
+    {
+        *args++ = '\0';
+        while (*args == ' ')
+            args++;
+    }
+
+    for (size_t i = 0; i < COMMAND_COUNT; i++)
+    {
+        const ConsoleCommand &c = COMMANDS[i];
+        if (strcasecmp(line, c.name) == 0 || (c.alias && strcasecmp(line, c.alias) == 0))
+        {
+            c.fn(args);
+            return;
+        }
+    }
+    Serial.print("unknown command: ");
+    Serial.print(line);
+    Serial.println(" (try help)");
+}
+
+void consolePoll()
+{
+    if (xferActive())
+        return; // 串口由传输任务独占
+    while (Serial.available())
+    {
+        char c = (char)Serial.read();
+        // 支持回车或换行作为命令结束
+        if (c == '\r' || c == '\n')
+        {
+            if (lineOverflow)
+            {
+                Serial.println("ERR: line too long");
+            }
+            else
+            {
+                lineBuf[lineLen] = '\0';
+                dispatchLine(lineBuf);
+            }
+            lineLen = 0;
+            lineOverflow = false;
+        }
+        else if (lineLen < CONSOLE_LINE_MAX)
+        {
+            lineBuf[lineLen++] = c;
+        }
+        else
+        {
+            lineOverflow = true;
+        }
+    }
+}
+
+void consoleAtResponse(const char *response)
+{
+    Serial.print("AT-> ");
+    Serial.println(response);
+    showToast(String("AT-> ") + response);
+    drawUI();
+}
+
+static void cmdCryptoBench(const char *)
+{
+    cryptoBench(CRYPTO_BENCH_ROUNDS);
+}
+
+static void cmdRekey(const char *args)
+{
+    uint8_t key[16];
+    size_t n = 0;
+    for (const char *p = args; *p && n < sizeof(key) * 2; p++)
+    {
+        if (!isxdigit((unsigned char)*p))
+            break;
+        uint8_t v = isdigit((unsigned char)*p) ? *p - '0' : (tolower((unsigned char)*p) - 'a' + 10);
+        key[n / 2] = (n % 2) ? (uint8_t)(key[n / 2] | v) : (uint8_t)(v << 4);
+        n++;
+    }
+    if (n != sizeof(key) * 2 || args[n] != '\0')
+    {
+        Serial.println("ERR: usage: rekey <32 hex digits>");
+        return;
+    }
+    bool ok = cryptoRekey(key);
+    memset(key, 0, sizeof(key));
+    Serial.println(ok ? "OK" : "ERR: radio encryption disabled, or that is the demo key");
+}
+
+static void cmdRadioTag(const char *args)
+{
+    if (*args == '\0')
+    {
+        Serial.printf("radio tag %u%s\n", cryptoNodeTag(), RADIO_NODE_TAG ? " (RADIO_NODE_TAG)" : "");
+        return;
+    }
+    char *end = nullptr;
+    long tag = strtol(args, &end, 10);
+    if (*end != '\0' || tag < 1 || tag > 255)
+    {
+        Serial.println("ERR: usage: radiotag <1-255>");
+        return;
+    }
+    if (RADIO_NODE_TAG != 0)
+    {
+        Serial.println("ERR: RADIO_NODE_TAG is set in config.h");
+        return;
+    }
+    Serial.println(cryptoSetNodeTag((uint8_t)tag) ? "OK, reboot to apply" : "ERR: NVS write failed");
+}
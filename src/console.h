@@ -0,0 +1,26 @@
+// console.h
+// 串口控制台：按行读取 PC 串口输入，按编译期命令表分发
+//
+//   at <AT指令>        经无线任务异步执行 AT 指令，响应稍后打印（以 "AT" 开头的行可省略 at）
+//   send <文本>        作为数据经 HC-12 发送
+//   routes             打印 RIP 路由摘要（兼容旧命令 ?RIP / RIP?）
+//   stats [reset|tlm]  计数与耗时统计（见 metrics.h）；reset 清零，tlm 立即广播遥测帧
+//   dump history|freq|settings   分批打印当前内存中的数据，不阻塞界面
+//   trace [dump|clear|on|off]   事件追踪（见 trace.h）；dump 输出供 tools/trace2chrome.py 转换
+//   xfer [波特率]      进入二进制文件传输模式（见 serial_xfer.h）
+//   help               命令列表
+//
+// 所有命令都在 UI 任务中执行，且不等待无线模块。
+
+#ifndef WM_CONSOLE_H
+#define WM_CONSOLE_H
+
+#include <Arduino.h>
+
+// 读取串口输入并执行完整的命令行（在 loop() 中调用）
+void consolePoll();
+
+// 无线任务完成 AT 指令后回送的响应（在 loop() 中收到 RADIO_FRAME_AT 时调用）
+void consoleAtResponse(const char *response);
+
+#endif // WM_CONSOLE_H
@@ -1,2 +0,0 @@
-#include "debug.h"
-// 可扩展复杂调试实现，如写入文件、远程输出等
@@ -0,0 +1,57 @@
+// dup_cache.cpp
+// 重复帧缓存实现
+
+#include "dup_cache.h"
+#include "config.h"
+
+static_assert((DUP_CACHE_BUCKETS & (DUP_CACHE_BUCKETS - 1)) == 0, "DUP_CACHE_BUCKETS must be a power of two");
+static_assert(DUP_CACHE_WAYS <= 255, "DUP_CACHE_WAYS must fit in uint8_t");
+
+struct DupBucket
+{
+    uint32_t keys[DUP_CACHE_WAYS];
+    uint8_t used; // 已用槽数
+    uint8_t next; // 下一个替换的槽
+};
+
+static DupBucket buckets[DUP_CACHE_BUCKETS];
+
+// 标签占高 8 位、计数占低 24 位，与空中的 seq 相同
+static uint32_t keyOf(uint8_t source, uint32_t counter)
+{
+    return ((uint32_t)source << 24) | (counter & 0xFFFFFFu);
+}
+
+static DupBucket &bucketOf(uint32_t key)
+{
+    // 乘法哈希取高位：同一节点连续的 seq 分散到不同桶
+    uint32_t h = key * 0x9E3779B1u;
+    return buckets[(h >> 16) & (DUP_CACHE_BUCKETS - 1)];
+}
+
+bool dupSeen(uint8_t source, uint32_t counter)
+{
+    uint32_t key = keyOf(source, counter);
+    const DupBucket &b = bucketOf(key);
+    for (uint8_t i = 0; i < b.used; i++)
+    {
+        if (b.keys[i] == key)
+            return true;
+    }
+    return false;
+}
+
+void dupRemember(uint8_t source, uint32_t counter)
+{
+    uint32_t key = keyOf(source, counter);
+    DupBucket &b = bucketOf(key);
+    b.keys[b.next] = key;
+    b.next = (uint8_t)((b.next + 1) % DUP_CACHE_WAYS);
+    if (b.used < DUP_CACHE_WAYS)
+        b.used++;
+}
+
+void dupClear()
+{
+    memset(buckets, 0, sizeof(buckets));
+}
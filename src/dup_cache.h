@@ -0,0 +1,24 @@
+// dup_cache.h
+// 重复帧缓存：记住最近收到的 (发送方, seq)，同一帧经转发或重传再次到达时在认证与解析之前丢弃。
+//
+// 键为 (发送方节点标签, 24 位发送计数)，取自加密帧头部的 seq（见 radio_crypto.h），整键比较。
+// 只有在标签全网唯一时才没有误判：标签由各节点配置（RADIO_NODE_TAG / `radiotag`），radio_crypto 把
+// 冲突当作硬错误，冲突标签的帧无论是否命中缓存都会丢弃，因此误判不会丢掉本应接收的帧。
+// 哈希到 DUP_CACHE_BUCKETS 个桶，每桶 DUP_CACHE_WAYS 个槽，桶内按先进先出替换；内存固定
+// （16 × 4 时约 300 字节），查找只比较一个桶。丢弃的帧计入 `stats` 的 rx duplicate。
+// 被挤出缓存的旧帧仍由防重放窗口拦截。只在无线任务中访问。
+
+#ifndef WM_DUP_CACHE_H
+#define WM_DUP_CACHE_H
+
+#include <Arduino.h>
+
+// 来自节点标签 source、计数为 counter（低 24 位）的帧最近已记录时返回 true
+bool dupSeen(uint8_t source, uint32_t counter);
+
+// 记录该帧（只记录认证通过的帧，伪造的帧不能挤掉真实记录）
+void dupRemember(uint8_t source, uint32_t counter);
+
+void dupClear();
+
+#endif // WM_DUP_CACHE_H
@@ -0,0 +1,240 @@
+// flight_rec.cpp
+// 飞行记录器实现：分区按 32 字节槽位顺序追加，head 为下一个写入槽位
+//
+// head、count、nextSeq 只在持久化任务（写入/擦除）与 flightInit() 中修改，UI 任务读取时加锁取一致的快照。
+
+#include "flight_rec.h"
+#include "config.h"
+#include "logger.h"
+#include "metrics.h"
+#include "app_tasks.h"
+#include "power.h"
+#include "rip.h"
+#include <esp_partition.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+#include <freertos/FreeRTOS.h>
+
+static_assert(sizeof(FlightRecord) == 32, "FlightRecord layout is shared with tools/flight_decode.py");
+
+static const size_t SECTOR_SIZE = 4096;
+static const size_t SLOTS_PER_SECTOR = SECTOR_SIZE / sizeof(FlightRecord);
+static const uint32_t SEQ_ERASED = 0xFFFFFFFF;
+
+static const esp_partition_t *part = nullptr;
+static size_t slots = 0;
+static size_t head = 0;  // 下一个写入槽位
+static size_t count = 0; // 已写入槽位数（含写坏的）
+static uint32_t nextSeq = 0;
+static uint8_t bootNo = 0;
+static bool firstSample = true;
+static portMUX_TYPE flightLock = portMUX_INITIALIZER_UNLOCKED;
+
+// 采样间的计数快照（UI 任务）
+struct FlightPrev
+{
+    uint32_t ms;
+    uint32_t rxFrames, txFrames, rxLost, txFailed, ripRecv, stalls, energyUah;
+    uint64_t sleepUs;
+};
+static FlightPrev prev;
+
+// 定义在 main.cpp
+extern bool lowPowerMode;
+
+static uint16_t recordCrc(const FlightRecord &r)
+{
+    return (uint16_t)esp_rom_crc32_le(0, (const uint8_t *)&r, offsetof(FlightRecord, crc));
+}
+
+static bool readSlot(size_t slot, FlightRecord &r)
+{
+    return esp_partition_read(part, slot * sizeof(FlightRecord), &r, sizeof(r)) == ESP_OK;
+}
+
+static bool slotErased(const FlightRecord &r)
+{
+    const uint8_t *p = (const uint8_t *)&r;
+    for (size_t i = 0; i < sizeof(r); i++)
+    {
+        if (p[i] != 0xFF)
+            return false;
+    }
+    return true;
+}
+
+static bool recordValid(const FlightRecord &r)
+{
+    return r.seq != SEQ_ERASED && r.crc == recordCrc(r);
+}
+
+bool flightAvailable()
+{
+    return part != nullptr;
+}
+
+void flightInit()
+{
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "flightrec");
+    if (!part || part->size < 2 * SECTOR_SIZE)
+    {
+        part = nullptr;
+        LOGW(LM_MAIN, "flight recorder: no flightrec partition");
+        return;
+    }
+    size_t sectors = part->size / SECTOR_SIZE;
+    slots = sectors * SLOTS_PER_SECTOR;
+
+    // 最新的扇区：首条记录序号最大的已用扇区
+    FlightRecord r;
+    int newest = -1;
+    uint32_t newestSeq = 0;
+    for (size_t s = 0; s < sectors; s++)
+    {
+        if (readSlot(s * SLOTS_PER_SECTOR, r) && recordValid(r) && (newest < 0 || r.seq > newestSeq))
+        {
+            newest = (int)s;
+            newestSeq = r.seq;
+        }
+    }
+    if (newest < 0)
+    {
+        // 空分区（或无法识别的内容：第一次写入时逐扇区擦除）
+        head = 0;
+        count = 0;
+        LOGI(LM_MAIN, "flight recorder: empty, %u slots", (unsigned)slots);
+        return;
+    }
+
+    // 在最新扇区中找到第一个空槽位，并记下最后一条有效记录
+    size_t base = newest * SLOTS_PER_SECTOR;
+    size_t i = 0;
+    FlightRecord last = {};
+    for (; i < SLOTS_PER_SECTOR; i++)
+    {
+        if (!readSlot(base + i, r) || slotErased(r))
+            break;
+        if (recordValid(r))
+            last = r;
+    }
+    head = (base + i) % slots;
+    nextSeq = last.seq + 1;
+    bootNo = last.boot + 1;
+
+    // 最新扇区之后的扇区已用，说明发生过回绕：除最新扇区中的空槽位外都是记录
+    size_t after = ((size_t)newest + 1) % sectors;
+    bool wrapped = readSlot(after * SLOTS_PER_SECTOR, r) && !slotErased(r);
+    count = wrapped ? slots - (SLOTS_PER_SECTOR - i) % SLOTS_PER_SECTOR : base + i;
+    LOGI(LM_MAIN, "flight recorder: %u records, next seq %lu, boot %u", (unsigned)count, (unsigned long)nextSeq,
+         bootNo);
+}
+
+// 在持久化任务中运行：写入一条记录，进入新扇区时先擦除
+static void writeRecord(const void *data)
+{
+    FlightRecord r;
+    memcpy(&r, data, sizeof(r));
+    size_t slot = head;
+    if (slot % SLOTS_PER_SECTOR == 0)
+    {
+        if (esp_partition_erase_range(part, slot * sizeof(FlightRecord), SECTOR_SIZE) != ESP_OK)
+        {
+            LOGW(LM_MAIN, "flight recorder: erase failed at slot %u", (unsigned)slot);
+            return;
+        }
+        portENTER_CRITICAL(&flightLock);
+        if (count > slots - SLOTS_PER_SECTOR)
+            count = slots - SLOTS_PER_SECTOR;
+        portEXIT_CRITICAL(&flightLock);
+    }
+    r.seq = nextSeq;
+    r.crc = recordCrc(r);
+    if (esp_partition_write(part, slot * sizeof(FlightRecord), &r, sizeof(r)) != ESP_OK)
+        LOGW(LM_MAIN, "flight recorder: write failed at slot %u", (unsigned)slot);
+    // 写失败也前移，不在同一槽位上反复编程
+    portENTER_CRITICAL(&flightLock);
+    nextSeq++;
+    head = (slot + 1) % slots;
+    count++;
+    portEXIT_CRITICAL(&flightLock);
+}
+
+static void eraseAll(const void *)
+{
+    if (esp_partition_erase_range(part, 0, slots / SLOTS_PER_SECTOR * SECTOR_SIZE) != ESP_OK)
+        LOGW(LM_MAIN, "flight recorder: erase failed");
+    portENTER_CRITICAL(&flightLock);
+    head = 0;
+    count = 0;
+    portEXIT_CRITICAL(&flightLock);
+}
+
+static uint16_t delta16(uint32_t now, uint32_t &last)
+{
+    // 计数器被 `stats reset` 清零时 now < last，按从零开始计
+    uint32_t d = now >= last ? now - last : now;
+    last = now;
+    return d > 0xFFFF ? 0xFFFF : (uint16_t)d;
+}
+
+static uint16_t units16(size_t bytes)
+{
+    return bytes / 16 > 0xFFFF ? 0xFFFF : (uint16_t)(bytes / 16);
+}
+
+void flightSample()
+{
+    if (!part)
+        return;
+    uint32_t now = millis();
+    uint64_t sleepUs = powerGetStats().sleepUs;
+
+    FlightRecord r = {};
+    r.uptimeS = now / 1000;
+    r.boot = bootNo;
+    r.neighbors = (uint8_t)min(ripRouteCount(), (size_t)0xFF);
+    r.flags = (lowPowerMode ? FLIGHT_F_LOW_POWER : 0) | (firstSample ? FLIGHT_F_BOOT : 0);
+    uint32_t elapsedMs = now - prev.ms;
+    r.sleepPct = elapsedMs && !firstSample ? (uint8_t)min((sleepUs - prev.sleepUs) / 10 / elapsedMs, (uint64_t)100) : 0;
+    r.rxFrames = delta16(metricGet(MC_RX_FRAMES), prev.rxFrames);
+    r.txFrames = delta16(metricGet(MC_TX_FRAMES), prev.txFrames);
+    r.rxLost = delta16(metricGet(MC_RX_DROPPED) + metricGet(MC_RX_GARBLED) + metricGet(MC_UART_OVERRUN) +
+                           metricGet(MC_UART_ERROR),
+                       prev.rxLost);
+    r.txFailed = delta16(metricGet(MC_TX_FAILED), prev.txFailed);
+    r.ripRecv = delta16(metricGet(MC_RIP_RECV), prev.ripRecv);
+    r.stalls = delta16(metricGet(MC_LOOP_STALLS), prev.stalls);
+    r.heapFree = units16(heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    r.heapLargest = units16(heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+    r.energyUah = delta16(powerEnergyUah(), prev.energyUah);
+    prev.ms = now;
+    prev.sleepUs = sleepUs;
+    firstSample = false;
+
+    persistRun(writeRecord, &r, sizeof(r));
+}
+
+size_t flightCount()
+{
+    portENTER_CRITICAL(&flightLock);
+    size_t n = count;
+    portEXIT_CRITICAL(&flightLock);
+    return n;
+}
+
+bool flightRead(size_t i, FlightRecord &out)
+{
+    portENTER_CRITICAL(&flightLock);
+    size_t n = count;
+    size_t h = head;
+    portEXIT_CRITICAL(&flightLock);
+    if (!part || i >= n)
+        return false;
+    return readSlot((h + slots - n + i) % slots, out) && recordValid(out);
+}
+
+void flightErase()
+{
+    if (part)
+        persistRun(eraseAll, nullptr, 0);
+}
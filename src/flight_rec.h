@@ -0,0 +1,60 @@
+// flight_rec.h
+// 飞行记录器：每 FLIGHT_INTERVAL_S 秒采样一次链路与系统指标，追加写入 flash 分区 "flightrec"
+// （partitions.csv）中的环形区域，掉电与重启后保留。控制台 `flight dump` 导出，
+// tools/flight_decode.py 解码为 CSV 并绘图。
+//
+// 磨损：记录只追加写（flash 编程无需擦除），写到新扇区时才擦除该扇区，每轮回绕每个扇区只擦一次；
+// 64 KB 分区、60 s 间隔约保留 34 小时。写入与擦除在持久化任务中完成，不阻塞 UI。
+// 每条记录带序号与 CRC：启动时从序号最大的记录之后接着写，写到一半掉电的记录被跳过。
+// 分区不存在（旧分区表）时记录器不工作，其它功能不受影响。
+
+#ifndef WM_FLIGHT_REC_H
+#define WM_FLIGHT_REC_H
+
+#include <Arduino.h>
+
+// 一条记录（32 字节，小端；tools/flight_decode.py 中的 RECORD 格式与此一致）
+// 计数类字段为本采样周期内的增量（饱和到 0xFFFF）
+struct FlightRecord
+{
+    uint32_t seq;       // 递增序号；0xFFFFFFFF 为擦除态（空）
+    uint32_t uptimeS;   // 本次开机以来的秒数
+    uint8_t boot;       // 启动序号（低 8 位），区分不同次开机
+    uint8_t neighbors;  // 路由表条目数
+    uint8_t flags;      // FLIGHT_F_*
+    uint8_t sleepPct;   // 本周期内 CPU 浅睡眠时间占比
+    uint16_t rxFrames;
+    uint16_t txFrames;
+    uint16_t rxLost;    // 接收队列满丢弃 + 非 UTF-8 丢弃 + UART 溢出/错误
+    uint16_t txFailed;
+    uint16_t ripRecv;   // 收到的 RIP 更新；与邻居数、RIP 周期比较可估算链路丢包
+    uint16_t stalls;    // loop 卡顿次数（stall.h）
+    uint16_t heapFree;  // 内部 RAM 空闲，单位 16 字节
+    uint16_t heapLargest; // 最大空闲块，单位 16 字节
+    uint16_t energyUah; // 本周期估算耗电（power.h）
+    uint16_t crc;       // 前 30 字节 CRC-32 的低 16 位
+};
+
+enum FlightFlags : uint8_t
+{
+    FLIGHT_F_LOW_POWER = 1 << 0, // 低功耗模式（OLED 关闭）
+    FLIGHT_F_BOOT = 1 << 1,      // 开机后的第一条记录
+};
+
+// 查找分区并定位写入位置；在 setup() 中调用（读取每个扇区的首条记录与最新扇区，约 150 次小读取）
+void flightInit();
+
+// 采样一条记录并交给持久化任务写入（UI 任务中周期调用）
+void flightSample();
+
+// 分区中的记录数；取第 i 条（0 为最早），越界或 CRC 错误（写入时掉电）时返回 false
+size_t flightCount();
+bool flightRead(size_t i, FlightRecord &out);
+
+// 擦除整个分区（在持久化任务中进行）
+void flightErase();
+
+// 分区是否可用
+bool flightAvailable();
+
+#endif // WM_FLIGHT_REC_H
@@ -0,0 +1,17 @@
+// font_cjk.h
+// 中文字体选择：构建时由 tools/font_subset.py 从 u8g2_font_wqy12_t_gb2312 裁剪出
+// 只包含词库与界面字符串字形的子集（wm_font_cjk），生成失败时回退到完整字体
+
+#ifndef WM_FONT_CJK_H
+#define WM_FONT_CJK_H
+
+#include <U8g2lib.h>
+
+#ifdef WM_FONT_SUBSET
+extern const uint8_t wm_font_cjk[];
+#define WM_FONT_CJK wm_font_cjk
+#else
+#define WM_FONT_CJK u8g2_font_wqy12_t_gb2312
+#endif
+
+#endif // WM_FONT_CJK_H
@@ -2,10 +2,14 @@
 
 #include <FS.h>
 #include <SPIFFS.h>
-#include <ArduinoJson.h>
 #include <algorithm>
-#include "debug.h"
 #include "config.h"
+#include "app_tasks.h"
+#include "metrics.h"
+#include "trace.h"
+#include "logger.h"
+#include "stall.h"
+#include "pinyin_dict.h"
 
 // 全局状态定义
 InputMode inputMode = MODE_CHS;
@@ -17,9 +21,6 @@ bool composing = false;         // True if in Pinyin composition mode
 
 // keymap and pinyinKeymap are defined in config.cpp and declared in config.h
 
-// 拼音转汉字映射（外部大词库，开机时加载）
-std::map<String, std::vector<String>> py2hz;
-
 // 多字组合相关变量
 std::vector<String> multiCharBuffer; // 存储已组合的字符
 String tempPinyinBuffer = "";        // 临时拼音缓冲区
@@ -33,232 +34,30 @@ unsigned long lastStarTime = 0;
 // 自动学习功能相关变量
 std::map<String, int> charFrequency; // 字符使用频率统计
 
-// 拼音字典加载
+// 词库与字频加载完成（加载任务写入一次，UI 任务读取）
+static bool dictLoaded = false;
+
+void loadDictionaries()
+{
+    loadPinyinDict();
+    loadFrequencyData();
+    __atomic_store_n(&dictLoaded, true, __ATOMIC_RELEASE);
+}
+
+bool dictionaryReady()
+{
+    return __atomic_load_n(&dictLoaded, __ATOMIC_ACQUIRE);
+}
+
+// 拼音词库加载：映射词库分区（必要时先安装 SPIFFS 上的新词库），无需解析
 void loadPinyinDict()
 {
     if (!SPIFFS.begin(true))
     {
-        DEBUG_PRINTLN("SPIFFS Mount Failed");
-        return;
-    }
-
-    File file = SPIFFS.open("/pinyin.json");
-    if (!file)
-    {
-        DEBUG_PRINTLN("Failed to open pinyin.json");
+        LOGE(LM_IME, "SPIFFS mount failed");
         return;
     }
-
-    DEBUG_PRINTLN("Loading JSON pinyin dictionary...");
-    size_t fileSize = file.size();
-    DEBUG_PRINT("File size: ");
-    DEBUG_PRINT(fileSize);
-    DEBUG_PRINTLN(" bytes");
-
-    int loadedCount = 0;
-    int processedEntries = 0;
-
-    // 使用流式解析来处理大JSON文件
-    DEBUG_PRINTLN("Using streaming JSON parser...");
-
-    // 简化的手动JSON解析（避免内存问题）
-    String line;
-    bool inArray = false;
-    bool inObject = false;
-    String currentChar = "";
-    std::vector<String> currentPinyinList;
-
-    while (file.available())
-    {
-        char c = file.read();
-
-        if (c == '\n' || c == '\r')
-        {
-            if (line.length() > 0)
-            {
-                line.trim();
-
-                // 查找字符字段
-                if (line.indexOf("\"char\":") != -1)
-                {
-                    int startPos = line.indexOf("\"char\": \"") + 9;
-                    int endPos = line.indexOf("\"", startPos);
-                    if (startPos > 8 && endPos > startPos)
-                    {
-                        currentChar = line.substring(startPos, endPos);
-                    }
-                }
-
-                // 查找拼音字段
-                if (line.indexOf("\"pinyin\":") != -1)
-                {
-                    currentPinyinList.clear();
-
-                    // 简单解析拼音数组
-                    int arrayStart = line.indexOf("[");
-                    int arrayEnd = line.indexOf("]");
-
-                    if (arrayStart != -1 && arrayEnd != -1 && arrayEnd > arrayStart)
-                    {
-                        String pinyinArrayStr = line.substring(arrayStart + 1, arrayEnd);
-
-                        // 分割拼音
-                        int pos = 0;
-                        while (pos < pinyinArrayStr.length())
-                        {
-                            int quoteStart = pinyinArrayStr.indexOf("\"", pos);
-                            if (quoteStart == -1)
-                                break;
-
-                            int quoteEnd = pinyinArrayStr.indexOf("\"", quoteStart + 1);
-                            if (quoteEnd == -1)
-                                break;
-
-                            String pinyin = pinyinArrayStr.substring(quoteStart + 1, quoteEnd);
-                            currentPinyinList.push_back(pinyin);
-
-                            pos = quoteEnd + 1;
-                        }
-                    }
-                }
-
-                // 检查是否是对象结束
-                if (line.indexOf("}") != -1 && currentChar.length() > 0 && !currentPinyinList.empty())
-                {
-                    // 处理当前字符的所有拼音
-                    for (const String &pinyin : currentPinyinList)
-                    {
-                        // 去除声调，转换为纯字母
-                        String purePinyin = removeTones(pinyin);
-
-                        if (purePinyin.length() > 0)
-                        {
-                            py2hz[purePinyin].push_back(currentChar);
-                            loadedCount++;
-
-                            // 收集调试信息但不立即输出（避免过多输出）
-                        }
-                    }
-
-                    processedEntries++;
-
-                    // 每处理500个条目输出一次进度
-                    if (processedEntries % 500 == 0)
-                    {
-                        DEBUG_PRINT("Processed ");
-                        DEBUG_PRINT(processedEntries);
-                        DEBUG_PRINT(" entries, loaded ");
-                        DEBUG_PRINT(loadedCount);
-                        DEBUG_PRINTLN(" mappings...");
-                    }
-
-                    // 重置当前条目
-                    currentChar = "";
-                    currentPinyinList.clear();
-                }
-
-                line = "";
-            }
-        }
-        else
-        {
-            line += c;
-        }
-    }
-
-    file.close();
-
-    DEBUG_PRINT("Processed ");
-    DEBUG_PRINT(processedEntries);
-    DEBUG_PRINTLN(" JSON entries.");
-
-    DEBUG_PRINT("Loaded ");
-    DEBUG_PRINT(loadedCount);
-    DEBUG_PRINTLN(" pinyin mappings.");
-
-    DEBUG_PRINT("Unique pinyin keys: ");
-    DEBUG_PRINTLN(py2hz.size());
-
-    // 输出一些示例条目供验证
-    DEBUG_PRINTLN("Dictionary sample entries:");
-    int sampleCount = 0;
-    for (auto &pair : py2hz)
-    {
-        if (sampleCount >= 8)
-            break;
-        DEBUG_PRINT("  ");
-        DEBUG_PRINT(pair.first);
-        DEBUG_PRINT(" -> ");
-        DEBUG_PRINT(pair.second[0]);
-        if (pair.second.size() > 1)
-        {
-            DEBUG_PRINT(" (+" + String(pair.second.size() - 1) + " more)");
-        }
-        DEBUG_PRINTLN("");
-        sampleCount++;
-    }
-
-    // 专门检查dong相关的条目
-    DEBUG_PRINTLN("Checking 'dong' related entries:");
-    for (auto &pair : py2hz)
-    {
-        if (pair.first.startsWith("don") || pair.first == "dong")
-        {
-            DEBUG_PRINT("  Found: ");
-            DEBUG_PRINT(pair.first);
-            DEBUG_PRINT(" -> ");
-            DEBUG_PRINT(pair.second[0]);
-            if (pair.second.size() > 1)
-            {
-                DEBUG_PRINT(" (+" + String(pair.second.size() - 1) + " more)");
-            }
-            DEBUG_PRINTLN("");
-        }
-    }
-}
-
-String removeTones(const String &pinyin)
-{
-    String result = "";
-    String input = pinyin;
-
-    input.replace("ā", "a");
-    input.replace("á", "a");
-    input.replace("ǎ", "a");
-    input.replace("à", "a");
-    input.replace("ē", "e");
-    input.replace("é", "e");
-    input.replace("ě", "e");
-    input.replace("è", "e");
-    input.replace("ī", "i");
-    input.replace("í", "i");
-    input.replace("ǐ", "i");
-    input.replace("ì", "i");
-    input.replace("ō", "o");
-    input.replace("ó", "o");
-    input.replace("ǒ", "o");
-    input.replace("ò", "o");
-    input.replace("ū", "u");
-    input.replace("ú", "u");
-    input.replace("ǔ", "u");
-    input.replace("ù", "u");
-    input.replace("ü", "v");
-    input.replace("ǖ", "v");
-    input.replace("ǘ", "v");
-    input.replace("ǚ", "v");
-    input.replace("ǜ", "v");
-    input.replace("ń", "n");
-    input.replace("ň", "n");
-
-    input.replace("ɡ", "g");
-    input.replace("ŋ", "ng");
-    input.replace("ɑ", "a");
-    input.replace("ɨ", "i");
-    input.replace("ɯ", "u");
-
-    input.toLowerCase();
-
-    return input;
+    pinyinDictLoad();
 }
 
 std::vector<std::vector<String>> segmentPinyin(const String &pinyin)
@@ -278,10 +77,9 @@ std::vector<std::vector<String>> segmentPinyin(const String &pinyin)
     {
         for (int j = 0; j < i; j++)
         {
-            String segment = pinyin.substring(j, i);
-
-            if (py2hz.count(segment) > 0)
+            if (pinyinDictFind(pinyin.c_str() + j, i - j) >= 0)
             {
+                String segment = pinyin.substring(j, i);
                 for (auto &prevSegments : dp[j])
                 {
                     std::vector<String> newSegments = prevSegments;
@@ -306,9 +104,11 @@ std::vector<String> generateMultiCharCandidates(const std::vector<std::vector<St
         bool allSegmentsValid = true;
         for (const String &seg : segmentList)
         {
-            if (py2hz.count(seg) > 0)
+            int k = pinyinDictFind(seg.c_str(), seg.length());
+            if (k >= 0)
             {
-                charOptions.push_back(py2hz[seg]);
+                charOptions.push_back(std::vector<String>());
+                pinyinDictHanzi(k, charOptions.back());
             }
             else
             {
@@ -361,76 +161,56 @@ void updateCandidates()
     candidates.clear();
     candidateIndex = 0;
 
-    if (pinyinBuffer.length() == 0)
+    if (pinyinBuffer.length() == 0 || !dictionaryReady())
     {
         return;
     }
+    MetricScope timing(MT_CANDIDATES);
+    TraceScope trace(TR_CANDIDATES);
+    STALL_SECTION("candidates");
 
-    DEBUG_PRINT("[SEARCH] Looking for: '");
-    DEBUG_PRINT(pinyinBuffer);
-    DEBUG_PRINTLN("'");
+    LOGD(LM_IME, "search '%s'", logStr(pinyinBuffer));
 
     std::set<String> uniqueCandidates;
 
-    if (py2hz.count(pinyinBuffer))
+    const char *py = pinyinBuffer.c_str();
+    size_t pyLen = pinyinBuffer.length();
+    std::vector<String> hanzi;
+    int exact = pinyinDictFind(py, pyLen);
+    if (exact >= 0)
     {
-        for (const String &hanzi : py2hz[pinyinBuffer])
-        {
-            uniqueCandidates.insert(hanzi);
-        }
-        DEBUG_PRINT("[EXACT] Found ");
-        DEBUG_PRINT(py2hz[pinyinBuffer].size());
-        DEBUG_PRINTLN(" exact matches");
+        pinyinDictHanzi(exact, hanzi);
+        uniqueCandidates.insert(hanzi.begin(), hanzi.end());
+        LOGD(LM_IME, "%u exact matches", hanzi.size());
     }
     else
     {
-        DEBUG_PRINTLN("[PREFIX] Searching for prefix matches...");
+        // 以输入为前缀的拼音在表中连续排列
         int prefixMatches = 0;
-        for (auto &pair : py2hz)
+        for (size_t k = pinyinDictLowerBound(py, pyLen); pinyinDictHasPrefix(k, py, pyLen); k++)
         {
-            if (pair.first.startsWith(pinyinBuffer))
-            {
-                prefixMatches++;
-                if (prefixMatches <= 3)
-                {
-                    DEBUG_PRINT("  Match: ");
-                    DEBUG_PRINT(pair.first);
-                    DEBUG_PRINT(" -> ");
-                    DEBUG_PRINTLN(pair.second[0]);
-                }
-                for (const String &hanzi : pair.second)
-                {
-                    uniqueCandidates.insert(hanzi);
-                }
-            }
+            prefixMatches++;
+            pinyinDictHanzi(k, hanzi);
         }
+        uniqueCandidates.insert(hanzi.begin(), hanzi.end());
 
         if (prefixMatches == 0 && pinyinBuffer.length() >= 4)
         {
-            DEBUG_PRINTLN("[SEGMENT] Trying multi-character segmentation...");
-
             auto segments = segmentPinyin(pinyinBuffer);
             if (!segments.empty())
             {
-                DEBUG_PRINT("[SEGMENT] Found ");
-                DEBUG_PRINT(segments.size());
-                DEBUG_PRINTLN(" possible segmentations");
-
                 auto multiCandidates = generateMultiCharCandidates(segments);
                 for (const String &candidate : multiCandidates)
                 {
                     uniqueCandidates.insert(candidate);
                 }
 
-                DEBUG_PRINT("[MULTI] Generated ");
-                DEBUG_PRINT(multiCandidates.size());
-                DEBUG_PRINTLN(" multi-character candidates");
+                LOGD(LM_IME, "%u segmentations, %u multi-character candidates", segments.size(),
+                     multiCandidates.size());
             }
         }
 
-        DEBUG_PRINT("[TOTAL] Found ");
-        DEBUG_PRINT(prefixMatches);
-        DEBUG_PRINTLN(" prefix matches");
+        LOGD(LM_IME, "%d prefix matches", prefixMatches);
     }
 
     std::vector<String> rawCandidates;
@@ -445,12 +225,10 @@ void updateCandidates()
 
     candidates = sortCandidatesByFrequency(rawCandidates);
 
-    DEBUG_PRINT("[FINAL] ");
-    DEBUG_PRINT(candidates.size());
-    DEBUG_PRINTLN(" candidates after frequency sorting");
+    LOGD(LM_IME, "%u candidates", candidates.size());
 }
 
-void handlePinyinInput(char key)
+void handlePinyinInput(char key, unsigned long pressMs)
 {
     const char *keyChars = pinyinKeymap[key - '0'];
     int keyCharsLen = strlen(keyChars);
@@ -462,7 +240,8 @@ void handlePinyinInput(char key)
     static unsigned long lastPinyinTime = 0;
     static int pinyinKeyIndex = 0;
 
-    unsigned long now = millis();
+    // 多击判定以按键实际按下时刻为准（不受处理延迟影响）
+    unsigned long now = pressMs;
 
     if (key == lastPinyinKey && (now - lastPinyinTime) < 800)
     {
@@ -486,14 +265,8 @@ void handlePinyinInput(char key)
     updateCandidates();
     composing = true;
 
-    DEBUG_PRINT("[DEBUG] Key: ");
-    DEBUG_PRINT(key);
-    DEBUG_PRINT(", Pinyin: ");
-    DEBUG_PRINT(pinyinBuffer);
-    DEBUG_PRINT(", Candidates: ");
-    DEBUG_PRINT(candidates.size());
-    DEBUG_PRINT(", Selected: ");
-    DEBUG_PRINTLN(candidateIndex);
+    LOGD(LM_IME, "key %c pinyin %s candidates %u selected %d", key, logStr(pinyinBuffer), candidates.size(),
+         candidateIndex);
 }
 
 void commitCandidate()
@@ -505,14 +278,8 @@ void commitCandidate()
 
         updateCharFrequency(selectedChar);
 
-        DEBUG_PRINT("[COMMIT] Selected: ");
-        DEBUG_PRINT(selectedChar);
-        DEBUG_PRINT(", Input buffer: ");
-        DEBUG_PRINTLN(inputBuffer);
-        DEBUG_PRINT("[LEARN] Updated frequency for: ");
-        DEBUG_PRINT(selectedChar);
-        DEBUG_PRINT(" -> ");
-        DEBUG_PRINTLN(charFrequency[selectedChar]);
+        LOGD(LM_IME, "commit %s, frequency %d, input %u bytes", logStr(selectedChar), charFrequency[selectedChar],
+             inputBuffer.length());
 
         pinyinBuffer = "";
         candidates.clear();
@@ -521,7 +288,7 @@ void commitCandidate()
     }
 }
 
-void handleEnglishInput(char key)
+void handleEnglishInput(char key, unsigned long pressMs)
 {
     static char lastKey = 0;
     static unsigned long lastTime = 0;
@@ -532,7 +299,7 @@ void handleEnglishInput(char key)
     if (keyCharsLen == 0)
         return;
 
-    unsigned long now = millis();
+    unsigned long now = pressMs;
 
     if (key == lastKey && (now - lastTime) < 800)
     {
@@ -553,16 +320,17 @@ void handleEnglishInput(char key)
 // 自动学习功能实现
 void loadFrequencyData()
 {
+    TraceScope trace(TR_FLASH_READ);
     if (!SPIFFS.begin(true))
     {
-        Serial.println("[FREQ] SPIFFS not available for frequency data");
+        LOGE(LM_IME, "SPIFFS not available for frequency data");
         return;
     }
 
     File file = SPIFFS.open(FREQ_FILE, "r");
     if (!file)
     {
-        Serial.println("[FREQ] No existing frequency file, starting fresh");
+        LOGI(LM_IME, "no frequency file, starting fresh");
         return;
     }
 
@@ -590,42 +358,29 @@ void loadFrequencyData()
     }
 
     file.close();
-    Serial.print("[FREQ] Loaded ");
-    Serial.print(loadedEntries);
-    Serial.println(" frequency entries");
+    LOGI(LM_IME, "loaded %d frequency entries", loadedEntries);
 }
 
 void saveFrequencyData()
 {
-    if (!SPIFFS.begin(true))
-    {
-        Serial.println("[FREQ] SPIFFS not available for saving");
-        return;
-    }
-
-    File file = SPIFFS.open(FREQ_FILE, "w");
-    if (!file)
-    {
-        Serial.println("[FREQ] Failed to open frequency file for writing");
-        return;
-    }
-
+    STALL_SECTION("save freq");
+    // 在调用者（UI 任务）中序列化，写入 SPIFFS 交给持久化任务
+    String *content = new String();
     int savedEntries = 0;
     for (const auto &pair : charFrequency)
     {
         if (pair.second > 0)
         {
-            file.print(pair.first);
-            file.print(":");
-            file.println(pair.second);
+            *content += pair.first;
+            *content += ":";
+            *content += pair.second;
+            *content += "\r\n";
             savedEntries++;
         }
     }
 
-    file.close();
-    Serial.print("[FREQ] Saved ");
-    Serial.print(savedEntries);
-    Serial.println(" frequency entries");
+    persistWriteFile(FREQ_FILE.c_str(), content);
+    LOGI(LM_IME, "queued %d frequency entries", savedEntries);
 }
 
 void updateCharFrequency(const String &character)
@@ -652,11 +407,7 @@ void updateCharFrequency(const String &character)
         if (minChar.length() > 0 && minFreq < charFrequency[character])
         {
             charFrequency.erase(minChar);
-            Serial.print("[FREQ] Removed low-frequency entry: ");
-            Serial.print(minChar);
-            Serial.print(" (");
-            Serial.print(minFreq);
-            Serial.println(")");
+            LOGD(LM_IME, "evicted low-frequency entry %s (%d)", logStr(minChar), minFreq);
         }
     }
 
@@ -702,18 +453,7 @@ std::vector<String> sortCandidatesByFrequency(const std::vector<String> &rawCand
         sortedCandidates.push_back(pair.first);
     }
 
-    if (sortedCandidates.size() > 0)
-    {
-        Serial.print("[SORT] First 3 candidates by frequency: ");
-        for (int i = 0; i < min(3, (int)sortedCandidates.size()); i++)
-        {
-            Serial.print(sortedCandidates[i]);
-            Serial.print("(");
-            Serial.print(charFrequency.count(sortedCandidates[i]) > 0 ? charFrequency[sortedCandidates[i]] : 0);
-            Serial.print(") ");
-        }
-        Serial.println();
-    }
+    LOGD(LM_IME, "top candidate %s (%d)", logStr(candidatesWithFreq[0].first), candidatesWithFreq[0].second);
 
     return sortedCandidates;
 }
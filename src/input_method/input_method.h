@@ -26,9 +26,6 @@ extern bool composing;                 // True if in Pinyin composition mode
 extern const char *keymap[10];
 extern const char *pinyinKeymap[10];
 
-// 拼音字典映射
-extern std::map<String, std::vector<String>> py2hz;
-
 // 多字组合相关
 extern std::vector<String> multiCharBuffer;
 extern String tempPinyinBuffer;
@@ -45,8 +42,12 @@ extern const String FREQ_FILE;
 extern const int MAX_FREQ_ENTRIES;
 
 // 函数接口
+// 加载二进制拼音词库 /pinyin.bin（见 pinyin_dict.h）
 void loadPinyinDict();
-String removeTones(const String &pinyin);
+// 依次加载拼音词库与字频，完成后 dictionaryReady() 为 true；可在后台任务中调用，
+// 期间 UI 任务不访问 词库 / charFrequency（updateCandidates() 返回空候选）
+void loadDictionaries();
+bool dictionaryReady();
 std::vector<std::vector<String>> segmentPinyin(const String &pinyin);
 std::vector<String> generateMultiCharCandidates(const std::vector<std::vector<String>> &segments);
 void generateCombinations(const std::vector<std::vector<String>> &charOptions,
@@ -54,9 +55,9 @@ void generateCombinations(const std::vector<std::vector<String>> &charOptions,
                           std::vector<String> &results);
 
 void updateCandidates();
-void handlePinyinInput(char key);
+void handlePinyinInput(char key, unsigned long pressMs);
 void commitCandidate();
-void handleEnglishInput(char key);
+void handleEnglishInput(char key, unsigned long pressMs);
 
 // 自动学习功能
 void loadFrequencyData();
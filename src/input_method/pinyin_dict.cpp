@@ -0,0 +1,641 @@
+// pinyin_dict.cpp
+// 二进制拼音词库实现：格式 1 直接在映射上查找；格式 2 分块压缩，按需解压到块缓存
+
+#include "pinyin_dict.h"
+#include <FS.h>
+#include <SPIFFS.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+#include <rom/miniz.h>
+#include "config.h"
+#include "logger.h"
+#include "trace.h"
+#include "mem_place.h"
+#include "utf8.h"
+#include <esp_timer.h>
+
+static const uint32_t DICT_MAGIC = 0x59504D57; // "WMPY"
+static const uint16_t DICT_VERSION_FLAT = 1;
+static const uint16_t DICT_VERSION_PACKED = 2;
+static const char *DICT_PARTITION = "pinyin";
+static const size_t SECTOR_SIZE = 4096;
+
+// 格式 1（不压缩）头部
+struct DictHeaderFlat
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t keyCount;
+    uint32_t hanziBytes;
+    uint32_t crc; // 头部之后全部内容的 CRC-32
+};
+
+// 格式 2（分块压缩）头部
+struct DictHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t keyCount;
+    uint16_t blockCount;
+    uint16_t keysPerBlock;
+    uint16_t maxBlockBytes; // 最大的块解压后的字节数，即每个缓存槽的大小
+    uint16_t reserved;
+    uint32_t dataBytes; // 压缩数据总字节数
+    uint32_t rawBytes;  // 全部块解压后的总字节数
+    uint32_t crc;       // 头部之后全部内容的 CRC-32
+};
+
+// 块索引项（不压缩）：按块首拼音二分即可定位拼音所在的块
+struct DictBlock
+{
+    char first[PINYIN_KEY_MAX + 1];
+    uint32_t offset; // 压缩数据偏移
+    uint16_t packed; // 压缩字节数
+    uint16_t raw;    // 解压字节数
+};
+
+// 块解压后开头的拼音表项，其后为本块的汉字区
+struct DictKey
+{
+    char py[PINYIN_KEY_MAX + 1];
+    uint32_t offset; // 块内汉字区偏移
+    uint16_t count;  // 汉字数
+    uint16_t bytes;  // UTF-8 字节数
+};
+
+static_assert(sizeof(DictHeaderFlat) == 16 && sizeof(DictHeader) == 28 && sizeof(DictBlock) == 16 &&
+                  sizeof(DictKey) == 16,
+              "pinyin.bin layout");
+
+// 两种格式共用的视图：格式 1 当作只有一块、不压缩的词库，blockData() 直接返回 data，不经块缓存。
+// 可能指向 flash 映射或堆，见 pinyin_dict.h
+struct DictView
+{
+    const DictBlock *blocks; // 块索引；格式 1 为 nullptr
+    const uint8_t *data;     // 格式 2 为压缩数据；格式 1 为拼音表（其后为汉字区）
+    size_t count;
+    size_t blockCount;
+    size_t keysPerBlock;
+};
+
+// 两种头部中查找需要的字段
+struct DictInfo
+{
+    uint16_t version;
+    size_t headerBytes;
+    size_t keyCount;
+    size_t blockCount;
+    size_t keysPerBlock;
+    size_t maxBlockBytes; // 格式 1 为 0（不需要块缓存）
+    size_t dataBytes;     // 头部（与块索引）之后的字节数
+    size_t rawBytes;
+    uint32_t crc;
+};
+
+static DictView dict = {nullptr, nullptr, 0, 0, 1};
+static bool dictMapped = false; // true 时 dict 指向分区映射
+static uint8_t *imageBuf = nullptr;
+static MemPlace imagePlace = MEM_INTERNAL;
+static size_t dictBytes = 0;
+static size_t dictHeaderBytes = 0;
+static size_t dictRawBytes = 0;
+static size_t dictDataBytes = 0;
+
+// --- 块缓存（只在 UI 任务中访问，不加锁） ---
+
+struct CacheSlot
+{
+    int block; // -1 为空
+    uint32_t used;
+    uint8_t *buf;
+};
+
+static CacheSlot cache[DICT_CACHE_BLOCKS];
+static uint8_t *cacheBuf = nullptr;
+static size_t cacheSlotBytes = 0;
+static uint32_t cacheClock = 0;
+static uint32_t cacheHits = 0;
+static uint32_t cacheMisses = 0;
+
+static void cacheReset()
+{
+    for (CacheSlot &c : cache)
+        c.block = -1;
+}
+
+// 缓存槽按最大块分配（内部 RAM，查找是热路径）；slotBytes 为 0 时（格式 1）释放
+static bool cacheAlloc(size_t slotBytes)
+{
+    if (cacheBuf && slotBytes != 0 && slotBytes <= cacheSlotBytes)
+    {
+        cacheReset();
+        return true;
+    }
+    free(cacheBuf);
+    cacheBuf = slotBytes ? (uint8_t *)memAlloc(slotBytes * DICT_CACHE_BLOCKS, MEM_INTERNAL) : nullptr;
+    cacheSlotBytes = cacheBuf ? slotBytes : 0;
+    for (size_t i = 0; i < DICT_CACHE_BLOCKS; i++)
+        cache[i].buf = cacheBuf ? cacheBuf + i * slotBytes : nullptr;
+    cacheReset();
+    return cacheBuf || slotBytes == 0;
+}
+
+// 第 b 块解压后的内容；格式 1 直接返回拼音表。未命中时解压到最久未用的槽，失败返回 nullptr
+static const uint8_t *blockData(const DictView &v, size_t b)
+{
+    if (!v.blocks)
+        return v.data;
+    CacheSlot *victim = &cache[0];
+    for (CacheSlot &c : cache)
+    {
+        if (c.block == (int)b)
+        {
+            c.used = ++cacheClock;
+            cacheHits++;
+            return c.buf;
+        }
+        if (c.block < 0 || (victim->block >= 0 && c.used < victim->used))
+            victim = &c;
+    }
+    cacheMisses++;
+
+    const DictBlock &blk = v.blocks[b];
+    if (blk.raw > cacheSlotBytes || blk.offset + blk.packed > dictDataBytes)
+        return nullptr;
+    // ROM tinfl 的状态约 11 KB，只在解压期间占用
+    tinfl_decompressor *inflater = (tinfl_decompressor *)memAlloc(sizeof(tinfl_decompressor), MEM_INTERNAL);
+    if (!inflater)
+    {
+        LOGE(LM_IME, "dictionary: no memory to inflate block %u", b);
+        return nullptr;
+    }
+    size_t in = blk.packed;
+    size_t out = cacheSlotBytes;
+    tinfl_init(inflater);
+    tinfl_status st = tinfl_decompress(inflater, v.data + blk.offset, &in, victim->buf, victim->buf, &out,
+                                       TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+    free(inflater);
+    if (st != TINFL_STATUS_DONE || out != blk.raw)
+    {
+        LOGE(LM_IME, "dictionary: block %u failed to inflate (%d)", b, st);
+        victim->block = -1;
+        return nullptr;
+    }
+    victim->block = (int)b;
+    victim->used = ++cacheClock;
+    return victim->buf;
+}
+
+static size_t keysInBlock(const DictView &v, size_t b)
+{
+    size_t first = b * v.keysPerBlock;
+    return v.count - first < v.keysPerBlock ? v.count - first : v.keysPerBlock;
+}
+
+// 第 i 个拼音的表项（指向块缓存）；hanzi 非空时写入所在块汉字区的起点
+static const DictKey *keyAt(const DictView &v, size_t i, const char **hanzi = nullptr)
+{
+    if (i >= v.count)
+        return nullptr;
+    size_t b = i / v.keysPerBlock;
+    const uint8_t *blk = blockData(v, b);
+    if (!blk)
+        return nullptr;
+    if (hanzi)
+        *hanzi = (const char *)blk + keysInBlock(v, b) * sizeof(DictKey);
+    return (const DictKey *)blk + i % v.keysPerBlock;
+}
+
+// --- 加载 ---
+
+// 解析 raw 开头的头部（avail 为已读到的字节数）到 info。头部合法时返回整个词库的字节数（含头部），
+// 否则返回 0；limit 为所在分区或文件的大小
+static size_t checkHeader(const uint8_t *raw, size_t avail, size_t limit, const char *what, DictInfo &info)
+{
+    DictHeaderFlat f = {};
+    DictHeader h;
+    if (avail >= sizeof(f))
+        memcpy(&f, raw, sizeof(f));
+    if (f.magic != DICT_MAGIC ||
+        (f.version != DICT_VERSION_FLAT && (f.version != DICT_VERSION_PACKED || avail < sizeof(h))))
+    {
+        LOGE(LM_IME, "%s: bad magic or version %u", logStr(what), f.version);
+        return 0;
+    }
+    if (f.version == DICT_VERSION_FLAT)
+    {
+        size_t keyBytes = (size_t)f.keyCount * sizeof(DictKey);
+        info = DictInfo{f.version, sizeof(f), f.keyCount, 1, f.keyCount ? f.keyCount : 1u, 0,
+                        keyBytes + f.hanziBytes, keyBytes + f.hanziBytes, f.crc};
+    }
+    else
+    {
+        memcpy(&h, raw, sizeof(h));
+        if (h.keysPerBlock == 0 || h.blockCount != (h.keyCount + h.keysPerBlock - 1) / h.keysPerBlock)
+        {
+            LOGE(LM_IME, "%s: bad block layout (%u blocks of %u)", logStr(what), h.blockCount, h.keysPerBlock);
+            return 0;
+        }
+        info = DictInfo{h.version,    sizeof(h),       h.keyCount, h.blockCount, h.keysPerBlock,
+                        h.maxBlockBytes, h.dataBytes, h.rawBytes, h.crc};
+        info.headerBytes += (size_t)h.blockCount * sizeof(DictBlock);
+    }
+    size_t total = info.headerBytes + info.dataBytes;
+    if (total > limit)
+    {
+        LOGE(LM_IME, "%s: %u bytes do not fit in %u", logStr(what), total, limit);
+        return 0;
+    }
+    return total;
+}
+
+// CRC 覆盖的部分（格式 2 含块索引）
+static size_t crcStart(const DictInfo &info)
+{
+    return info.version == DICT_VERSION_FLAT ? sizeof(DictHeaderFlat) : sizeof(DictHeader);
+}
+
+// 以 image（头部起）为词库；格式 2 分配块缓存，格式 1 释放它
+static bool useImage(const uint8_t *image, const DictInfo &info)
+{
+    if (!cacheAlloc(info.maxBlockBytes))
+    {
+        LOGE(LM_IME, "dictionary: no memory for %u block cache", info.maxBlockBytes * DICT_CACHE_BLOCKS);
+        return false;
+    }
+    if (info.version == DICT_VERSION_FLAT)
+    {
+        dict = DictView{nullptr, image + info.headerBytes, info.keyCount, 1, info.keysPerBlock};
+    }
+    else
+    {
+        const DictBlock *blocks = (const DictBlock *)(image + sizeof(DictHeader));
+        dict = DictView{blocks, image + info.headerBytes, info.keyCount, info.blockCount, info.keysPerBlock};
+    }
+    dictHeaderBytes = info.headerBytes;
+    dictBytes = info.headerBytes + info.dataBytes;
+    dictRawBytes = info.rawBytes;
+    dictDataBytes = info.dataBytes;
+    return true;
+}
+
+// 把 SPIFFS 上的新词库写入分区后删除该文件；文件不完整或校验不符时保留分区原内容
+static void installFromFile(const esp_partition_t *part, const char *path)
+{
+    TraceScope trace(TR_FLASH_WRITE);
+    File file = SPIFFS.open(path, "r");
+    if (!file)
+        return;
+    size_t size = file.size();
+    uint8_t buf[512];
+    DictInfo info;
+    size_t got = file.read(buf, sizeof(DictHeader));
+    bool ok = checkHeader(buf, got, part->size, path, info) == size && file.seek(crcStart(info));
+
+    // 先完整校验一遍，再擦写分区，避免半个坏词库覆盖好的
+    uint32_t crc = 0;
+    while (ok && file.available())
+    {
+        size_t n = file.read(buf, sizeof(buf));
+        if (n == 0)
+            ok = false;
+        crc = esp_rom_crc32_le(crc, buf, n);
+    }
+    if (ok && crc != info.crc)
+    {
+        LOGE(LM_IME, "%s: checksum mismatch, not installed", logStr(path));
+        ok = false;
+    }
+    if (!ok)
+    {
+        file.close();
+        return;
+    }
+
+    size_t erase = (size + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE;
+    ok = file.seek(0) && esp_partition_erase_range(part, 0, erase) == ESP_OK;
+    for (size_t off = 0; ok && off < size;)
+    {
+        size_t n = file.read(buf, sizeof(buf));
+        ok = n > 0 && esp_partition_write(part, off, buf, n) == ESP_OK;
+        off += n;
+    }
+    file.close();
+    if (!ok)
+    {
+        LOGE(LM_IME, "dictionary install to partition failed");
+        return;
+    }
+    SPIFFS.remove(path);
+    LOGI(LM_IME, "dictionary: installed %s (%u bytes) to partition", logStr(path), size);
+}
+
+// 映射分区并校验；之后经 flash cache 直接读取，不复制（格式 1 连块缓存也不需要）
+static bool mapPartition(const esp_partition_t *part)
+{
+    static esp_partition_mmap_handle_t handle;
+    uint8_t raw[sizeof(DictHeader)];
+    DictInfo info;
+    if (esp_partition_read(part, 0, raw, sizeof(raw)) != ESP_OK)
+        return false;
+    size_t total = checkHeader(raw, sizeof(raw), part->size, DICT_PARTITION, info);
+    if (total == 0)
+        return false;
+    const void *map = nullptr;
+    if (esp_partition_mmap(part, 0, total, ESP_PARTITION_MMAP_DATA, &map, &handle) != ESP_OK)
+    {
+        LOGE(LM_IME, "dictionary: mmap of %u bytes failed", total);
+        return false;
+    }
+    const uint8_t *image = (const uint8_t *)map;
+    size_t start = crcStart(info);
+    if (esp_rom_crc32_le(0, image + start, total - start) != info.crc)
+    {
+        LOGE(LM_IME, "%s: checksum mismatch", logStr(DICT_PARTITION));
+        esp_partition_munmap(handle);
+        return false;
+    }
+    if (!useImage(image, info))
+    {
+        esp_partition_munmap(handle);
+        return false;
+    }
+    dictMapped = true;
+    LOGI(LM_IME, "dictionary: %u pinyin keys, %u bytes (%u unpacked) mapped from partition", dict.count, total,
+         info.rawBytes);
+    return true;
+}
+
+// 没有词库分区时（旧分区表）把整个文件读入内存
+static bool loadFromFile(const char *path)
+{
+    TraceScope trace(TR_FLASH_READ);
+    File file = SPIFFS.open(path, "r");
+    if (!file)
+    {
+        LOGE(LM_IME, "failed to open %s", logStr(path));
+        return false;
+    }
+    size_t size = file.size();
+    uint8_t raw[sizeof(DictHeader)];
+    DictInfo info;
+    bool ok = checkHeader(raw, file.read(raw, sizeof(raw)), size, path, info) == size;
+    if (!ok)
+    {
+        LOGE(LM_IME, "%s: size mismatch (%u bytes)", logStr(path), size);
+        ok = false;
+    }
+
+    uint8_t *image = nullptr;
+    MemPlace place = MEM_INTERNAL;
+    if (ok)
+    {
+        // 格式 2 的压缩数据只在未命中块缓存时读取；格式 1 的拼音表是二分查找的热数据，留在内部 RAM
+        place = info.version == DICT_VERSION_FLAT ? MEM_INTERNAL : MEM_PSRAM;
+        image = (uint8_t *)memAlloc(size, place, &place);
+        ok = image && file.seek(0) && file.read(image, size) == size;
+    }
+    file.close();
+    size_t start = ok ? crcStart(info) : 0;
+    if (ok && esp_rom_crc32_le(0, image + start, size - start) != info.crc)
+    {
+        LOGE(LM_IME, "%s: checksum mismatch", logStr(path));
+        ok = false;
+    }
+    if (!ok || !useImage(image, info))
+    {
+        free(image);
+        return false;
+    }
+
+    free(imageBuf);
+    imageBuf = image;
+    imagePlace = place;
+    LOGI(LM_IME, "dictionary: %u pinyin keys, %u bytes (%u unpacked) in %s", dict.count, size, info.rawBytes,
+         logStr(memPlaceName(place)));
+    return true;
+}
+
+bool pinyinDictLoad(const char *stagePath)
+{
+    if (dictMapped)
+        return true; // 映射在运行期间不变，新词库重启后生效
+    const esp_partition_t *part =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, DICT_PARTITION);
+    if (!part)
+    {
+        LOGW(LM_IME, "no dictionary partition, loading %s into RAM", logStr(stagePath));
+        return loadFromFile(stagePath);
+    }
+    if (SPIFFS.exists(stagePath))
+        installFromFile(part, stagePath);
+    return mapPartition(part);
+}
+
+size_t pinyinDictKeyCount()
+{
+    return dict.count;
+}
+
+size_t pinyinDictBytes()
+{
+    return dictBytes;
+}
+
+// 比较拼音 k（'\0' 填充到 8 字节）与 py[0..len)：<0 k 较小，0 相等，>0 k 较大
+static int compareKey(const char *k, const char *py, size_t len)
+{
+    size_t n = len < PINYIN_KEY_MAX ? len : PINYIN_KEY_MAX;
+    int c = strncmp(k, py, n);
+    if (c != 0)
+        return c;
+    if (len > PINYIN_KEY_MAX)
+        return -1;
+    return k[n] ? 1 : 0;
+}
+
+static size_t lowerBound(const DictView &v, const char *py, size_t len)
+{
+    // 先在块索引中找最后一个块首不大于 py 的块，下界在该块内或恰为下一块的开头（格式 1 只有一块）
+    size_t lo = 0, hi = v.blocks ? v.blockCount : 0;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (compareKey(v.blocks[mid].first, py, len) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (v.blocks && lo == 0)
+        return 0;
+    size_t b = v.blocks ? lo - 1 : 0;
+    const DictKey *keys = (const DictKey *)blockData(v, b);
+    if (!keys)
+        return v.count;
+    lo = 0;
+    hi = keysInBlock(v, b);
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (compareKey(keys[mid].py, py, len) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return b * v.keysPerBlock + lo;
+}
+
+static int find(const DictView &v, const char *py, size_t len)
+{
+    size_t i = lowerBound(v, py, len);
+    const DictKey *k = keyAt(v, i);
+    return k && compareKey(k->py, py, len) == 0 ? (int)i : -1;
+}
+
+size_t pinyinDictLowerBound(const char *py, size_t len)
+{
+    return lowerBound(dict, py, len);
+}
+
+int pinyinDictFind(const char *py, size_t len)
+{
+    return find(dict, py, len);
+}
+
+const char *pinyinDictKey(size_t i)
+{
+    const DictKey *k = keyAt(dict, i);
+    return k ? k->py : "";
+}
+
+bool pinyinDictHasPrefix(size_t i, const char *py, size_t len)
+{
+    if (len > PINYIN_KEY_MAX)
+        return false;
+    const DictKey *k = keyAt(dict, i);
+    return k && strncmp(k->py, py, len) == 0;
+}
+
+size_t pinyinDictHanzi(size_t i, std::vector<String> &out)
+{
+    const char *hanzi = nullptr;
+    const DictKey *k = keyAt(dict, i, &hanzi);
+    if (!k)
+        return 0;
+    const char *p = hanzi + k->offset;
+    size_t n = 0;
+    for (size_t i = 0; i < k->bytes; n++)
+    {
+        size_t next = utf8Next(p, k->bytes, i);
+        out.push_back(String(p + i, next - i));
+        i = next;
+    }
+    return n;
+}
+
+// --- 基准 ---
+
+// 对每个拼音做一次精确查找并逐字节读出其候选字（不构造 String，只测访存与解压），返回每次的平均 ns。
+// cold 时每次查找前清空块缓存，即格式 2 每次都要解压一块
+static uint32_t benchView(const DictView &v, const char *probes, uint32_t rounds, bool cold)
+{
+    volatile uint32_t sink = 0;
+    int64_t t0 = esp_timer_get_time();
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+        for (size_t i = 0; i < v.count; i++)
+        {
+            if (cold)
+                cacheReset();
+            const char *py = probes + i * (PINYIN_KEY_MAX + 1);
+            int k = find(v, py, strnlen(py, PINYIN_KEY_MAX));
+            const char *hanzi = nullptr;
+            const DictKey *key = k < 0 ? nullptr : keyAt(v, k, &hanzi);
+            if (!key)
+            {
+                sink += k;
+                continue;
+            }
+            uint32_t h = 0;
+            for (uint16_t b = 0; b < key->bytes; b++)
+                h += (uint8_t)hanzi[key->offset + b];
+            sink += h;
+        }
+    }
+    int64_t t1 = esp_timer_get_time();
+    (void)sink;
+    return v.count ? (uint32_t)((t1 - t0) * 1000 / ((int64_t)rounds * v.count)) : 0;
+}
+
+void pinyinDictBench(uint32_t rounds)
+{
+    if (dict.count == 0)
+    {
+        Serial.println("dictionary not loaded");
+        return;
+    }
+    bool packed = dict.blocks != nullptr;
+    if (packed)
+    {
+        Serial.printf("dictionary: %u keys in %u blocks of %u, %u bytes (%u unpacked, %u%%), %s\n",
+                      (unsigned)dict.count, (unsigned)dict.blockCount, (unsigned)dict.keysPerBlock,
+                      (unsigned)dictBytes, (unsigned)dictRawBytes,
+                      (unsigned)(dictRawBytes ? dictBytes * 100 / dictRawBytes : 0),
+                      dictMapped ? "flash mmap" : memPlaceName(imagePlace));
+        Serial.printf("block cache: %u x %u bytes, %lu hits, %lu misses\n", (unsigned)DICT_CACHE_BLOCKS,
+                      (unsigned)cacheSlotBytes, (unsigned long)cacheHits, (unsigned long)cacheMisses);
+    }
+    else
+    {
+        Serial.printf("dictionary: %u keys, %u bytes uncompressed, %s\n", (unsigned)dict.count,
+                      (unsigned)dictBytes, dictMapped ? "flash mmap, no copy" : memPlaceName(imagePlace));
+    }
+
+    // 查找串先取出来，避免基准中读拼音本身扰动缓存
+    std::vector<char> probes(dict.count * (PINYIN_KEY_MAX + 1));
+    for (size_t i = 0; i < dict.count; i++)
+        strncpy(&probes[i * (PINYIN_KEY_MAX + 1)], pinyinDictKey(i), PINYIN_KEY_MAX + 1);
+    uint32_t hits = cacheHits, misses = cacheMisses;
+
+    // 词库放在不同位置时的查找延迟；格式 2 分别测每次都解压（cold）与块缓存命中（warm）
+    static const MemPlace PLACES[] = {MEM_INTERNAL, MEM_PSRAM};
+    for (int i = -1; i < (int)(sizeof(PLACES) / sizeof(PLACES[0])); i++)
+    {
+        DictView v = dict;
+        uint8_t *copy = nullptr;
+        const char *name = dictMapped ? "flash" : memPlaceName(imagePlace);
+        if (i >= 0)
+        {
+            MemPlace got;
+            name = memPlaceName(PLACES[i]);
+            copy = (uint8_t *)memAlloc(dictBytes, PLACES[i], &got);
+            if (!copy || got != PLACES[i])
+            {
+                Serial.printf("  data %-8s  (not available)\n", name);
+                free(copy);
+                continue;
+            }
+            const uint8_t *image = dict.data - dictHeaderBytes;
+            memcpy(copy, image, dictBytes);
+            if (packed)
+                v.blocks = (const DictBlock *)(copy + sizeof(DictHeader));
+            v.data = copy + dictHeaderBytes;
+        }
+        if (!packed)
+        {
+            Serial.printf("  data %-8s  find+hanzi %5lu ns\n", name,
+                          (unsigned long)benchView(v, probes.data(), rounds, false));
+            free(copy);
+            continue;
+        }
+        uint32_t coldNs = benchView(v, probes.data(), rounds, true);
+        cacheReset();
+        uint32_t warmNs = benchView(v, probes.data(), rounds, false);
+        Serial.printf("  data %-8s  find+hanzi cold %6lu ns  warm %5lu ns\n", name, (unsigned long)coldNs,
+                      (unsigned long)warmNs);
+        free(copy);
+    }
+    cacheReset();
+    cacheHits = hits;
+    cacheMisses = misses;
+}
@@ -0,0 +1,53 @@
+// pinyin_dict.h
+// 二进制拼音词库：tools/build_dict.py 在构建时由 data/pinyin.json 生成 data/pinyin.bin，
+// 烧写到独立的 flash 数据分区 `pinyin`（见 partitions.csv），开机时用 esp_partition_mmap 映射，无需解析。
+//
+// 格式 1（默认）不压缩：按拼音二分查找直接经 flash cache 读取，不复制、不占 RAM。
+// 格式 2 只在格式 1 放不下分区时（或 build_dict.py --compress yes）使用：按拼音排序后每 32 个拼音为一块，
+// 每块单独用 deflate 压缩，约为原大小的 72%。块索引不压缩：查找先在块索引中二分，只用 ROM 中的 tinfl 解压
+// 命中的一块，再在块内二分。解压后的块放入 DICT_CACHE_BLOCKS 个槽的 LRU 缓存（内部 RAM），
+// tinfl 的约 11 KB 状态只在解压期间临时分配。
+// 格式见 tools/build_dict.py，`python tools/build_dict.py --bench` 在主机上比较不同块大小的压缩率与延迟。
+// 开机只检查头部（魔数、版本、块布局）与 CRC，不符时拒绝加载。块缓存不加锁，只在 UI 任务中查询。
+//
+// 更新词库不必重新烧写固件：`pio run -t uploaddict` 直接写分区；或把新的 pinyin.bin 放到 SPIFFS
+// 根目录（uploadfs、tools/wmxfer.py），下次开机校验后写入分区并删除该文件。
+// 分区表中没有 `pinyin` 分区时退回旧方式：整个文件读入内存（格式 2 有 PSRAM 时放 PSRAM）。
+
+#ifndef WM_PINYIN_DICT_H
+#define WM_PINYIN_DICT_H
+
+#include <Arduino.h>
+#include <vector>
+
+const size_t PINYIN_KEY_MAX = 7; // 无声调拼音最长字节数（表项 8 字节，含结尾 '\0'）
+
+// 映射词库分区；SPIFFS 上有 stagePath 时先将其安装到分区（SPIFFS 需已挂载）。成功返回 true，失败时词库为空
+bool pinyinDictLoad(const char *stagePath = "/pinyin.bin");
+
+size_t pinyinDictKeyCount();
+
+// 词库字节数（含头部与块索引；格式 2 为压缩后）
+size_t pinyinDictBytes();
+
+// 精确查找拼音 py[0..len)，返回拼音表下标，不存在返回 -1
+int pinyinDictFind(const char *py, size_t len);
+
+// 第一个不小于 py[0..len) 的拼音下标；以 py 为前缀的拼音从这里开始连续排列
+size_t pinyinDictLowerBound(const char *py, size_t len);
+
+// 第 i 个拼音（'\0' 结尾）；格式 2 时指向块缓存，下一次词库调用后可能失效
+const char *pinyinDictKey(size_t i);
+
+// 第 i 个拼音是否以 py[0..len) 开头
+bool pinyinDictHasPrefix(size_t i, const char *py, size_t len);
+
+// 把第 i 个拼音的候选字依次追加到 out，返回追加的个数
+size_t pinyinDictHanzi(size_t i, std::vector<String> &out);
+
+// 打印词库格式（格式 2 含压缩率与块缓存命中数），并比较词库在 flash / 内部 SRAM / PSRAM 时的查找延迟
+// （格式 2 分每次解压与缓存命中）
+// （控制台 `membench`）
+void pinyinDictBench(uint32_t rounds);
+
+#endif // WM_PINYIN_DICT_H
@@ -0,0 +1,262 @@
+// keypad_scan.cpp
+// 矩阵键盘中断扫描实现
+//
+// 扫描时逐列拉低（其余列高阻，避免同一行两键同时按下时列与列短路），读取各行电平。
+// 扫描期间列电平变化同样会引起行下降沿，用 scanning 标志让中断忽略这些边沿。
+
+#include "keypad_scan.h"
+#include "config.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <driver/gpio.h>
+#include <driver/rtc_io.h>
+#include <esp_sleep.h>
+
+static const int KEY_COUNT = ROWS * COLS;
+static const int PENDING_MAX = KEY_COUNT * 2;
+static const uint32_t EDGE_MAX_AGE_MS = 50; // 更早的中断时间戳视为过期（例如消抖失败的抖动）
+
+static TaskHandle_t scanTask = nullptr;
+static volatile bool scanning = false;
+static volatile bool edgeSeen = false;
+static volatile uint32_t edgeMs = 0;
+
+static uint32_t stableMask = 0; // 消抖后的按下状态，位 r*COLS+c
+static uint32_t nextRepeat[KEY_COUNT];
+
+// 尚未取走的事件（一次扫描可能同时产生多个）
+static KeyEvent pending[PENDING_MAX];
+static uint8_t pendHead = 0;
+static uint8_t pendTail = 0;
+
+static void IRAM_ATTR rowIsr()
+{
+    if (scanning || !scanTask)
+        return;
+    if (!edgeSeen)
+    {
+        edgeMs = millis();
+        edgeSeen = true;
+    }
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(scanTask, &woken);
+    if (woken)
+        portYIELD_FROM_ISR();
+}
+
+// 空闲状态：所有列输出低电平，任一键按下都会拉低所在行
+static void idleColumns()
+{
+    for (int c = 0; c < COLS; c++)
+    {
+        pinMode(colPins[c], OUTPUT);
+        digitalWrite(colPins[c], LOW);
+    }
+}
+
+static bool anyRowLow()
+{
+    for (int r = 0; r < ROWS; r++)
+    {
+        if (digitalRead(rowPins[r]) == LOW)
+            return true;
+    }
+    return false;
+}
+
+static uint32_t scanMatrix()
+{
+    scanning = true;
+    for (int c = 0; c < COLS; c++)
+        pinMode(colPins[c], INPUT);
+
+    uint32_t mask = 0;
+    for (int c = 0; c < COLS; c++)
+    {
+        pinMode(colPins[c], OUTPUT);
+        digitalWrite(colPins[c], LOW);
+        delayMicroseconds(KEY_SETTLE_US);
+        for (int r = 0; r < ROWS; r++)
+        {
+            if (digitalRead(rowPins[r]) == LOW)
+                mask |= (1UL << (r * COLS + c));
+        }
+        pinMode(colPins[c], INPUT);
+    }
+
+    idleColumns();
+    delayMicroseconds(KEY_SETTLE_US);
+    scanning = false;
+    return mask;
+}
+
+static void pushEvent(int idx, KeyEventType type, uint32_t t)
+{
+    uint8_t next = (uint8_t)((pendHead + 1) % PENDING_MAX);
+    if (next == pendTail)
+        return; // 不会发生：每次扫描每个键最多一个事件
+    pending[pendHead].key = keys[idx / COLS][idx % COLS];
+    pending[pendHead].type = type;
+    pending[pendHead].timeMs = t;
+    pendHead = next;
+}
+
+void keypadScanBegin()
+{
+    scanTask = xTaskGetCurrentTaskHandle();
+    for (int r = 0; r < ROWS; r++)
+        pinMode(rowPins[r], INPUT_PULLUP);
+    idleColumns();
+    for (int r = 0; r < ROWS; r++)
+        attachInterrupt(digitalPinToInterrupt(rowPins[r]), rowIsr, FALLING);
+}
+
+void keypadScanNext(KeyEvent &ev)
+{
+    for (;;)
+    {
+        if (pendTail != pendHead)
+        {
+            ev = pending[pendTail];
+            pendTail = (uint8_t)((pendTail + 1) % PENDING_MAX);
+            return;
+        }
+
+        if (stableMask == 0)
+        {
+            // 无键按下：等待行中断（检查一次电平，避免错过恰在扫描期间按下的键）
+            if (!anyRowLow())
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        else
+        {
+            // 有键按住：周期扫描，并按最近的重复时刻提前醒来
+            uint32_t now = millis();
+            uint32_t waitMs = KEY_SCAN_HELD_MS;
+            for (int i = 0; i < KEY_COUNT; i++)
+            {
+                if (!(stableMask & (1UL << i)))
+                    continue;
+                int32_t left = (int32_t)(nextRepeat[i] - now);
+                if (left < (int32_t)waitMs)
+                    waitMs = left > 0 ? (uint32_t)left : 0;
+            }
+            if (waitMs > 0)
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+        }
+
+        // 状态有变化时隔 KEY_DEBOUNCE_MS 再扫一次，两次一致才接受
+        uint32_t mask = scanMatrix();
+        while (mask != stableMask)
+        {
+            vTaskDelay(pdMS_TO_TICKS(KEY_DEBOUNCE_MS));
+            uint32_t again = scanMatrix();
+            if (again == mask)
+                break;
+            mask = again;
+        }
+
+        uint32_t now = millis();
+        uint32_t pressAt = now;
+        if (edgeSeen)
+        {
+            if (now - edgeMs < EDGE_MAX_AGE_MS)
+                pressAt = edgeMs;
+            edgeSeen = false;
+        }
+
+        uint32_t pressed = mask & ~stableMask;
+        uint32_t released = stableMask & ~mask;
+        for (int i = 0; i < KEY_COUNT; i++)
+        {
+            uint32_t bit = 1UL << i;
+            if (pressed & bit)
+            {
+                pushEvent(i, KEY_EV_PRESS, pressAt);
+                nextRepeat[i] = pressAt + KEY_REPEAT_DELAY_MS;
+            }
+            else if (released & bit)
+            {
+                pushEvent(i, KEY_EV_RELEASE, now);
+            }
+            else if ((mask & bit) && (int32_t)(now - nextRepeat[i]) >= 0)
+            {
+                pushEvent(i, KEY_EV_REPEAT, nextRepeat[i]);
+                nextRepeat[i] += KEY_REPEAT_INTERVAL_MS;
+                // 任务被长时间阻塞时不补发积压的重复事件
+                if ((int32_t)(now - nextRepeat[i]) >= 0)
+                    nextRepeat[i] = now + KEY_REPEAT_INTERVAL_MS;
+            }
+        }
+        stableMask = mask;
+    }
+}
+
+bool keypadIdle()
+{
+    return stableMask == 0 && pendTail == pendHead;
+}
+
+// GPIO 唤醒要求电平触发；若保留中断使能，醒来后按住的键会让低电平中断反复进入。
+// 因此睡眠期间关闭行中断，只保留唤醒使能
+void keypadSleepPrepare()
+{
+    for (int r = 0; r < ROWS; r++)
+    {
+        gpio_num_t pin = (gpio_num_t)rowPins[r];
+        gpio_intr_disable(pin);
+        gpio_wakeup_enable(pin, GPIO_INTR_LOW_LEVEL);
+    }
+}
+
+bool keypadSleepResume()
+{
+    for (int r = 0; r < ROWS; r++)
+    {
+        gpio_num_t pin = (gpio_num_t)rowPins[r];
+        gpio_wakeup_disable(pin);
+        gpio_set_intr_type(pin, GPIO_INTR_NEGEDGE);
+        gpio_intr_enable(pin);
+    }
+    // 唤醒睡眠的按键不会再产生下降沿：直接让输入任务扫描一次
+    bool held = anyRowLow();
+    if (held && scanTask)
+    {
+        edgeMs = millis();
+        edgeSeen = true;
+        xTaskNotifyGive(scanTask);
+    }
+    return held;
+}
+
+void keypadDeepSleepPrepare()
+{
+    uint64_t rowMask = 0;
+    for (int r = 0; r < ROWS; r++)
+    {
+        gpio_num_t pin = (gpio_num_t)rowPins[r];
+        detachInterrupt(digitalPinToInterrupt(rowPins[r]));
+        rtc_gpio_init(pin);
+        rtc_gpio_set_direction(pin, RTC_GPIO_MODE_INPUT_ONLY);
+        rtc_gpio_pullup_dis(pin);
+        rtc_gpio_pulldown_en(pin);
+        rowMask |= 1ULL << rowPins[r];
+    }
+    for (int c = 0; c < COLS; c++)
+    {
+        pinMode(colPins[c], OUTPUT);
+        digitalWrite(colPins[c], HIGH);
+        gpio_hold_en((gpio_num_t)colPins[c]);
+    }
+    // 行下拉属于 RTC 外设，睡眠期间保持供电
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+    esp_sleep_enable_ext1_wakeup(rowMask, ESP_EXT1_WAKEUP_ANY_HIGH);
+}
+
+void keypadDeepSleepRelease()
+{
+    for (int r = 0; r < ROWS; r++)
+        rtc_gpio_deinit((gpio_num_t)rowPins[r]);
+    for (int c = 0; c < COLS; c++)
+        gpio_hold_dis((gpio_num_t)colPins[c]);
+}
@@ -0,0 +1,47 @@
+// keypad_scan.h
+// 4x4 矩阵键盘：行中断触发扫描、消抖，产生带时间戳的按下/松开/重复事件
+//
+// 空闲时所有列输出低电平、行为上拉输入并开启下降沿中断；任一键按下即唤醒输入任务，
+// 中断时刻即为按下事件的时间戳。有键按住期间以 KEY_SCAN_HELD_MS 周期扫描，
+// 用于检测松开、组合键以及生成长按重复事件。
+
+#ifndef WM_KEYPAD_SCAN_H
+#define WM_KEYPAD_SCAN_H
+
+#include <Arduino.h>
+
+enum KeyEventType : uint8_t
+{
+    KEY_EV_PRESS,
+    KEY_EV_RELEASE,
+    KEY_EV_REPEAT
+};
+
+struct KeyEvent
+{
+    char key;          // keys[][] 中的字符
+    KeyEventType type;
+    uint32_t timeMs;   // 事件发生时刻（millis()）：按下为行中断时刻
+};
+
+// 配置矩阵引脚并开启行中断；必须在将要调用 keypadScanNext() 的任务中调用
+void keypadScanBegin();
+
+// 阻塞直到产生下一个事件（在输入任务中循环调用）
+void keypadScanNext(KeyEvent &ev);
+
+// 无键按住（输入任务正阻塞等待行中断）
+bool keypadIdle();
+
+// 浅睡眠前后调用（UI 任务）：睡眠期间行引脚改为低电平唤醒，醒来后恢复下降沿中断并补扫一次。
+// keypadSleepResume() 返回醒来时是否有键按住（区分按键与其它 GPIO 唤醒源）
+void keypadSleepPrepare();
+bool keypadSleepResume();
+
+// 深度睡眠前调用：列输出高电平并保持，行改为 RTC 下拉输入，任一键按下拉高所在行即唤醒（EXT1）。
+// 深度睡眠只有 RTC GPIO 能唤醒，且 EXT1 不支持“任一为低”，因此与浅睡眠时的电平方向相反
+void keypadDeepSleepPrepare();
+// 深度睡眠唤醒后、keypadScanBegin() 之前调用：解除列的保持，行恢复为普通 GPIO
+void keypadDeepSleepRelease();
+
+#endif // WM_KEYPAD_SCAN_H
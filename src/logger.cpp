@@ -0,0 +1,72 @@
+// logger.cpp
+// 日志队列与输出任务
+
+#include "logger.h"
+#include "metrics.h"
+#include "serial_xfer.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+static const char *const MODULE_NAMES[LM_COUNT] = {"main", "ime", "radio", "rip", "power", "console"};
+static const char LEVEL_CHARS[] = "-EWID";
+
+static QueueHandle_t logQueue = nullptr;
+static volatile bool draining = false;
+
+void logSubmit(const LogRecord &r)
+{
+    if (!logQueue || xQueueSend(logQueue, &r, 0) != pdTRUE)
+        metricInc(MC_LOG_DROPPED);
+}
+
+static void logPrint(const LogRecord &r)
+{
+    LogArg v[LOG_MAX_ARGS];
+    for (size_t i = 0; i < LOG_MAX_ARGS; i++)
+        v[i] = (i == r.textSlot) ? (LogArg)r.text : r.args[i];
+
+    char line[LOG_LINE_MAX];
+    int n = snprintf(line, sizeof(line), "[%5lu.%03lu] %c %s: ", (unsigned long)(r.ms / 1000),
+                     (unsigned long)(r.ms % 1000), LEVEL_CHARS[r.level], MODULE_NAMES[r.module]);
+    snprintf(line + n, sizeof(line) - n, r.fmt, v[0], v[1], v[2], v[3]);
+    Serial.println(line);
+}
+
+static void logTaskMain(void *)
+{
+    uint32_t reportedDrops = 0;
+    LogRecord r;
+    for (;;)
+    {
+        if (xQueueReceive(logQueue, &r, portMAX_DELAY) != pdTRUE)
+            continue;
+        draining = true;
+        // 传输模式下串口承载二进制帧，记录先留在队列中
+        while (xferActive())
+            vTaskDelay(pdMS_TO_TICKS(100));
+        uint32_t drops = metricGet(MC_LOG_DROPPED);
+        if (drops < reportedDrops) // stats reset
+            reportedDrops = 0;
+        if (drops != reportedDrops)
+        {
+            Serial.printf("[log] %lu records dropped\n", (unsigned long)(drops - reportedDrops));
+            reportedDrops = drops;
+        }
+        logPrint(r);
+        draining = false;
+    }
+}
+
+void logInit()
+{
+    if (logQueue)
+        return;
+    logQueue = xQueueCreate(LOG_QUEUE_LEN, sizeof(LogRecord));
+    xTaskCreatePinnedToCore(logTaskMain, "log", 3072, nullptr, LOG_TASK_PRIO, nullptr, 0);
+}
+
+bool logIdle()
+{
+    return !logQueue || (uxQueueMessagesWaiting(logQueue) == 0 && !draining);
+}
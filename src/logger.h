@@ -0,0 +1,158 @@
+// logger.h
+// 异步分级日志：调用方只把“格式串指针 + 最多 4 个 32 位参数”写入定长记录并放入队列，
+// 由低优先级的 log 任务格式化后输出到串口；队列满时丢弃新记录并计数（stats 中的 log dropped），
+// 调用方从不等待串口。
+//
+//   LOGI(LM_RIP, "route %s metric %u", logStr(dest), metric);
+//
+// 级别按模块在 config.h 中编译期设定（LOG_LEVEL_*），高于该级别的调用连同参数求值一起被编译掉。
+// 参数限制：
+//   - 整数、枚举、指针；不支持浮点与 64 位整数（编译期报错）
+//   - 格式化发生在之后的 log 任务中，%s 参数必须指向静态存储（字符串字面量、常量表）；
+//     String 或栈上缓冲用 logStr() 拷贝进记录（每条最多一个，超出 LOG_TEXT_MAX - 1 字节截断）
+// 只在任务上下文中调用（不在中断中）。传输模式（serial_xfer）期间暂停输出，记录留在队列中。
+
+#ifndef WM_LOGGER_H
+#define WM_LOGGER_H
+
+#include <Arduino.h>
+#include <type_traits>
+#include "config.h"
+
+enum LogLevel : uint8_t
+{
+    LOG_NONE,
+    LOG_ERROR,
+    LOG_WARN,
+    LOG_INFO,
+    LOG_DEBUG
+};
+
+enum LogModule : uint8_t
+{
+    LM_MAIN,    // 界面与主流程（main.cpp）
+    LM_IME,     // 输入法、词库、字频
+    LM_RADIO,   // 无线任务、HC-12
+    LM_RIP,
+    LM_POWER,
+    LM_CONSOLE, // 串口控制台与传输模式
+    LM_COUNT
+};
+
+constexpr uint8_t LOG_MODULE_LEVELS[LM_COUNT] = {
+    LOG_LEVEL_MAIN, LOG_LEVEL_IME, LOG_LEVEL_RADIO, LOG_LEVEL_RIP, LOG_LEVEL_POWER, LOG_LEVEL_CONSOLE};
+
+constexpr size_t LOG_MAX_ARGS = 4;
+constexpr size_t LOG_TEXT_MAX = 24;
+constexpr uint8_t LOG_NO_TEXT = 0xFF;
+
+typedef uintptr_t LogArg;
+
+struct LogRecord
+{
+    uint32_t ms;
+    const char *fmt;
+    uint8_t module;   // LogModule
+    uint8_t level;    // LogLevel
+    uint8_t textSlot; // 哪个参数位置使用 text，LOG_NO_TEXT 为无
+    uint8_t reserved;
+    LogArg args[LOG_MAX_ARGS];
+    char text[LOG_TEXT_MAX];
+};
+
+// 需要拷贝的字符串参数
+struct LogText
+{
+    const char *s;
+    size_t len;
+};
+
+static inline LogText logStr(const char *s, size_t len) { return LogText{s, len}; }
+static inline LogText logStr(const char *s) { return LogText{s, strlen(s)}; }
+static inline LogText logStr(const String &s) { return LogText{s.c_str(), s.length()}; }
+
+static inline constexpr bool logCompiled(LogModule m, LogLevel l)
+{
+    return l != LOG_NONE && l <= LOG_MODULE_LEVELS[m];
+}
+
+// 创建队列与 log 任务；在 Serial.begin() 之后尽早调用，之前的日志被丢弃并计数
+void logInit();
+
+// 队列为空且 log 任务不在输出中（浅睡眠前检查）
+bool logIdle();
+
+// 放入队列，不阻塞；满则计数丢弃
+void logSubmit(const LogRecord &r);
+
+// --- 记录组装（由宏调用） ---
+
+static inline void logPut(LogRecord &r, uint8_t i, const LogText &t)
+{
+    size_t n = t.len < LOG_TEXT_MAX - 1 ? t.len : LOG_TEXT_MAX - 1;
+    memcpy(r.text, t.s, n);
+    r.text[n] = '\0';
+    r.textSlot = i;
+    r.args[i] = 0;
+}
+
+template <typename T>
+static inline void logPut(LogRecord &r, uint8_t i, T v)
+{
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                  "log arguments must be integers, enums or pointers to static strings; wrap String in logStr()");
+    static_assert(sizeof(T) <= sizeof(LogArg) && !std::is_floating_point<T>::value,
+                  "64-bit and floating point log arguments are not supported");
+    r.args[i] = (LogArg)v;
+}
+
+static inline void logPutArgs(LogRecord &, uint8_t) {}
+
+template <typename T, typename... Rest>
+static inline void logPutArgs(LogRecord &r, uint8_t i, T v, Rest... rest)
+{
+    logPut(r, i, v);
+    logPutArgs(r, i + 1, rest...);
+}
+
+template <typename... Args>
+struct LogTextCount
+{
+    static const int value = 0;
+};
+
+template <typename T, typename... Rest>
+struct LogTextCount<T, Rest...>
+{
+    static const int value = std::is_same<T, LogText>::value + LogTextCount<Rest...>::value;
+};
+
+template <typename... Args>
+void logPost(LogModule m, LogLevel l, const char *fmt, Args... args)
+{
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "at most 4 log arguments");
+    static_assert(LogTextCount<Args...>::value <= 1, "at most one logStr() argument per record");
+    LogRecord r;
+    r.ms = millis();
+    r.fmt = fmt;
+    r.module = m;
+    r.level = l;
+    r.textSlot = LOG_NO_TEXT;
+    r.reserved = 0;
+    logPutArgs(r, 0, args...);
+    logSubmit(r);
+}
+
+#define LOG_AT(mod, lvl, fmt, ...)                          \
+    do                                                      \
+    {                                                       \
+        if (logCompiled(mod, lvl))                          \
+            logPost(mod, lvl, fmt, ##__VA_ARGS__);          \
+    } while (0)
+
+#define LOGE(mod, fmt, ...) LOG_AT(mod, LOG_ERROR, fmt, ##__VA_ARGS__)
+#define LOGW(mod, fmt, ...) LOG_AT(mod, LOG_WARN, fmt, ##__VA_ARGS__)
+#define LOGI(mod, fmt, ...) LOG_AT(mod, LOG_INFO, fmt, ##__VA_ARGS__)
+#define LOGD(mod, fmt, ...) LOG_AT(mod, LOG_DEBUG, fmt, ##__VA_ARGS__)
+
+#endif // WM_LOGGER_H
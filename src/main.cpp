@@ -10,13 +10,13 @@
  */
 
 #include <Arduino.h>
-#include "debug.h" // 调试接口，注释掉可关闭所有调试输出
+#include "logger.h" // 异步日志，各模块级别见 config.h
 #include "config.h"
 
 // 硬件交互相关库
-#include <Keypad.h>
 #include <Wire.h>
 #include <U8g2lib.h>
+#include "font_cjk.h" // 构建时裁剪的中文字体
 #include "HC12_Module.h" // HC-12模块类
 // SPIFFS 用于持久化消息历史与 RCV 设置
 #include <SPIFFS.h>
@@ -36,23 +36,64 @@ HC12Module hc12;
 // OLED实例：使用 config 中定义的 I2C 引脚
 U8G2_SSD1315_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, /* reset=*/U8X8_PIN_NONE, /* clock=*/I2C_SCL_PIN, /* data=*/I2C_SDA_PIN);
 
-// 键盘设置在 `config.h`/`config.cpp` 中集中定义
-Keypad keypad = Keypad(makeKeymap(keys), rowPins, colPins, ROWS, COLS);
+// 键盘引脚与键位在 `config.h`/`config.cpp` 中集中定义，由 keypad_scan 在输入任务中扫描
 
 // 输入法子模块
 #include "input_method/input_method.h"
 // RIP 协议子模块
 #include "rip.h"
+// OLED 差分推送与硬件滚动
+#include "oled_scroll.h"
+// 无线/键盘/持久化任务与队列
+#include "app_tasks.h"
+// 定时任务（RIP、空闲超时、提示到期重绘）
+#include "scheduler.h"
+// 低功耗浅睡眠
+#include "power.h"
+// 串口控制台
+#include "console.h"
+#include "serial_xfer.h"
+// 运行计数与耗时统计
+#include "metrics.h"
+// 可选的堆分配计数（WM_ALLOC_COUNT）
+#include "alloc_count.h"
+// 事件追踪
+#include "trace.h"
+// 启动分阶段计时
+#include "boot_profile.h"
+// 卡顿检测
+#include "stall.h"
+// 飞行记录器
+#include "flight_rec.h"
+// 深度睡眠快照
+#include "rtc_state.h"
+// 消息历史环形区
+#include "msg_history.h"
+#include "utf8.h"
+// 无线帧加密
+#include "radio_crypto.h"
 
 // 前向声明（UI/逻辑辅助）
 void drawUI();
-void handleKeypress(char key);
+void drawUIFrame();
+void handleKeypress(char key, unsigned long pressMs);
+void handleKeyEvent(const KeyEvent &ev);
 void utf8Backspace(String &s);
-// 串口控制台输入处理（按行缓冲）
-void handleSerialConsoleInput();
-
-// 显示刷新节拍
-unsigned long lastDisplayUpdate = 0;
+// 处理无线任务收到的一帧数据
+void handleRadioFrame(const char *msg, size_t len);
+void enterLowPowerMode();
+void enterDeepSleep();
+int chatMaxScrollPx();
+
+// 定时任务：界面不再按固定节拍刷新，只在事件到来或定时到期时重绘
+SchedId ripJob = SCHED_INVALID;    // RIP 老化与周期 UPDATE，按 ripLoop() 返回的下一截止时刻改期
+SchedId idleJob = SCHED_INVALID;   // 空闲超时进入低功耗，每次活动重新计时
+SchedId redrawJob = SCHED_INVALID; // 限时显示内容（提示、T9 表）消失时重绘
+SchedId deepSleepJob = SCHED_INVALID; // 低功耗持续 DEEP_SLEEP_IDLE_MS 后进入深度睡眠
+bool uiDirty = false;              // 本轮 loop 中有状态变化，结束前重绘一次
+// drawUI() 期间记录最早消失的限时内容
+bool uiExpiryValid = false;
+unsigned long uiExpiry = 0;
 
 // 空闲/省电设置 (默认配置在 `config.h`)
 unsigned long lastActivityTime = 0; // 上次交互时间
@@ -62,19 +103,79 @@ bool lowPowerMode = false;
 String incomingMessage = "";
 unsigned long incomingMessageTime = 0;
 
+// 显示短暂提示（INCOMING_MSG_DISPLAY_MS 后自动消失）
+void showToast(const String &msg)
+{
+    incomingMessage = msg;
+    incomingMessageTime = millis();
+}
+
+// 同上；拷入 incomingMessage 已有的缓冲，长度不超过以往时不分配
+void showToast(const char *msg)
+{
+    incomingMessage = msg;
+    incomingMessageTime = millis();
+}
+
+// 限时内容是否仍应显示；若显示则记录其消失时刻，drawUI() 结束后据此安排重绘
+bool uiShowing(unsigned long since, unsigned long duration)
+{
+    unsigned long age = millis() - since;
+    if (age >= duration)
+        return false;
+    unsigned long until = since + duration;
+    if (!uiExpiryValid || (long)(until - uiExpiry) < 0)
+        uiExpiry = until;
+    uiExpiryValid = true;
+    return true;
+}
+
+// 当前字体中码点的字形宽度（像素），供 utf8FitWidth 按屏幕宽度截断
+static int glyphWidth(uint32_t cp, void *)
+{
+    return cp > 0xFFFF ? 0 : u8g2_GetGlyphWidth(u8g2.getU8g2(), (uint16_t)cp);
+}
+
+// 在 maxPx 宽度内用当前字体绘制 UTF-8 文本，放不下时在字符边界截断并以 "..." 结尾
+static void drawUTF8Fit(int x, int y, const char *text, int maxPx)
+{
+    size_t len = strlen(text);
+    if (utf8FitWidth(text, len, maxPx, glyphWidth, nullptr) == len)
+    {
+        u8g2.drawUTF8(x, y, text);
+        return;
+    }
+    char buf[RADIO_FRAME_MAX + 4];
+    size_t n = utf8FitWidth(text, len, maxPx - 3 * glyphWidth('.', nullptr), glyphWidth, nullptr);
+    n = utf8Copy(buf, sizeof(buf) - 3, text, n);
+    memcpy(buf + n, "...", 4);
+    u8g2.drawUTF8(x, y, buf);
+}
+
 // 发送/接收 模式切换：recvMode = true 表示聊天/接收模式，记录历史；false 表示发送模式，收到消息为短暂提示
 bool recvMode = false;
-std::vector<String> messageHistory; // 存储接收/发送历史（简化为 String 列表）
+MessageHistory messageHistory; // 存储接收/发送历史（正文在 PSRAM 环形区，见 msg_history.h）
 // 可配置的历史上限（RCV 设置中可调整并可持久化）
 size_t maxMessageHistory = DEFAULT_MAX_MESSAGE_HISTORY;
 // 聊天分页：chatPage=0 表示最新（最靠近尾部）的页面
 int chatPage = 0;
 // 每页聊天消息数（RCV 模式可配置）
 int chatPageSize = DEFAULT_CHAT_PAGE_SIZE;
+// 聊天视口：按像素滚动，0 表示最新消息贴底显示；翻页即滚动 chatPageSize 行
+int chatScrollPx = 0;
 // 聊天翻页长按支持
-int chatNavDir = 0;            // +1 向更早页（older），-1 向更新页（newer）
-unsigned long chatNavLast = 0; // 上次执行翻页或按下时间
+int chatNavDir = 0;                 // +1 向更早页（older），-1 向更新页（newer）
+unsigned long chatNavPressTime = 0; // 翻页键按下时间（用于跳转阈值）
 char lastChatNavKey = 0;
+// 长按平滑滚动期间聊天占满全屏，使每步只需传输新露出的一页
+bool chatFullscreen = false;
+
+// 聊天区布局（像素）
+const int CHAT_LINE_HEIGHT = 12;     // 行高
+const int CHAT_AREA_TOP = 27;        // 普通模式下聊天区顶端（输入行之下）
+const int CHAT_FIRST_BASELINE = 36;  // 消息不足一屏时第一行基线
+const int CHAT_BOTTOM_BASELINE = 60; // 最新消息贴底时的基线
+const int CHAT_VISIBLE_LINES = 3;    // 普通模式下完整可见的行数
 
 // 跳转确认提示
 String chatJumpMsg = "";
@@ -91,78 +192,23 @@ unsigned long lastRecvShortcutTime = 0;
 
 // 持久化文件路径在 config.h/config.cpp 中定义 (HISTORY_FILE, SETTINGS_FILE)
 
-// 简单 UTF-8 验证：尝试判断字符串是否为合理的 UTF-8（非严格，但能过滤大量乱码）
-bool looksLikeUtf8(const String &s)
-{
-    const char *p = s.c_str();
-    size_t len = s.length();
-    size_t i = 0;
-    while (i < len)
-    {
-        uint8_t c = (uint8_t)p[i];
-        if (c < 0x80)
-        {
-            // ASCII
-            i++;
-        }
-        else if ((c & 0xE0) == 0xC0)
-        {
-            // 2-byte
-            if (i + 1 >= len)
-                return false;
-            uint8_t c1 = (uint8_t)p[i + 1];
-            if ((c1 & 0xC0) != 0x80)
-                return false;
-            i += 2;
-        }
-        else if ((c & 0xF0) == 0xE0)
-        {
-            // 3-byte
-            if (i + 2 >= len)
-                return false;
-            uint8_t c1 = (uint8_t)p[i + 1];
-            uint8_t c2 = (uint8_t)p[i + 2];
-            if (((c1 & 0xC0) != 0x80) || ((c2 & 0xC0) != 0x80))
-                return false;
-            i += 3;
-        }
-        else if ((c & 0xF8) == 0xF0)
-        {
-            // 4-byte
-            if (i + 3 >= len)
-                return false;
-            uint8_t c1 = (uint8_t)p[i + 1];
-            uint8_t c2 = (uint8_t)p[i + 2];
-            uint8_t c3 = (uint8_t)p[i + 3];
-            if (((c1 & 0xC0) != 0x80) || ((c2 & 0xC0) != 0x80) || ((c3 & 0xC0) != 0x80))
-                return false;
-            i += 4;
-        }
-        else
-        {
-            return false;
-        }
-    }
-    return true;
-}
-
 // 保存/加载持久化设置和历史（非常简化：history 为每行消息）
+// 保存时只在 UI 任务中序列化，写入 SPIFFS 交给持久化任务
 void saveHistoryToFS()
 {
-    if (!SPIFFS.begin(true))
-        return;
-    File f = SPIFFS.open(HISTORY_FILE, FILE_WRITE);
-    if (!f)
-        return;
-    for (auto &m : messageHistory)
+    String *content = new String();
+    for (size_t i = 0; i < messageHistory.size(); i++)
     {
-        f.println(m);
+        *content += messageHistory[i];
+        *content += "\r\n";
     }
-    f.close();
+    persistWriteFile(HISTORY_FILE, content);
 }
 
 void loadHistoryFromFS()
 {
+    TraceScope trace(TR_FLASH_READ);
+    STALL_SECTION("load history");
     if (!SPIFFS.begin(true))
         return;
     if (!SPIFFS.exists(HISTORY_FILE))
@@ -176,28 +222,24 @@ void loadHistoryFromFS()
         String line = f.readStringUntil('\n');
         line.trim();
         if (line.length() > 0)
-            messageHistory.push_back(line);
-        if (messageHistory.size() > maxMessageHistory)
-            messageHistory.erase(messageHistory.begin());
+            messageHistory.push(line, maxMessageHistory);
     }
     f.close();
 }
 
 void saveRcvSettings()
 {
-    if (!SPIFFS.begin(true))
-        return;
-    File f = SPIFFS.open(SETTINGS_FILE, FILE_WRITE);
-    if (!f)
-        return;
-    f.println(String(chatPageSize));
-    f.println(String(maxMessageHistory));
-    f.println(String(rcvPersist ? 1 : 0));
-    f.close();
+    String *content = new String();
+    *content += String(chatPageSize) + "\r\n";
+    *content += String((unsigned long)maxMessageHistory) + "\r\n";
+    *content += String(rcvPersist ? 1 : 0) + "\r\n";
+    persistWriteFile(SETTINGS_FILE, content);
 }
 
 void loadRcvSettings()
 {
+    TraceScope trace(TR_FLASH_READ);
+    STALL_SECTION("load settings");
     if (!SPIFFS.begin(true))
         return;
     if (!SPIFFS.exists(SETTINGS_FILE))
@@ -220,9 +262,6 @@ void loadRcvSettings()
     f.close();
 }
 
-// 串口控制台输入缓冲（用于接收来自 PC 的命令行）
-String serialCmdBuffer = "";
-
 // UI 辅助
 int candidateWindowStart = 0; // candidates 显示窗口起始索引
 
@@ -248,94 +287,217 @@ bool inSettings = false; // 是否进入 HC-12 设置界面
 int settingsIndex = 0;   // 当前在设置菜单的索引
 String settingsMsg = ""; // 设置操作返回信息，短暂显示
 unsigned long settingsMsgTime = 0;
+int settingsPending = -1; // 已交给无线任务、等待结果的设置项（-1 为无），期间一直显示 Working...
 // SETTINGS_MSG_MS, settingsMenu and specialMap moved to config.h/config.cpp
 
-// 自动检测 HC-12 当前波特率并配置本地串口（对常见波特率循环发送 AT 检测响应）
-void configureHC12()
+// 检测 HC-12 当前波特率并配置本地串口：先试本地串口当前的波特率，不通再对常见波特率循环发送 AT；
+// 收到 OK 即停止等待。只更新 HC12_BAUD_RATE，不触碰界面状态（快速启动时在启动任务中运行）
+bool configureHC12()
 {
-    const int baudRates[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
+    STALL_SECTION("hc12 detect");
+    static const int baudRates[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
     const int numRates = sizeof(baudRates) / sizeof(baudRates[0]);
+    const int current = hc12.localBaud();
     int foundBaud = -1;
+    char resp[HC12_AT_RESPONSE_MAX];
 
-    for (int i = 0; i < numRates && foundBaud < 0; i++)
+    // i = -1 为当前波特率，无需重配本地串口
+    for (int i = -1; i < numRates && foundBaud < 0; i++)
     {
-        int rate = baudRates[i];
-        Serial.print("[HC12 DETECT] Trying baud: ");
-        Serial.println(rate);
-
-        // 重新配置本地串口到 candidate 波特率
-        hc12.reconfigureLocalSerial(rate);
-        delay(30);
+        int rate = i < 0 ? current : baudRates[i];
+        if (i >= 0)
+        {
+            if (rate == current)
+                continue;
+            // 重新配置本地串口到 candidate 波特率
+            hc12.reconfigureLocalSerial(rate);
+        }
+        LOGD(LM_RADIO, "detect: trying %d baud", rate);
 
         // 发送 AT 检测（sendATCommand 会在必要时进入 AT 模式）
-        String resp = hc12.sendATCommand("AT", 200);
-        resp.trim();
-        Serial.print("[HC12 DETECT] Resp: ");
-        Serial.println(resp);
-
-        String upper = resp;
-        upper.toUpperCase();
-        if (upper.indexOf("OK") >= 0)
-        {
+        hc12.sendATCommand("AT", resp, sizeof(resp), 200, "OK");
+        LOGD(LM_RADIO, "detect: response '%s'", logStr(resp));
+        if (strstr(resp, "OK"))
             foundBaud = rate;
-            break;
-        }
     }
 
     if (foundBaud > 0)
     {
         HC12_BAUD_RATE = foundBaud;
         // 确保本地串口与模块同步
-        hc12.reconfigureLocalSerial(HC12_BAUD_RATE);
-        Serial.print("[HC12 DETECT] Found working baud: ");
-        Serial.println(HC12_BAUD_RATE);
-        incomingMessage = String("HC12 baud:") + String(HC12_BAUD_RATE);
-        incomingMessageTime = millis();
+        if (hc12.localBaud() != foundBaud)
+            hc12.reconfigureLocalSerial(HC12_BAUD_RATE);
+        LOGI(LM_RADIO, "detect: HC-12 at %d baud", HC12_BAUD_RATE);
+        return true;
     }
-    else
+    LOGW(LM_RADIO, "detect: no working baud found, keeping default");
+    return false;
+}
+
+void showBaudToast()
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), "HC12 baud:%d", HC12_BAUD_RATE);
+    showToast(buf);
+}
+
+// 初始化 HC-12 并确认波特率；init() 已在配置的波特率上测试过连接，不通时才扫描其它波特率
+bool initRadio()
+{
+    BootStage stage("hc12");
+    hc12.setRxBufferSize(HC12_RX_BUFFER_SIZE);
+    if (hc12.init(HC12_SET_PIN, HC12_UART_NUM, HC12_RX_PIN, HC12_TX_PIN, HC12_BAUD_RATE))
+    {
+        LOGI(LM_RADIO, "HC-12 initialized at %d baud", HC12_BAUD_RATE);
+        return true;
+    }
+    LOGW(LM_RADIO, "HC-12 not responding at %d baud, scanning", HC12_BAUD_RATE);
+    return configureHC12();
+}
+
+// --- 快速启动：core 0 上的一次性启动任务，与 setup() 中的显示、存储初始化并行 ---
+static volatile bool radioBootOk = false;
+static volatile bool radioBootDone = false; // HC-12 检测结束（无论成败），loop() 据此提示波特率
+static bool resumeBoot = false; // 本次启动从深度睡眠快照恢复
+
+// 检测结束后才启动无线任务；键盘与界面不等待（模块缺失或波特率不对时扫描要好几秒）
+static void bootRadioTaskMain(void *)
+{
+    radioBootOk = initRadio();
+    radioBootDone = true;
+    radioTaskStart();
+    uiNotify();
+    vTaskDelete(nullptr);
+}
+
+// 深度睡眠恢复：HC-12 已按快照中的波特率接管，这里只把它从 AT+SLEEP 中唤醒，不阻塞首帧
+static void bootWakeRadioTaskMain(void *)
+{
+    {
+        BootStage stage("hc12 wake");
+        hc12.wake();
+    }
+    vTaskDelete(nullptr);
+}
+
+static void loadDictionaryStage()
+{
+    BootStage stage("dictionary");
+    loadDictionaries();
+}
+
+// 词库加载不阻塞启动：完成前拼音输入没有候选词，完成后通知 UI 任务刷新候选
+static void bootDictTaskMain(void *)
+{
+    loadDictionaryStage();
+    uiNotify();
+    vTaskDelete(nullptr);
+}
+
+// 低功耗持续足够久：各任务空闲时进入深度睡眠，否则稍后再试
+void deepSleepJobRun(void *)
+{
+    if (tasksIdle() && !xferActive())
     {
-        Serial.println("[HC12 DETECT] No working baud found, keep default.");
+        enterDeepSleep();
+        return;
     }
+    schedReschedule(deepSleepJob, 1000);
 }
 
 // 更新最后活动时间；如果处于低功耗则唤醒
+void idleTimeoutJob(void *)
+{
+    idleJob = SCHED_INVALID;
+    enterLowPowerMode();
+    uiDirty = true;
+    if (DEEP_SLEEP_IDLE_MS > 0)
+        deepSleepJob = schedAfter(DEEP_SLEEP_IDLE_MS, deepSleepJobRun);
+}
+
 void updateLastActivity()
 {
     lastActivityTime = millis();
+    // 空闲超时重新计时
+    schedCancel(idleJob);
+    schedCancel(deepSleepJob);
+    deepSleepJob = SCHED_INVALID;
+    idleJob = schedAfter(IDLE_TIMEOUT_MS, idleTimeoutJob);
     if (lowPowerMode)
     {
-        // 唤醒流程：恢复 OLED，退出 HC-12 睡眠
+        // 唤醒流程：HC-12 一直在接收，只需恢复 OLED
         lowPowerMode = false;
-        // 唤醒 HC-12（切换到通信模式并重设本地串口）
-        hc12.setMode(HC12Module::COMM_MODE);
-        hc12.reconfigureLocalSerial(HC12_BAUD_RATE);
-        // 打开显示
         u8g2.setPowerSave(false);
-        // 给模块一点时间
-        delay(60);
-        // 恢复显示并提示
-        incomingMessage = "Woke from sleep";
-        incomingMessageTime = millis();
+        powerSetDisplayOn(true);
+        powerPrintStats();
+        showToast("Woke from sleep");
         drawUI();
     }
 }
 
-// 进入低功耗模式：关闭 OLED 显示并让 HC-12 进入睡眠（AT+SLEEP）
+// 进入低功耗模式：关闭 OLED，之后 loop() 在空闲时让 ESP32 浅睡眠。
+// HC-12 保持接收（不再发送 AT+SLEEP），收到数据即由 UART 唤醒
 void enterLowPowerMode()
 {
     if (lowPowerMode)
         return;
     lowPowerMode = true;
-    // 关闭显示（进入节能）
     u8g2.setPowerSave(true);
-    // 让 HC-12 进入睡眠（通过 AT 指令）
-    // 切换到 AT 模式并发送 AT+SLEEP
-    bool ok = hc12.enterSleepMode();
-    // 在屏幕上显示提示（如果屏幕仍可用）
-    incomingMessage = ok ? "Entering sleep" : "Sleep failed";
-    incomingMessageTime = millis();
-    // 降低显示更新频率
-    lastDisplayUpdate = millis();
+    powerSetDisplayOn(false);
+}
+
+// 进入深度睡眠，不返回：保存 RTC 快照、HC-12 进入 AT+SLEEP，按键唤醒后从 setup() 的恢复路径继续。
+// 睡眠期间收不到消息（UART 不能唤醒深度睡眠），未持久化的消息历史丢失
+void enterDeepSleep()
+{
+    LOGI(LM_MAIN, "entering deep sleep, press a key to wake");
+    rtcStateSave(radioBootOk);
+    if (radioBootOk && !hc12.enterSleepMode())
+        LOGW(LM_MAIN, "HC-12 did not accept AT+SLEEP");
+    hc12.holdForDeepSleep();
+    u8g2.setPowerSave(true);
+    for (int i = 0; i < 50 && !logIdle(); i++)
+        delay(2);
+    powerDeepSleep();
+}
+
+// RIP 周期处理：在其报告的下一个截止时刻再次运行
+void ripJobRun(void *)
+{
+    STALL_SECTION("rip");
+    schedReschedule(ripJob, ripLoop());
+    // 路由摘要显示在顶栏
+    uiDirty = true;
+}
+
+// 周期遥测广播（TELEMETRY_INTERVAL_MS 为 0 时不启用）
+void telemetryJobRun(void *)
+{
+    metricsSendTelemetry();
+}
+
+// 堆碎片趋势采样（仅 WM_ALLOC_COUNT 构建）
+void heapSampleJobRun(void *)
+{
+    allocSampleHeap();
+}
+
+// 飞行记录器采样（FLIGHT_INTERVAL_S 为 0 或没有分区时不启用）
+void flightJobRun(void *)
+{
+    flightSample();
+}
+
+// 周期能耗摘要（POWER_REPORT_INTERVAL_MS 为 0 时不启用）
+void powerReportJobRun(void *)
+{
+    powerLogEnergy();
+}
+
+void redrawJobRun(void *)
+{
+    redrawJob = SCHED_INVALID;
+    uiDirty = true;
 }
 
 // 开机动画：简单进度条+名称
@@ -354,7 +516,7 @@ void showBootAnimation()
         u8g2.drawFrame(0, 28, 100, 8);
         u8g2.drawBox(1, 29, w > 98 ? 98 : w, 6);
         u8g2.drawStr(0, 52, "Booting...");
-        u8g2.sendBuffer();
+        oledPushFrame();
         delay(200);
     }
 }
@@ -381,11 +543,7 @@ void showBootStep(const char *status, int percent)
     u8g2.setFont(u8g2_font_6x13B_tr);
     if (status && strlen(status) > 0)
     {
-        // 截断以防文本过长
-        char s[40];
-        strncpy(s, status, sizeof(s) - 1);
-        s[sizeof(s) - 1] = '\0';
-        u8g2.drawStr(0, 48, s);
+        drawUTF8Fit(0, 48, status, 128);
     }
 
     // 百分比显示在右上角
@@ -393,85 +551,166 @@ void showBootStep(const char *status, int percent)
     snprintf(pct, sizeof(pct), "%d%%", percent);
     u8g2.drawStr(110 - 6, 12, pct);
 
-    u8g2.sendBuffer();
+    oledPushFrame();
     // 给用户时间看清状态
     delay(160);
 }
 
+// 显示启动步骤（仅完整启动流程；快速启动不显示进度页）
+void bootStep(const char *status, int percent)
+{
+    if (!FAST_BOOT && !resumeBoot)
+        showBootStep(status, percent);
+}
+
 void setup()
 {
     // 串口用于调试
-    Serial.begin(115200);
-    delay(2000);
-    DEBUG_PRINTLN("Starting WirelessMessage...");
+    Serial.setRxBufferSize(SERIAL_RX_BUFFER_SIZE);
+    Serial.begin(SERIAL_CONSOLE_BAUD);
+    logInit();
+    messageHistory.begin(HISTORY_MAX_ENTRIES, HISTORY_ARENA_PSRAM, HISTORY_ARENA_INTERNAL);
+
+    // 由深度睡眠按键唤醒且 RTC 快照有效：恢复输入、聊天、路由状态与 HC-12 波特率，
+    // 跳过开机动画、设置加载与波特率检测，词库在后台加载
+    if (powerDeepSleepWoke())
+    {
+        BootStage stage("rtc restore");
+        ripInit();
+        resumeBoot = rtcStateRestore();
+    }
+
+    if (!FAST_BOOT && !resumeBoot)
+        delay(2000); // 等待串口监视器连接（快速启动不等：日志在队列中，控制台 `boot` 可重看启动分解）
+    LOGI(LM_MAIN, "starting WirelessMessage%s", logStr(resumeBoot ? " (resume)" : ""));
+    bootMark("serial");
+
+    // HC-12 初始化与波特率检测耗时最长且只涉及 UART1，快速启动时交给 core 0 并行执行
+    if (resumeBoot)
+    {
+        hc12.setRxBufferSize(HC12_RX_BUFFER_SIZE);
+        hc12.attach(HC12_SET_PIN, HC12_UART_NUM, HC12_RX_PIN, HC12_TX_PIN, HC12_BAUD_RATE);
+        radioBootOk = rtcStateRadioOk();
+        radioBootDone = true;
+        radioTaskStart(); // 唤醒期间的发送在总线锁上排队
+        xTaskCreatePinnedToCore(bootWakeRadioTaskMain, "boot_radio", 4096, nullptr, 2, nullptr, 0);
+    }
+    else if (FAST_BOOT)
+        xTaskCreatePinnedToCore(bootRadioTaskMain, "boot_radio", 4096, nullptr, 2, nullptr, 0);
 
     // OLED 初始化
-    u8g2.begin();
-    u8g2.enableUTF8Print();
+    {
+        BootStage stage("oled");
+        u8g2.begin();
+        u8g2.enableUTF8Print();
 
-    // 设置默认字体（ASCII）
-    u8g2.setFont(u8g2_font_6x13B_tr);
+        // 设置默认字体（ASCII）
+        u8g2.setFont(u8g2_font_6x13B_tr);
+    }
 
     // 显示开机动画并绘制初始 UI
-    showBootAnimation();
-    // 显示当前步骤：已初始化显示
-    showBootStep("Init OLED", 10);
+    if (!FAST_BOOT && !resumeBoot)
+    {
+        showBootAnimation();
+        // 显示当前步骤：已初始化显示
+        showBootStep("Init OLED", 10);
+
+        // HC-12 初始化并检测波特率
+        showBootStep("Init HC-12", 25);
+        radioBootOk = initRadio();
+        radioBootDone = true;
+        radioTaskStart();
+        if (!radioBootOk)
+            showBootStep("HC-12 init failed", 25);
+    }
 
-    // HC-12 初始化
-    showBootStep("Init HC-12", 25);
-    if (!hc12.init(HC12_SET_PIN, 2, 16, 17, HC12_BAUD_RATE))
+    // 挂载 SPIFFS；之后词库、设置、历史的加载只读文件
     {
-        DEBUG_PRINTLN("HC-12 init failed");
-        showBootStep("HC-12 init failed", 25);
+        BootStage stage("storage");
+        if (!SPIFFS.begin(true))
+            LOGE(LM_MAIN, "SPIFFS mount failed");
     }
-    else
+    if (FLIGHT_INTERVAL_S > 0)
     {
-        DEBUG_PRINTLN("HC-12 initialized");
+        BootStage stage("flightrec");
+        flightInit();
     }
 
-    // 自动检测 HC-12 当前波特率并配置本地串口
-    showBootStep("Detect HC-12 baud", 35);
-    configureHC12();
+    bootStep("Load pinyin dict", 60);
+    if (FAST_BOOT || resumeBoot)
+        xTaskCreatePinnedToCore(bootDictTaskMain, "boot_dict", 6144, nullptr, 1, nullptr, 0);
+    else
+        loadDictionaryStage();
 
-    showBootStep("Load pinyin dict", 60);
-    loadPinyinDict();
-    showBootStep("Load frequency data", 75);
-    loadFrequencyData();
+    // 初始化 RIP 子模块（恢复时已在快照恢复前初始化）
+    bootStep("Init RIP module", 85);
+    if (!resumeBoot)
+        ripInit();
 
-    // 初始化 RIP 子模块
-    showBootStep("Init RIP module", 85);
-    ripInit();
+    // 加载 RCV 设置与历史（如果持久化开启）；恢复时设置来自快照
+    {
+        BootStage stage("settings");
+        if (!resumeBoot)
+            loadRcvSettings();
+        if (rcvPersist)
+        {
+            loadHistoryFromFS();
+        }
+    }
 
-    // 加载 RCV 设置与历史（如果持久化开启）
-    loadRcvSettings();
-    if (rcvPersist)
+    // 无线帧密钥与发送计数（需要 RIP 节点 ID）
     {
-        loadHistoryFromFS();
+        BootStage stage("crypto");
+        cryptoInit(ripSelfId().c_str());
     }
 
     // 初始模式显示
-    inputMode = MODE_CHS;
+    if (resumeBoot)
+        chatScrollPx = min(chatScrollPx, chatMaxScrollPx()); // 历史可能比睡眠前短（未持久化的消息丢失）
+    else
+        inputMode = MODE_CHS;
 
     // 初次绘制
-    showBootStep("Ready", 100);
+    bootStep("Ready", 100);
     drawUI();
+    bootMark("first frame");
 
-    // 记录初始活动时间
+    if (resumeBoot)
+    {
+        showToast("Resumed");
+        uiDirty = true;
+    }
+
+    // 记录初始活动时间，启动定时任务
     lastActivityTime = millis();
+    idleJob = schedAfter(IDLE_TIMEOUT_MS, idleTimeoutJob);
+    ripJob = schedAfter(0, ripJobRun);
+    if (TELEMETRY_INTERVAL_MS > 0)
+        schedEvery(TELEMETRY_INTERVAL_MS, telemetryJobRun);
+    if (POWER_REPORT_INTERVAL_MS > 0)
+        schedEvery(POWER_REPORT_INTERVAL_MS, powerReportJobRun);
+    if (FLIGHT_INTERVAL_S > 0 && flightAvailable())
+        schedEvery(FLIGHT_INTERVAL_S * 1000, flightJobRun);
+    if (allocTrackingEnabled())
+    {
+        allocSampleHeap();
+        schedEvery(ALLOC_SAMPLE_MS, heapSampleJobRun);
+    }
+
+    // 启动键盘/持久化任务，此后 loop() 作为 UI 任务运行；无线任务在 HC-12 检测结束后启动，
+    // UART 唤醒在 loop() 中看到检测结束后配置
+    stallInit();
+    tasksStart();
+    bootMarkReady();
+    bootReport();
 }
 
-// 删除 UTF-8 最后一个字符
+// 删除 UTF-8 最后一个字符（原地截短，不分配）
 void utf8Backspace(String &s)
 {
     if (s.length() == 0)
         return;
-    int i = s.length() - 1;
-    // 向前找到一个非续字节(0b10xxxxxx)
-    while (i > 0 && (((uint8_t)s[i] & 0xC0) == 0x80))
-    {
-        i--;
-    }
-    s = s.substring(0, i);
+    s.remove(utf8Prev(s.c_str(), s.length()));
 }
 
 // 将当前候选窗口调整到包含 candidateIndex
@@ -486,16 +725,302 @@ void normalizeCandidateWindow()
         candidateWindowStart = 0;
 }
 
-void handleKeypress(char key)
+int chatTotalPages()
+{
+    int totalPages = ((int)messageHistory.size() + chatPageSize - 1) / chatPageSize;
+    return totalPages > 0 ? totalPages : 1;
+}
+
+// 聊天视口可滚动的最大像素（消息不足一屏时为 0）
+int chatMaxScrollPx()
+{
+    int totalMsgs = (int)messageHistory.size();
+    if (totalMsgs <= CHAT_VISIBLE_LINES)
+        return 0;
+    return (totalMsgs - CHAT_VISIBLE_LINES) * CHAT_LINE_HEIGHT;
+}
+
+// 第 i 条消息在当前视口中的基线 y（消息不足一屏时自顶向下排列，否则最新消息贴底）
+int chatBaselineOf(int i)
+{
+    int totalMsgs = (int)messageHistory.size();
+    if (totalMsgs <= CHAT_VISIBLE_LINES)
+        return CHAT_FIRST_BASELINE + i * CHAT_LINE_HEIGHT;
+    return CHAT_BOTTOM_BASELINE - (totalMsgs - 1 - i) * CHAT_LINE_HEIGHT + chatScrollPx;
+}
+
+// 跳到指定页（0 为最新），视口对齐到该页
+void chatShowPage(int page)
+{
+    int totalPages = chatTotalPages();
+    if (page >= totalPages)
+        page = totalPages - 1;
+    if (page < 0)
+        page = 0;
+    chatPage = page;
+    chatScrollPx = min(page * chatPageSize * CHAT_LINE_HEIGHT, chatMaxScrollPx());
+}
+
+// 平滑滚动 px 像素（正值向更早）；位移交由控制器起始行完成，页码随视口更新
+void chatScrollBy(int px)
 {
-    if (key == NO_KEY)
+    int maxPx = chatMaxScrollPx();
+    int target = constrain(chatScrollPx + px, 0, maxPx);
+    int delta = target - chatScrollPx;
+    if (delta == 0)
+        return;
+    chatScrollPx = target;
+    // 视口向更早滚动时内容整体下移
+    oledScrollRows(-delta);
+    if (chatScrollPx >= maxPx)
+        chatPage = chatTotalPages() - 1;
+    else
+        chatPage = chatScrollPx / (chatPageSize * CHAT_LINE_HEIGHT);
+}
+
+// 处理一次按下；pressMs 为按键实际按下时刻，多击/双击判定均以它为准
+// --- 设置界面的 AT 作业：在无线任务中执行（改波特率后的检测可长达数秒），UI 任务只投递并等待响应 ---
+
+// 执行 arg 中的一条 AT 指令（查询类设置项）
+static size_t atQuery(const char *arg, char *resp, size_t cap)
+{
+    return hc12.sendATCommand(arg, resp, cap, HC12_AT_TIMEOUT_MS);
+}
+
+static size_t atReply(char *resp, size_t cap, const char *text)
+{
+    strlcpy(resp, text, cap);
+    return strlen(resp);
+}
+
+// 查询全部参数，在每个 "OK" 前插入分隔符（第一个除外）以便显示
+static size_t atGetAllParams(const char *, char *resp, size_t cap)
+{
+    char raw[HC12_AT_RESPONSE_MAX];
+    atQuery("AT+RX", raw, sizeof(raw));
+    size_t n = 0;
+    for (const char *p = raw; *p && n + 1 < cap; p++)
+    {
+        if (p[0] == 'O' && p[1] == 'K' && n > 0)
+        {
+            if (n + 4 >= cap)
+                break;
+            memcpy(resp + n, " | ", 3);
+            n += 3;
+        }
+        resp[n++] = *p;
+    }
+    resp[n] = '\0';
+    return n;
+}
+
+// 把模块与本地串口改为 arg 波特率，再重新检测并同步（以防模块写入后需要确认）
+static size_t atSetBaud(const char *arg, char *resp, size_t cap)
+{
+    int b = atoi(arg);
+    if (!hc12.setBaudRate(b))
+        return atReply(resp, cap, "FAIL");
+    hc12.reconfigureLocalSerial(b);
+    configureHC12();
+    return (size_t)snprintf(resp, cap, "OK+B%d", b);
+}
+
+// 查询当前频道并设为下一个（最大 127）
+static size_t atNextChannel(const char *, char *resp, size_t cap)
+{
+    char cur[HC12_AT_RESPONSE_MAX];
+    size_t n = atQuery("AT+RC", cur, sizeof(cur));
+    int ch = n >= 3 ? atoi(cur + n - 3) : 1;
+    ch = min(ch + 1, 127);
+    char cmd[12];
+    snprintf(cmd, sizeof(cmd), "AT+C%03d", ch);
+    atQuery(cmd, cur, sizeof(cur));
+    if (!strstr(cur, "OK"))
+        return atReply(resp, cap, "FAIL");
+    return (size_t)snprintf(resp, cap, "OK+C%03d", ch);
+}
+
+// 查询当前工作模式并切到下一个：FU1 → FU2 → FU3 → FU4 → FU1，读不出时设为 FU1
+static size_t atNextMode(const char *, char *resp, size_t cap)
+{
+    char cur[HC12_AT_RESPONSE_MAX];
+    atQuery("AT+RF", cur, sizeof(cur));
+    const char *fu = strstr(cur, "FU");
+    int next = (fu && fu[2] >= '1' && fu[2] <= '3') ? fu[2] - '0' + 1 : 1;
+    char cmd[8];
+    snprintf(cmd, sizeof(cmd), "AT+FU%d", next);
+    atQuery(cmd, cur, sizeof(cur));
+    if (!strstr(cur, "OK"))
+        return atReply(resp, cap, "FAIL");
+    return (size_t)snprintf(resp, cap, "OK+FU%d", next);
+}
+
+static size_t atSetPower(const char *arg, char *resp, size_t cap)
+{
+    int level = atoi(arg);
+    if (!hc12.setPowerLevel(level))
+        return atReply(resp, cap, "FAIL");
+    return (size_t)snprintf(resp, cap, "OK+P%d", level);
+}
+
+static size_t atSleep(const char *, char *resp, size_t cap)
+{
+    return atReply(resp, cap, hc12.enterSleepMode() ? "OK+SLEEP" : "FAIL");
+}
+
+// 恢复出厂后，模块波特率可能回到默认，重新检测并同步
+static size_t atFactoryReset(const char *, char *resp, size_t cap)
+{
+    if (!hc12.factoryReset())
+        return atReply(resp, cap, "FAIL");
+    configureHC12();
+    return atReply(resp, cap, "OK+DEFAULT");
+}
+
+// 进入设置：拉低 SET 引脚进入 AT 模式；退出：回到通信模式，使设置生效并恢复正常通信
+static size_t atEnterSettings(const char *, char *, size_t)
+{
+    hc12.setMode(HC12Module::AT_MODE);
+    return 0;
+}
+
+static size_t atLeaveSettings(const char *, char *, size_t)
+{
+    hc12.setMode(HC12Module::COMM_MODE);
+    return 0;
+}
+
+static void settingsShow(const char *msg)
+{
+    settingsMsg = msg;
+    settingsMsgTime = millis();
+}
+
+// 进入或退出设置界面，引脚切换交给无线任务
+static void settingsSetActive(bool active)
+{
+    inSettings = active;
+    settingsIndex = 0;
+    settingsMsg = "";
+    settingsMsgTime = 0;
+    if (!radioAtRun(active ? atEnterSettings : atLeaveSettings, "", 0))
+        LOGW(LM_RADIO, "TX queue full, HC-12 mode switch dropped");
+}
+
+// 执行选中的设置项：把 AT 作业交给无线任务并显示 Working...，结果由 settingsAtResponse() 显示
+static void settingsRun(int idx)
+{
+    if (settingsPending >= 0)
+    {
+        settingsShow("Busy");
+        return;
+    }
+    RadioAtFn fn = atQuery;
+    const char *arg = "";
+    char buf[8];
+    switch (idx)
+    {
+    case 0:
+        arg = "AT+V";
+        break;
+    case 1:
+        fn = atGetAllParams;
+        break;
+    case 2:
+        arg = "AT+RB";
+        break;
+    case 3:
+    {
+        // 循环常见波特率并设置（用户可通过多次按 D 改变）
+        static const int baudOptions[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
+        static int sel = 5; // 默认指向 38400 索引
+        sel = (sel + 1) % (sizeof(baudOptions) / sizeof(baudOptions[0]));
+        snprintf(buf, sizeof(buf), "%d", baudOptions[sel]);
+        fn = atSetBaud;
+        arg = buf;
+        break;
+    }
+    case 4:
+        arg = "AT+RC";
+        break;
+    case 5:
+        fn = atNextChannel;
+        break;
+    case 6:
+        arg = "AT+RF";
+        break;
+    case 7:
+        fn = atNextMode;
+        break;
+    case 8:
+        arg = "AT+RP";
+        break;
+    case 9:
+    {
+        static int powerSel = 8;
+        powerSel = (powerSel % 8) + 1;
+        snprintf(buf, sizeof(buf), "%d", powerSel);
+        fn = atSetPower;
+        arg = buf;
+        break;
+    }
+    case 10:
+        fn = atSleep;
+        break;
+    case 11:
+        fn = atFactoryReset;
+        break;
+    default:
+        settingsSetActive(false); // Exit
+        return;
+    }
+    if (!radioAtRun(fn, arg, strlen(arg)))
+    {
+        settingsShow("Busy");
+        return;
+    }
+    settingsPending = idx;
+    settingsShow("Working...");
+}
+
+// 无线任务送回设置项的结果（AT 帧，fn 为所执行的作业）
+void settingsAtResponse(RadioAtFn fn, const char *text)
+{
+    int idx = settingsPending;
+    if (fn == atEnterSettings || fn == atLeaveSettings || idx < 0)
+        return;
+    settingsPending = -1;
+    if (*text == '\0')
+        text = "(no response)";
+    settingsShow(text);
+    // 在串口输出选择项与返回值，便于调试
+    LOGI(LM_MAIN, "settings %d %s -> %s", idx, settingsMenu[idx], logStr(text));
+    if (idx == 1)
+    {
+        // 全部参数推送到接收历史（前缀 ATRCV:），切换到接收模式显示最新页，并短暂提示
+        char note[8 + RADIO_FRAME_MAX];
+        int n = snprintf(note, sizeof(note), "ATRCV: %s", text);
+        messageHistory.push(note, min((size_t)n, sizeof(note) - 1), maxMessageHistory);
+        recvMode = true;
+        chatShowPage(0);
+        showToast(text);
+    }
+    else if ((idx == 3 || idx == 11) && strncmp(text, "OK", 2) == 0)
+    {
+        showBaudToast();
+    }
+    uiDirty = true;
+}
+
+void handleKeypress(char key, unsigned long pressMs)
+{
+    if (key == '\0')
         return;
 
     // 有按键交互，更新活动时间并在必要时唤醒
     updateLastActivity();
 
-    DEBUG_PRINT("Keypress: ");
-    DEBUG_PRINTLN(key);
+    LOGD(LM_MAIN, "key %c", key);
 
     // 通用按键处理
     // 如果处于 RCV 设置界面，部分按键用于调整设置
@@ -582,24 +1107,11 @@ void handleKeypress(char key)
         // 双按 B 进入/退出设置界面；单按切换 发送/接收 模式（recvMode）
         {
             static unsigned long lastBTime = 0;
-            unsigned long nowB = millis();
+            unsigned long nowB = pressMs;
             if ((nowB - lastBTime) < 600)
             {
-                // 双按：切换设置界面并切换 HC-12 模式
-                inSettings = !inSettings;
-                settingsIndex = 0;
-                settingsMsg = "";
-                settingsMsgTime = 0;
-                if (inSettings)
-                {
-                    // 进入设置：拉低 SET 引脚进入 AT 模式（设置生效需退出设置）
-                    hc12.setMode(HC12Module::AT_MODE);
-                }
-                else
-                {
-                    // 退出设置：回到通信模式，使设置生效并恢复正常通信
-                    hc12.setMode(HC12Module::COMM_MODE);
-                }
+                // 双按：切换设置界面并切换 HC-12 模式（设置生效需退出设置）
+                settingsSetActive(!inSettings);
                 lastBTime = 0;
                 break;
             }
@@ -612,7 +1124,7 @@ void handleKeypress(char key)
             {
                 incomingMessage = "";
                 // 进入聊天模式，显示最新页
-                chatPage = 0;
+                chatShowPage(0);
             }
             // 保持输入/拼音状态不变，但清除当前拼音组合以避免模式干扰
             pinyinBuffer = "";
@@ -644,147 +1156,7 @@ void handleKeypress(char key)
         // 发送/确认
         if (inSettings)
         {
-            // 执行选中的设置项
-            String res = "";
-            if (settingsIndex == 1)
-            {
-                res = hc12.getAllParams();
-                // 将返回结果按 "OK" 位置拆分以便显示（插入分隔符）
-                String formatted = "";
-                int i = 0;
-                int n = res.length();
-                while (i < n)
-                {
-                    if (i + 2 <= n && res.substring(i, i + 2) == "OK")
-                    {
-                        if (formatted.length() > 0)
-                            formatted += " | ";
-                        formatted += "OK";
-                        i += 2;
-                    }
-                    else
-                    {
-                        formatted += res[i];
-                        i++;
-                    }
-                }
-                // 推送到接收历史，前缀为 ATRCV:
-                String note = String("ATRCV: ") + formatted;
-                messageHistory.push_back(note);
-                if (messageHistory.size() > maxMessageHistory)
-                    messageHistory.erase(messageHistory.begin());
-                // 切换到接收模式并显示最新页
-                recvMode = true;
-                chatPage = 0;
-                // 将短暂提示也设置为 formatted 以便在非聊天模式下也能看到
-                incomingMessage = formatted;
-                incomingMessageTime = millis();
-                // 把 res 替换为 formatted 以供后续显示
-                res = formatted;
-            }
-            // (settingsIndex == 1 handled above: Get All Params pushes to history)
-            else if (settingsIndex == 2)
-            {
-                res = hc12.getBaudRate();
-            }
-            else if (settingsIndex == 3)
-            {
-                // 循环常见波特率并设置示例（用户可通过多次按 D 改变）
-                static int baudOptions[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
-                static int sel = 5; // 默认指向 38400 索引
-                sel = (sel + 1) % (sizeof(baudOptions) / sizeof(int));
-                int b = baudOptions[sel];
-                bool ok = hc12.setBaudRate(b);
-                if (ok)
-                {
-                    hc12.reconfigureLocalSerial(b);
-                    res = "OK+B" + String(b);
-                    // 更改波特率后重新检测并同步（以防模块写入后需要确认）
-                    configureHC12();
-                }
-                else
-                {
-                    res = "FAIL";
-                }
-            }
-            else if (settingsIndex == 4)
-            {
-                res = hc12.getChannel();
-            }
-            else if (settingsIndex == 5)
-            {
-                String cur = hc12.getChannel();
-                int ch = 1;
-                if (cur.length() >= 3)
-                    ch = cur.substring(cur.length() - 3).toInt();
-                ch++;
-                if (ch > 127)
-                    ch = 127;
-                char buf[4];
-                snprintf(buf, sizeof(buf), "%03d", ch);
-                bool ok = hc12.setChannel(String(buf));
-                res = ok ? String("OK+C") + String(buf) : String("FAIL");
-            }
-            else if (settingsIndex == 6)
-            {
-                res = hc12.getMode();
-            }
-            else if (settingsIndex == 7)
-            {
-                String cur = hc12.getMode();
-                String next = "FU1";
-                if (cur.indexOf("FU1") >= 0)
-                    next = "FU2";
-                else if (cur.indexOf("FU2") >= 0)
-                    next = "FU3";
-                else if (cur.indexOf("FU3") >= 0)
-                    next = "FU4";
-                else if (cur.indexOf("FU4") >= 0)
-                    next = "FU1";
-                bool ok = hc12.setMode(next);
-                res = ok ? String("OK+FU") + next.substring(2) : String("FAIL");
-            }
-            else if (settingsIndex == 8)
-            {
-                res = hc12.getPower();
-            }
-            else if (settingsIndex == 9)
-            {
-                static int powerSel = 8;
-                powerSel = (powerSel % 8) + 1;
-                bool ok = hc12.setPowerLevel(powerSel);
-                res = ok ? String("OK+P") + String(powerSel) : String("FAIL");
-            }
-            else if (settingsIndex == 10)
-            {
-                bool ok = hc12.enterSleepMode();
-                res = ok ? "OK+SLEEP" : "FAIL";
-            }
-            else if (settingsIndex == 11)
-            {
-                bool ok = hc12.factoryReset();
-                res = ok ? "OK+DEFAULT" : "FAIL";
-                if (ok)
-                {
-                    // 恢复出厂后，模块波特率可能回到默认，重新检测并同步
-                    configureHC12();
-                }
-            }
-            else if (settingsIndex == 12)
-            {
-                inSettings = false; // 退出设置
-                res = "Exit";
-            }
-
-            settingsMsg = res;
-            settingsMsgTime = millis();
-            // 在串口输出选择项与返回值，便于调试（按 D 无响应时查看）
-            Serial.print("Settings select idx=");
-            Serial.print(settingsIndex);
-            Serial.print(" label=");
-            Serial.print(settingsMenu[settingsIndex]);
-            Serial.print(" -> response=");
-            Serial.println(res);
+            settingsRun(settingsIndex);
             drawUI();
         }
         else if (inRcvSettings)
@@ -803,8 +1175,8 @@ void handleKeypress(char key)
             else if (rcvSettingsIndex == 1)
             {
                 maxMessageHistory = maxMessageHistory + 10;
-                if (maxMessageHistory > 500)
-                    maxMessageHistory = 500;
+                if (maxMessageHistory > HISTORY_MAX_ENTRIES)
+                    maxMessageHistory = HISTORY_MAX_ENTRIES;
             }
             else if (rcvSettingsIndex == 2)
             {
@@ -838,22 +1210,14 @@ void handleKeypress(char key)
         }
         else if (inputBuffer.length() > 0)
         {
-            // 通过 HC-12 发送
-            // 确保发送前为通信模式
-            hc12.setMode(HC12Module::COMM_MODE);
-            bool ok = hc12.sendData(inputBuffer);
-            DEBUG_PRINT("Send: ");
-            DEBUG_PRINT(inputBuffer);
-            DEBUG_PRINT(" -> ");
-            DEBUG_PRINTLN(ok ? "OK" : "FAIL");
+            // 交给无线任务发送（不阻塞界面）
+            bool ok = radioSend(inputBuffer.c_str(), inputBuffer.length());
+            LOGD(LM_MAIN, "send %u bytes: %s", inputBuffer.length(), ok ? "queued" : "queue full");
             // 在发送模式下，保留短暂提示；在接收模式下追加到历史并显示
             String note = String(ok ? "Sent: " : "SendFail: ") + inputBuffer;
-            incomingMessage = note;
-            incomingMessageTime = millis();
+            showToast(note);
             // 记录历史消息（无论当前模式，保存在 messageHistory）
-            messageHistory.push_back(note);
-            if (messageHistory.size() > maxMessageHistory)
-                messageHistory.erase(messageHistory.begin());
+            messageHistory.push(note, maxMessageHistory);
             inputBuffer = "";
         }
         break;
@@ -868,7 +1232,7 @@ void handleKeypress(char key)
         else if (recvMode)
         {
             // 检测是否为进入 RCV 设置的快捷键序列：先按 '*' 再按 '#'（在窗口内）
-            unsigned long now = millis();
+            unsigned long now = pressMs;
             lastRecvShortcut = '*';
             lastRecvShortcutTime = now;
 
@@ -882,10 +1246,9 @@ void handleKeypress(char key)
             {
                 // 正常聊天翻页（长按支持）
                 chatNavDir = -1; // 向更新页（newer）
-                chatNavLast = now;
+                chatNavPressTime = now;
                 lastChatNavKey = '*';
-                if (chatPage > 0)
-                    chatPage--;
+                chatShowPage(chatPage - 1);
             }
         }
         else if (inputMode == MODE_CHS)
@@ -899,7 +1262,7 @@ void handleKeypress(char key)
                 showT9Table = true;
             }
             lastStarKey = '*';
-            lastStarTime = millis();
+            lastStarTime = pressMs;
         }
         else
         {
@@ -922,7 +1285,7 @@ void handleKeypress(char key)
         }
         else if (recvMode)
         {
-            unsigned long now = millis();
+            unsigned long now = pressMs;
             // 检查此前是否有 '*' 快捷按下且在时间窗口内，则进入 RCV 设置
             if (lastRecvShortcut == '*' && (now - lastRecvShortcutTime) < RECV_SHORTCUT_WINDOW && !inRcvSettings)
             {
@@ -935,9 +1298,9 @@ void handleKeypress(char key)
             {
                 // 正常聊天翻页（向更早）
                 chatNavDir = +1; // 向更早页
-                chatNavLast = now;
+                chatNavPressTime = now;
                 lastChatNavKey = '#';
-                chatPage++;
+                chatShowPage(chatPage + 1);
             }
         }
         else
@@ -958,7 +1321,7 @@ void handleKeypress(char key)
             // 处理 1 键的单击/双击：单击插入空格，双击显示对应表
             if (key == '1')
             {
-                unsigned long now = millis();
+                unsigned long now = pressMs;
                 if (lastOneKey == '1' && (now - lastOneTime) < 800)
                 {
                     // 双击：切换显示键位对应表
@@ -996,7 +1359,7 @@ void handleKeypress(char key)
                 }
                 else
                 {
-                    handlePinyinInput(key);
+                    handlePinyinInput(key, pressMs);
                 }
             }
             else if (inputMode == MODE_ENG)
@@ -1007,7 +1370,7 @@ void handleKeypress(char key)
                 }
                 else
                 {
-                    handleEnglishInput(key);
+                    handleEnglishInput(key, pressMs);
                     // 如果为大写模式，将最后一个字母转为大写
                     if (engUppercase && inputBuffer.length() > 0)
                     {
@@ -1036,7 +1399,7 @@ void handleKeypress(char key)
                         if (s != nullptr && s[0] != '\0')
                         {
                             // 支持多次按键选择：在 SYMBOL_TIMEOUT 内连续按同一键则循环替换符号
-                            unsigned long now = millis();
+                            unsigned long now = pressMs;
                             int len = (int)strlen(s);
                             if (lastSymbolKey == key && (now - lastSymbolTime) < SYMBOL_TIMEOUT)
                             {
@@ -1081,7 +1444,43 @@ void handleKeypress(char key)
     drawUI();
 }
 
+// 在 [clipTop, 64) 区域内按当前视口绘制聊天消息
+void drawChatMessages(int clipTop)
+{
+    u8g2.setFont(WM_FONT_CJK);
+    u8g2.setClipWindow(0, clipTop, 128, 64);
+    for (int i = (int)messageHistory.size() - 1; i >= 0; i--)
+    {
+        int y = chatBaselineOf(i);
+        // 字形约占基线上 11 行、下 2 行
+        if (y + 2 < clipTop)
+            break; // 更早的消息都在视口之上
+        if (y - 11 >= 64)
+            continue;
+        u8g2.drawUTF8(0, y, messageHistory[i]);
+    }
+    u8g2.setMaxClipWindow();
+}
+
+// 绘制一帧；限时内容在消失时刻自动重绘
 void drawUI()
+{
+    TraceScope trace(TR_DRAW);
+    STALL_SECTION("draw");
+    uiExpiryValid = false;
+    drawUIFrame();
+    uiDirty = false;
+
+    schedCancel(redrawJob);
+    redrawJob = SCHED_INVALID;
+    if (uiExpiryValid)
+    {
+        long left = (long)(uiExpiry - millis());
+        redrawJob = schedAfter(left > 0 ? (uint32_t)left : 0, redrawJobRun);
+    }
+}
+
+void drawUIFrame()
 {
     // 基本布局：
     // 顶部：模式与状态
@@ -1090,6 +1489,14 @@ void drawUI()
 
     u8g2.clearBuffer();
 
+    // 长按平滑滚动期间聊天占满全屏：不绘制随内容静止的顶栏与输入行，每步只露出一页新内容
+    if (recvMode && chatFullscreen)
+    {
+        drawChatMessages(0);
+        oledPushFrame();
+        return;
+    }
+
     // 顶部模式栏或聊天页码
     u8g2.setFont(u8g2_font_6x13B_tr);
     if (recvMode)
@@ -1139,29 +1546,25 @@ void drawUI()
         }
         u8g2.drawStr(0, 10, "Mode:");
         u8g2.drawStr(48, 10, modeStr);
-        // 在右上角显示简短的 RIP 路由摘要，便于调试（截断以免溢出）
-        String ripSum = ripGetRoutesSummary();
-        if (ripSum.length() > 20)
-        {
-            ripSum = ripSum.substring(0, 17) + "...";
-        }
-        u8g2.drawStr(80, 10, ripSum.c_str());
+        // 在右上角显示简短的 RIP 路由摘要，便于调试（按像素截断以免溢出）
+        char ripSum[RADIO_FRAME_MAX];
+        ripFormatRoutesSummary(ripSum, sizeof(ripSum));
+        drawUTF8Fit(80, 10, ripSum, 128 - 80);
     }
 
     // 中间显示已输入文本（中文需UTF8字体）
-    u8g2.setFont(u8g2_font_wqy12_t_gb2312);
-    // 限制显示长度，避免超出屏幕
-    String displayInput = inputBuffer;
-    if (displayInput.length() == 0)
-        displayInput = " ";
+    u8g2.setFont(WM_FONT_CJK);
+    // 超出屏幕宽度时只显示末尾能放下的部分，正在输入的位置总是可见
+    const char *displayInput = inputBuffer.length() > 0 ? inputBuffer.c_str() : " ";
+    displayInput += utf8FitWidthTail(displayInput, strlen(displayInput), 128, glyphWidth, nullptr);
     // 在聊天模式下将输入区上移以腾出更多空间用于显示消息
     if (recvMode)
     {
-        u8g2.drawUTF8(0, 26, displayInput.c_str());
+        u8g2.drawUTF8(0, 26, displayInput);
     }
     else
     {
-        u8g2.drawUTF8(0, 30, displayInput.c_str());
+        u8g2.drawUTF8(0, 30, displayInput);
     }
 
     // 如果处于设置界面，绘制设置菜单覆盖底部区域
@@ -1201,11 +1604,11 @@ void drawUI()
             }
         }
         // 显示短暂操作结果
-        if (settingsMsg.length() > 0 && (millis() - settingsMsgTime) < SETTINGS_MSG_MS)
+        if (settingsMsg.length() > 0 && (settingsPending >= 0 || uiShowing(settingsMsgTime, SETTINGS_MSG_MS)))
         {
             u8g2.drawStr(0, 64, settingsMsg.c_str());
         }
-        u8g2.sendBuffer();
+        oledPushFrame();
         return; // 不绘制其他下方内容
     }
 
@@ -1253,13 +1656,13 @@ void drawUI()
                 u8g2.drawStr(80, y, valbuf);
             }
         }
-        u8g2.sendBuffer();
+        oledPushFrame();
         return;
     }
 
     // 显示拼音缓冲（如果有）
     u8g2.setFont(u8g2_font_6x13B_tr);
-    String py = pinyinBuffer;
+    const String &py = pinyinBuffer;
     // 在聊天模式下为保证空间，不绘制拼音缓冲；否则正常显示
     if (!recvMode && composing && py.length() > 0)
     {
@@ -1270,50 +1673,24 @@ void drawUI()
     // 如果有临时传入消息，显示在底部
     if (recvMode)
     {
-        // 接收/聊天模式：分页显示历史，从最新开始
-        u8g2.setFont(u8g2_font_wqy12_t_gb2312);
-        int pageSize = chatPageSize; // 每页显示行数
-        int totalMsgs = (int)messageHistory.size();
-        int totalPages = (totalMsgs + pageSize - 1) / pageSize;
-        if (totalPages <= 0)
-            totalPages = 1;
-        int displayPage = chatPage;
-        if (displayPage < 0)
-            displayPage = 0;
-        if (displayPage >= totalPages)
-            displayPage = totalPages - 1;
-        // 计算此页要显示的消息索引范围：页面0为最新页，显示 messageHistory 的尾部
-        int endIndex = totalMsgs - displayPage * pageSize - 1; // inclusive
-        int startIndex = endIndex - (pageSize - 1);
-        if (endIndex < 0)
-            endIndex = -1;
-        if (startIndex < 0)
-            startIndex = 0;
-        // 聊天模式消息从更靠上处开始，使用更紧凑的行高以便显示三条
-        int y = 36; // 顶部基线（较之前上移）
-        const int CHAT_LINE_HEIGHT = 12;
-        for (int i = startIndex; i <= endIndex && i >= 0 && i < totalMsgs; i++)
-        {
-            String m = messageHistory[i];
-            u8g2.drawUTF8(0, y, m.c_str());
-            y += CHAT_LINE_HEIGHT; // 行高
-        }
+        // 接收/聊天模式：按视口显示历史，chatScrollPx=0 为最新
+        drawChatMessages(CHAT_AREA_TOP);
         // 显示跳转确认提示（若有）
-        if (chatJumpMsg.length() > 0 && (millis() - chatJumpMsgTime) < CHAT_JUMP_MSG_MS)
+        if (chatJumpMsg.length() > 0 && uiShowing(chatJumpMsgTime, CHAT_JUMP_MSG_MS))
         {
             u8g2.setFont(u8g2_font_6x13B_tr);
             u8g2.drawStr(0, 58, chatJumpMsg.c_str());
         }
     }
-    else if (incomingMessage.length() > 0 && (millis() - incomingMessageTime) < INCOMING_MSG_DISPLAY_MS)
+    else if (incomingMessage.length() > 0 && uiShowing(incomingMessageTime, INCOMING_MSG_DISPLAY_MS))
     {
-        u8g2.setFont(u8g2_font_wqy12_t_gb2312);
-        u8g2.drawStr(0, 58, incomingMessage.c_str());
+        u8g2.setFont(WM_FONT_CJK);
+        drawUTF8Fit(0, 58, incomingMessage.c_str(), 128);
     }
     else
     {
         // 如果显示整体键位映射或T9表
-        if (showKeymap || (showT9Table && (millis() - lastStarTime) < 3000))
+        if (showKeymap || (showT9Table && uiShowing(lastStarTime, 3000)))
         {
             u8g2.setFont(u8g2_font_6x13B_tr);
             // 绘制简易的九宫格对应表
@@ -1363,9 +1740,9 @@ void drawUI()
                 int drawn = 0;
                 for (int i = candidateWindowStart; i < candidates.size() && drawn < windowSize; i++)
                 {
-                    String cand = candidates[i];
+                    const String &cand = candidates[i];
                     // 用中文字体绘制
-                    u8g2.setFont(u8g2_font_wqy12_t_gb2312);
+                    u8g2.setFont(WM_FONT_CJK);
                     int xpos = x + drawn * 24;
                     // 高亮当前选中
                     if (i == candidateIndex)
@@ -1381,228 +1758,218 @@ void drawUI()
                     drawn++;
                 }
             }
+            else if (composing && !dictionaryReady())
+            {
+                // 快速启动时词库仍在后台加载
+                u8g2.drawStr(0, 58, "Loading dict...");
+            }
         }
     }
 
-    u8g2.sendBuffer();
+    oledPushFrame();
 }
 
-void loop()
+// 处理无线任务收到的一帧数据（运行在 UI 任务中）
+// msg 以 '\0' 结尾，len 为字节数；除写入历史外不分配堆内存
+void handleRadioFrame(const char *msg, size_t len)
 {
-    // 读取键盘按键
-    char key = keypad.getKey();
-    if (key != NO_KEY)
+    STALL_SECTION("radio frame");
+    // 其它节点的遥测：只打印，不算活动、不进历史。
+    // 传输模式下串口承载二进制帧，丢弃而不打印（日志记录的文本太短，放不下整行遥测）
+    if (strncmp(msg, "TLM|", 4) == 0)
     {
-        handleKeypress(key);
+        metricInc(MC_TLM_RECV);
+        if (!xferActive())
+            Serial.println(msg);
+        return;
     }
 
-    // 处理来自 PC 串口的命令输入
-    handleSerialConsoleInput();
-    // RIP 协议周期处理（路由老化与定期发送 UPDATE）
-    ripLoop();
-
-    // 读取 HC-12 接收
-    if (hc12.available())
+    // 先交给 RIP 子模块处理；若返回 false 则按普通数据处理
+    // （RIP 报文不算活动，低功耗时不因邻居的周期广播而点亮屏幕）
+    if (ripHandlePacket(msg, len))
+    {
+        if (lowPowerMode)
+            return;
+        // 将路由表摘要作为短暂提示显示（便于调试）
+        char summary[RADIO_FRAME_MAX];
+        ripFormatRoutesSummary(summary, sizeof(summary));
+        showToast(summary);
+        drawUI();
+    }
+    else
     {
-        String msg = hc12.readData();
-        if (msg.length() > 0)
+        // 更新活动时间（外部数据到达也视作活动）
+        updateLastActivity();
+        // 过滤明显乱码（非 UTF-8）以避免屏幕刷屏
+        if (!utf8Valid(msg, len))
+        {
+            metricInc(MC_RX_GARBLED);
+            LOGD(LM_RADIO, "ignored %u garbled bytes", len);
+            showToast("<garbled ignored>");
+            drawUI();
+        }
+        else
         {
-            // 更新活动时间（外部数据到达也视作活动）
-            updateLastActivity();
-            // 先交给 RIP 子模块处理；若返回 false 则按普通数据处理
-            if (ripHandlePacket(msg))
+            String note;
+            note.reserve(5 + len);
+            note.concat("RCV: ");
+            note.concat(msg);
+            LOGD(LM_RADIO, "received %u bytes: %s", len, logStr(msg, len));
+            // 将收到的消息加入历史
+            if (!recvMode)
             {
-                // 将路由表摘要作为短暂提示显示（便于调试）
-                incomingMessage = ripGetRoutesSummary();
-                incomingMessageTime = millis();
-                drawUI();
+                // 在发送模式下，显示短暂提示
+                showToast(note.c_str());
             }
-            else
+            messageHistory.push(note, maxMessageHistory);
+
+            if (recvMode)
             {
-                // 过滤明显乱码（非 UTF-8）以避免屏幕刷屏
-                if (!looksLikeUtf8(msg))
-                {
-                    DEBUG_PRINT("Received garbled via HC-12, ignoring: ");
-                    DEBUG_PRINTLN(msg);
-                    incomingMessage = "<garbled ignored>";
-                    incomingMessageTime = millis();
-                    drawUI();
-                }
-                else
-                {
-                    String note = "RCV: " + msg;
-                    DEBUG_PRINT("Received via HC-12: ");
-                    DEBUG_PRINTLN(msg);
-                    // 将收到的消息加入历史
-                    messageHistory.push_back(note);
-                    if (messageHistory.size() > maxMessageHistory)
-                        messageHistory.erase(messageHistory.begin());
-
-                    if (recvMode)
-                    {
-                        // 在接收/聊天模式中，保持历史在界面上（不使用短暂 incomingMessage）
-                        // 新消息到来时自动切换到最新页
-                        chatPage = 0;
-                    }
-                    else
-                    {
-                        // 在发送模式下，显示短暂提示
-                        incomingMessage = note;
-                        incomingMessageTime = millis();
-                    }
-                    drawUI();
-                }
+                // 在接收/聊天模式中，保持历史在界面上（不使用短暂 incomingMessage）
+                // 新消息到来时自动切换到最新页
+                chatShowPage(0);
             }
+            drawUI();
         }
     }
+}
 
-    // 定期刷新显示（防止没有按键时屏幕静止）
-    if (millis() - lastDisplayUpdate > DISPLAY_INTERVAL)
+// 分发键盘事件：按下交给按键处理；长按重复与松开只用于聊天翻页
+void handleKeyEvent(const KeyEvent &ev)
+{
+    TraceScope trace(TR_KEY, (uint8_t)ev.key);
+    STALL_SECTION("key");
+    if (ev.type == KEY_EV_PRESS)
     {
-        lastDisplayUpdate = millis();
-        drawUI();
+        handleKeypress(ev.key, ev.timeMs);
+        return;
     }
+    if (ev.key != lastChatNavKey)
+        return;
 
-    // 聊天翻页长按与重复处理
-    if (lastChatNavKey != 0 && recvMode)
+    if (ev.type == KEY_EV_RELEASE || !recvMode)
     {
-        // 如果按键仍在按下，则根据时间执行重复或跳转
-        bool stillPressed = false;
-        // 尝试使用 Keypad 库的 isPressed（若不可用，编译会报错并修正）
-        stillPressed = keypad.isPressed(lastChatNavKey);
+        // 按键已释放，停止导航并恢复完整布局
+        lastChatNavKey = 0;
+        chatNavDir = 0;
+        if (chatFullscreen)
+        {
+            chatFullscreen = false;
+            drawUI();
+        }
+        return;
+    }
 
-        unsigned long now = millis();
-        if (stillPressed)
+    // 长按重复：首个重复事件在 KEY_REPEAT_DELAY_MS 后到来，此后每 KEY_REPEAT_INTERVAL_MS 一次
+    if (chatNavDir == 0)
+        return; // 已跳转，等待松开
+    unsigned long held = ev.timeMs - chatNavPressTime;
+    if (held >= CHAT_NAV_JUMP_THRESHOLD)
+    {
+        // 超过跳转阈值，直接跳到最早或最新
+        if (chatNavDir > 0)
         {
-            // 如果超过跳转阈值，直接跳到最早或最新
-            if ((now - chatNavLast) >= CHAT_NAV_JUMP_THRESHOLD)
-            {
-                if (chatNavDir > 0)
-                {
-                    // 跳到最早页
-                    int pageSize = chatPageSize;
-                    int totalMsgs = (int)messageHistory.size();
-                    int totalPages = (totalMsgs + pageSize - 1) / pageSize;
-                    if (totalPages <= 0)
-                        totalPages = 1;
-                    chatPage = totalPages - 1;
-                    chatJumpMsg = "已跳转到最旧";
-                }
-                else if (chatNavDir < 0)
-                {
-                    // 跳到最新页
-                    chatPage = 0;
-                    chatJumpMsg = "已跳转到最新";
-                }
-                // 更新时间以避免重复触发，并记录提示显示时间
-                chatNavLast = now;
-                chatJumpMsgTime = now;
-                drawUI();
-            }
-            else if ((now - chatNavLast) >= ((chatNavLast == 0) ? CHAT_NAV_INITIAL_DELAY : CHAT_NAV_REPEAT))
-            {
-                // 重复翻页
-                if (chatNavDir > 0)
-                {
-                    chatPage++;
-                }
-                else if (chatNavDir < 0)
-                {
-                    if (chatPage > 0)
-                        chatPage--;
-                }
-                chatNavLast = now;
-                drawUI();
-            }
+            chatShowPage(chatTotalPages() - 1);
+            chatJumpMsg = "已跳转到最旧";
         }
         else
         {
-            // 按键已释放，停止导航
-            lastChatNavKey = 0;
-            chatNavDir = 0;
-            chatNavLast = 0;
+            chatShowPage(0);
+            chatJumpMsg = "已跳转到最新";
         }
+        // 跳转后直到松开前不再滚动，并记录提示显示时间
+        chatNavDir = 0;
+        chatFullscreen = false;
+        chatJumpMsgTime = millis();
     }
-
-    // 空闲超时检测（进入低功耗）
-    if (!lowPowerMode && (millis() - lastActivityTime) > IDLE_TIMEOUT_MS)
+    else
     {
-        enterLowPowerMode();
+        // 平滑滚动一步（CHAT_SCROLL_STEP_PX 为 8 的倍数，由控制器完成位移）
+        if (chatMaxScrollPx() > 0)
+            chatFullscreen = true;
+        chatScrollBy(chatNavDir * (int)CHAT_SCROLL_STEP_PX);
     }
-
-    delay(20); // 小延迟用于去抖与减轻 CPU 占用
+    drawUI();
 }
 
-// 处理串口控制台输入（按行），默认以 AT 模式发送指令；若响应包含 "ERROR" 则改为通信模式发送原始数据
-void handleSerialConsoleInput()
+void loop()
 {
-    while (Serial.available())
-    {
-        char c = (char)Serial.read();
-        // 支持回车或换行作为命令结束
-        if (c == '\r' || c == '\n')
-        {
-            if (serialCmdBuffer.length() == 0)
-                continue; // 忽略空行
+    uint32_t loopStartUs = micros();
+    uint32_t allocsAtStart = allocCountUi();
+    stallLoopBegin();
 
-            String cmd = serialCmdBuffer;
-            serialCmdBuffer = "";
+    // 处理键盘任务送来的按键事件
+    KeyEvent ev;
+    while (inputReceive(ev))
+    {
+        powerEventHandled(WAKE_KEY);
+        uiDirty = true; // 若处理中已重绘则会被清除
+        handleKeyEvent(ev);
+    }
 
-            // 有串口交互，更新活动时间并唤醒
-            updateLastActivity();
-            // 在串口打印接收到的命令
-            DEBUG_PRINT("Console cmd: ");
-            DEBUG_PRINTLN(cmd);
+    // 处理来自 PC 串口的命令输入
+    consolePoll();
 
-            // 支持本地命令：?RIP 或 RIP? 显示当前 RIP 路由摘要（不发送到 HC-12）
-            if (cmd == "?RIP" || cmd == "RIP?")
-            {
-                String rs = ripGetRoutesSummary();
-                Serial.println(rs);
-                incomingMessage = rs;
-                incomingMessageTime = millis();
-                drawUI();
-            }
-            else
-            {
-                // 先以 AT 模式发送，并读回响应
-                String response = hc12.sendATCommand(cmd, 800);
-                DEBUG_PRINT("AT response: ");
-                DEBUG_PRINTLN(response);
-
-                // 如果响应包含 ERROR（不区分大小写），则切换到通信模式发送原始命令内容
-                String upperResp = response;
-                upperResp.toUpperCase();
-                if (upperResp.indexOf("ERROR") >= 0)
-                {
-                    DEBUG_PRINTLN("AT returned ERROR, sending in communication mode...");
-                    // 以通信模式发送原始命令字符串
-                    bool ok = hc12.sendData(cmd);
-                    DEBUG_PRINT("Comm send: ");
-                    DEBUG_PRINT(ok ? "OK" : "FAIL");
-                    DEBUG_PRINT(" -> ");
-                    DEBUG_PRINTLN(cmd);
-
-                    incomingMessage = String(ok ? "Sent(CMD): " : "SendFail: ") + cmd;
-                    incomingMessageTime = millis();
-                    updateLastActivity();
-                }
-                else
-                {
-                    // 显示 AT 响应
-                    incomingMessage = "AT-> " + response;
-                    incomingMessageTime = millis();
-                    updateLastActivity();
-                }
-            }
+    // 后台词库加载完成：为正在输入的拼音补出候选词
+    static bool dictWasReady = false;
+    if (!dictWasReady && dictionaryReady())
+    {
+        dictWasReady = true;
+        if (composing)
+        {
+            int keep = candidateIndex; // 深度睡眠恢复的选中位置
+            updateCandidates();
+            if (keep < (int)candidates.size())
+                candidateIndex = keep;
+        }
+        uiDirty = true;
+    }
 
-            // 同步更新 UI
-            drawUI();
+    // 后台 HC-12 检测结束：配置 UART 唤醒并提示波特率
+    static bool radioWasReady = false;
+    if (!radioWasReady && radioBootDone)
+    {
+        radioWasReady = true;
+        powerInit(HC12_UART_NUM, HC12_RX_PIN);
+        if (radioBootOk && !resumeBoot)
+        {
+            showBaudToast();
+            uiDirty = true;
         }
+    }
+
+    // 处理无线任务收到的数据与 AT 响应
+    RadioFrame frame;
+    while (radioReceive(frame))
+    {
+        if (frame.kind == RADIO_FRAME_AT && frame.atFn)
+            settingsAtResponse(frame.atFn, frame.data);
+        else if (frame.kind == RADIO_FRAME_AT)
+            consoleAtResponse(frame.data);
         else
         {
-            // 组成命令行（回显可选）
-            serialCmdBuffer += c;
+            powerEventHandled(WAKE_UART);
+            handleRadioFrame(frame.data, frame.len);
         }
     }
+
+    // 执行到期的定时任务（RIP、空闲超时、限时内容到期）
+    uint32_t nextMs = schedRunDue();
+
+    if (uiDirty)
+        drawUI();
+    uint32_t loopUs = micros() - loopStartUs;
+    metricTime(MT_LOOP, loopUs);
+    stallLoopEnd(loopUs);
+    allocLoopEnd(allocsAtStart);
+
+    // 低功耗且各任务空闲：浅睡眠到下一个截止时刻，UART RX 或按键提前唤醒
+    if (lowPowerMode && tasksIdle() && !xferActive() && powerMaySleep())
+    {
+        if (powerLightSleep(min(nextMs, (uint32_t)LIGHT_SLEEP_MAX_MS)) != WAKE_NONE)
+            return; // 醒来后立即处理事件
+    }
+
+    // 睡眠到下一个事件（按键、无线数据、串口输入）或下一个截止时刻
+    uiWaitEvent(min(nextMs, (uint32_t)UI_WAIT_MAX_MS));
 }
@@ -0,0 +1,32 @@
+// mem_place.cpp
+// 按能力分配内部 SRAM / PSRAM
+
+#include "mem_place.h"
+#include <esp_heap_caps.h>
+
+bool memPsramAvailable()
+{
+    return heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+}
+
+void *memAlloc(size_t bytes, MemPlace want, MemPlace *got)
+{
+    void *p = nullptr;
+    MemPlace at = MEM_INTERNAL;
+    if (want == MEM_PSRAM)
+    {
+        p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (p)
+            at = MEM_PSRAM;
+    }
+    if (!p)
+        p = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (got)
+        *got = at;
+    return p;
+}
+
+const char *memPlaceName(MemPlace p)
+{
+    return p == MEM_PSRAM ? "psram" : "internal";
+}
@@ -0,0 +1,60 @@
+// mem_place.h
+// 内存放置：大而冷的数据（词库汉字区、消息历史正文）放 PSRAM，热索引（拼音表、历史索引）留在内部 SRAM。
+//
+// 开启 PSRAM（ESP32-S3 环境的 -DBOARD_HAS_PSRAM）后，Arduino 让超过 4 KB 的普通 malloc 自动落到
+// PSRAM，热索引反而可能被放到较慢的外部 RAM；因此这里显式按能力分配，不依赖大小阈值。
+// 没有 PSRAM 时 MEM_PSRAM 的请求退回内部 RAM，调用方可由 got 得知实际位置（例如缩小容量）。
+// 控制台 `membench` 比较各放置方式下的查找延迟。
+
+#ifndef WM_MEM_PLACE_H
+#define WM_MEM_PLACE_H
+
+#include <Arduino.h>
+#include <cstddef>
+
+enum MemPlace : uint8_t
+{
+    MEM_INTERNAL, // 内部 SRAM：访问快，与协议栈、FreeRTOS 共用
+    MEM_PSRAM     // 外部 PSRAM：容量大，经 cache 访问，未命中时慢一个数量级
+};
+
+bool memPsramAvailable();
+
+// 按放置要求分配（8 位可访问）；PSRAM 不可用或已满时退回内部 RAM。got 非空时写入实际位置。
+// 用 free() 释放
+void *memAlloc(size_t bytes, MemPlace want, MemPlace *got = nullptr);
+
+const char *memPlaceName(MemPlace p);
+
+// 把标准容器固定在指定位置的分配器，例如 std::vector<T, PlacedAllocator<T, MEM_INTERNAL>>
+template <class T, MemPlace P>
+struct PlacedAllocator
+{
+    typedef T value_type;
+
+    PlacedAllocator() = default;
+    template <class U>
+    PlacedAllocator(const PlacedAllocator<U, P> &) {}
+
+    template <class U>
+    struct rebind
+    {
+        typedef PlacedAllocator<U, P> other;
+    };
+
+    T *allocate(size_t n)
+    {
+        void *p = memAlloc(n * sizeof(T), P);
+        if (!p)
+            abort(); // 与默认分配器失败时一致（固件不启用异常）
+        return static_cast<T *>(p);
+    }
+    void deallocate(T *p, size_t) { free(p); }
+};
+
+template <class T, class U, MemPlace P>
+bool operator==(const PlacedAllocator<T, P> &, const PlacedAllocator<U, P> &) { return true; }
+template <class T, class U, MemPlace P>
+bool operator!=(const PlacedAllocator<T, P> &, const PlacedAllocator<U, P> &) { return false; }
+
+#endif // WM_MEM_PLACE_H
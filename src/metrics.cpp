@@ -0,0 +1,72 @@
+// metrics.cpp
+// 计数与耗时统计实现
+
+#include "metrics.h"
+#include "app_tasks.h"
+#include "rip.h"
+
+uint32_t metricCounters[MC_COUNT];
+static TimerStat timers[MT_COUNT];
+
+static const char *const COUNTER_NAMES[MC_COUNT] = {
+    "rx bytes", "rx frames", "rx dropped", "rx garbled", "rx ignored",
+    "tx bytes", "tx frames", "tx failed",
+    "uart overrun", "uart error",
+    "rip sent", "rip recv", "tlm sent", "tlm recv", "log dropped",
+    "heap allocs", "ui allocs", "loop allocs", "loop stalls",
+    "rx auth fail", "rx replay", "ks pool hit", "ks pool miss",
+    "rx duplicate", "rx tag conflict"};
+
+static const char *const TIMER_NAMES[MT_COUNT] = {"at command", "candidates", "loop"};
+
+void metricTime(MetricTimer t, uint32_t us)
+{
+    TimerStat &s = timers[t];
+    s.count++;
+    s.lastUs = us;
+    s.sumUs += us;
+    if (us > s.maxUs)
+        s.maxUs = us;
+}
+
+const TimerStat &metricTimer(MetricTimer t)
+{
+    return timers[t];
+}
+
+void metricsReset()
+{
+    for (size_t i = 0; i < MC_COUNT; i++)
+        __atomic_store_n(&metricCounters[i], 0, __ATOMIC_RELAXED);
+    memset(timers, 0, sizeof(timers));
+}
+
+void metricsPrint()
+{
+    Serial.printf("uptime %lu s, heap free %lu, min free %lu\n", (unsigned long)(millis() / 1000),
+                  (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap());
+    for (size_t i = 0; i < MC_COUNT; i++)
+        Serial.printf("%-14s %lu\n", COUNTER_NAMES[i], (unsigned long)metricGet((MetricCounter)i));
+    for (size_t i = 0; i < MT_COUNT; i++)
+    {
+        const TimerStat &s = timers[i];
+        uint32_t avg = s.count ? (uint32_t)(s.sumUs / s.count) : 0;
+        Serial.printf("%-14s n=%lu last=%lu avg=%lu max=%lu us\n", TIMER_NAMES[i], (unsigned long)s.count,
+                      (unsigned long)s.lastUs, (unsigned long)avg, (unsigned long)s.maxUs);
+    }
+}
+
+bool metricsSendTelemetry()
+{
+    char buf[160];
+    snprintf(buf, sizeof(buf), "TLM|%s|up=%lu,rx=%lu,tx=%lu,bad=%lu,drop=%lu,ovr=%lu,heap=%lu,minheap=%lu,loop=%lu",
+             ripSelfId().c_str(), (unsigned long)(millis() / 1000), (unsigned long)metricGet(MC_RX_FRAMES),
+             (unsigned long)metricGet(MC_TX_FRAMES), (unsigned long)metricGet(MC_RX_GARBLED),
+             (unsigned long)metricGet(MC_RX_DROPPED), (unsigned long)metricGet(MC_UART_OVERRUN),
+             (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(),
+             (unsigned long)timers[MT_LOOP].maxUs);
+    if (!radioSend(buf, strlen(buf)))
+        return false;
+    metricInc(MC_TLM_SENT);
+    return true;
+}
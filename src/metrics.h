@@ -0,0 +1,99 @@
+// metrics.h
+// 运行计数与耗时统计：集中登记，控制台 `stats` 查询，可选以 TLM| 帧广播
+//
+// 计数器为 32 位原子加（ESP32 上是一条 S32C1I 比较交换循环，不关中断、不加锁），
+// 可在无线任务的接收路径、UART 事件回调等任意任务中调用。
+// 耗时统计每项只有一个写入者（AT：HC-12 总线锁内；候选词与 loop：UI 任务），不加锁；
+// 读取方可能看到字段之间不一致的瞬间值，用于观测足够。
+
+#ifndef WM_METRICS_H
+#define WM_METRICS_H
+
+#include <Arduino.h>
+
+enum MetricCounter : uint8_t
+{
+    MC_RX_BYTES,     // HC-12 收到的负载字节（去掉唤醒前导）
+    MC_RX_FRAMES,    // 交给 UI 任务的帧（每入队一帧计一次）
+    MC_RX_DROPPED,   // 接收队列满而丢弃的帧
+    MC_RX_GARBLED,   // 非 UTF-8 而丢弃的帧
+    MC_RX_IGNORED,   // 被消费但无效果的控制帧（格式错误或未知命令的 RIP 报文）
+    MC_TX_BYTES,
+    MC_TX_FRAMES,
+    MC_TX_FAILED,    // 发送队列满或 HC-12 发送失败
+    MC_UART_OVERRUN, // HC-12 UART 硬件 FIFO 或驱动缓冲溢出
+    MC_UART_ERROR,   // 帧错误、校验错误、BREAK
+    MC_RIP_SENT,
+    MC_RIP_RECV,
+    MC_TLM_SENT,
+    MC_TLM_RECV,
+    MC_LOG_DROPPED,  // 日志队列满而丢弃的记录（logger.h）
+    MC_HEAP_ALLOCS,  // 堆分配次数（仅 WM_ALLOC_COUNT 构建，见 alloc_count.h）
+    MC_UI_ALLOCS,    // 其中发生在 UI 核上的
+    MC_LOOP_ALLOCS,  // 发生过堆分配的 loop() 轮数；稳态（无按键、无收发）下应保持不变
+    MC_LOOP_STALLS,  // 超过 STALL_BUDGET_MS 的 loop() 轮数（stall.h）
+    MC_RX_AUTH_FAIL, // 认证失败而丢弃的加密帧（radio_crypto.h）
+    MC_RX_REPLAY,    // 重放（seq 已收到、早于窗口或低于保存的下限）而丢弃的加密帧
+    MC_KS_HIT,       // 加密时整帧密钥流已在预计算池中
+    MC_KS_MISS,      // 池空或帧超出预计算长度，需现算密钥流
+    MC_RX_DUP,       // 重复帧缓存命中而丢弃的帧（转发或重传的副本，dup_cache.h）
+    MC_RX_TAG_CONFLICT, // 发送方标签已判定冲突（两个节点同标签）而丢弃的帧
+    MC_COUNT
+};
+
+enum MetricTimer : uint8_t
+{
+    MT_AT_CMD,     // AT 指令发出到最后一个响应字节
+    MT_CANDIDATES, // updateCandidates() 一次计算
+    MT_LOOP,       // loop() 一轮处理（不含等待与睡眠）
+    MT_COUNT
+};
+
+struct TimerStat
+{
+    uint32_t count;
+    uint32_t lastUs;
+    uint32_t maxUs;
+    uint64_t sumUs;
+};
+
+extern uint32_t metricCounters[MC_COUNT];
+
+static inline void metricInc(MetricCounter c, uint32_t n = 1)
+{
+    __atomic_fetch_add(&metricCounters[c], n, __ATOMIC_RELAXED);
+}
+
+static inline uint32_t metricGet(MetricCounter c)
+{
+    return __atomic_load_n(&metricCounters[c], __ATOMIC_RELAXED);
+}
+
+// 记录一次耗时（微秒）
+void metricTime(MetricTimer t, uint32_t us);
+
+const TimerStat &metricTimer(MetricTimer t);
+
+// 作用域计时：析构时记录耗时
+class MetricScope
+{
+public:
+    explicit MetricScope(MetricTimer t) : timer(t), start(micros()) {}
+    ~MetricScope() { metricTime(timer, micros() - start); }
+
+private:
+    MetricTimer timer;
+    uint32_t start;
+};
+
+// 清零所有计数与耗时
+void metricsReset();
+
+// 打印全部统计（含当前与历史最低空闲堆）到串口
+void metricsPrint();
+
+// 经无线任务广播一帧遥测（接收方只打印到串口，不进入消息历史）：
+//   TLM|<节点ID>|up=秒,rx=帧,tx=帧,bad=乱码,drop=丢弃,ovr=溢出,heap=空闲,minheap=最低,loop=最大us
+bool metricsSendTelemetry();
+
+#endif // WM_METRICS_H
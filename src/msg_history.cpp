@@ -0,0 +1,115 @@
+// msg_history.cpp
+// 消息历史环形正文区实现
+
+#include "msg_history.h"
+#include "logger.h"
+#include "utf8.h"
+#include <esp_timer.h>
+
+void MessageHistory::begin(size_t maxEntries, size_t psramBytes, size_t internalBytes)
+{
+    free(arena);
+    bool psram = memPsramAvailable();
+    cap = psram ? psramBytes : internalBytes;
+    arena = (char *)memAlloc(cap, psram ? MEM_PSRAM : MEM_INTERNAL, &place);
+    if (!arena)
+        cap = 0;
+    index.assign(maxEntries > 0 ? maxEntries : 1, Entry());
+    clear();
+    LOGI(LM_MAIN, "history: %u entries, %u byte arena in %s", maxEntries, cap, logStr(memPlaceName(place)));
+}
+
+const char *MessageHistory::operator[](size_t i) const
+{
+    return i < count ? arena + entry(i).off : "";
+}
+
+size_t MessageHistory::length(size_t i) const
+{
+    return i < count ? entry(i).len : 0;
+}
+
+void MessageHistory::clear()
+{
+    head = 0;
+    count = 0;
+    tail = 0;
+}
+
+void MessageHistory::dropOldest()
+{
+    head = (head + 1) % index.size();
+    count--;
+}
+
+void MessageHistory::push(const char *text, size_t len, size_t maxCount)
+{
+    if (cap == 0 || maxCount == 0)
+        return;
+    // 过长的消息在字符边界截断
+    len = utf8Floor(text, len, min(cap - 1, (size_t)0xFFFF));
+    while (count > 0 && (count >= maxCount || count >= index.size()))
+        dropOldest();
+    if (count == 0)
+        tail = 0;
+
+    // 新消息接在最新一条之后，区尾放不下则从头开始；被覆盖的总是最早的几条
+    size_t need = len + 1;
+    bool wrap = tail + need > cap;
+    size_t pos = wrap ? 0 : tail;
+    while (count > 0)
+    {
+        const Entry &e = entry(0);
+        bool inSkippedEnd = wrap && e.off >= tail; // 区尾剩余部分中的旧消息，绕回后排在新消息之后
+        bool overlaps = e.off < pos + need && e.off + e.len + 1 > pos;
+        if (!inSkippedEnd && !overlaps)
+            break;
+        dropOldest();
+    }
+
+    memcpy(arena + pos, text, len);
+    arena[pos + len] = '\0';
+    index[(head + count) % index.size()] = Entry{(uint32_t)pos, (uint16_t)len};
+    count++;
+    tail = pos + need;
+}
+
+size_t MessageHistory::usedBytes() const
+{
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++)
+        n += entry(i).len + 1;
+    return n;
+}
+
+size_t MessageHistory::spanBytes() const
+{
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++)
+        n = max(n, (size_t)entry(i).off + entry(i).len + 1);
+    return n;
+}
+
+uint32_t MessageHistory::benchReadNs(const char *base, uint32_t rounds) const
+{
+    if (count == 0 || rounds == 0)
+        return 0;
+    volatile uint32_t sink = 0;
+    int64_t t0 = esp_timer_get_time();
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+        // 从最新往前读，与聊天视口绘制的顺序一致
+        for (size_t i = count; i-- > 0;)
+        {
+            const Entry &e = entry(i);
+            const char *p = base + e.off;
+            uint32_t h = 0;
+            for (uint16_t k = 0; k < e.len; k++)
+                h += (uint8_t)p[k];
+            sink += h;
+        }
+    }
+    int64_t t1 = esp_timer_get_time();
+    (void)sink;
+    return (uint32_t)((t1 - t0) * 1000 / ((int64_t)rounds * count));
+}
@@ -0,0 +1,64 @@
+// msg_history.h
+// 消息历史：正文依次写入一块环形字节区（有 PSRAM 时放 PSRAM），每条的偏移与长度放在内部 RAM 的索引中。
+//
+// 取代原来的 std::vector<String>：不再每条消息一次堆分配，删除最早一条也不再整体搬移。
+// 追加时正文区放不下就从最早的消息开始丢弃；一条消息总是连续存放，写到区尾放不下时从头开始。
+// 只在 UI 任务中访问。
+
+#ifndef WM_MSG_HISTORY_H
+#define WM_MSG_HISTORY_H
+
+#include <Arduino.h>
+#include <vector>
+#include "mem_place.h"
+
+class MessageHistory
+{
+public:
+    // 分配索引（maxEntries 条，内部 RAM）与正文区（PSRAM 可用时 psramBytes，否则内部 RAM internalBytes）
+    void begin(size_t maxEntries, size_t psramBytes, size_t internalBytes);
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // 第 i 条（0 为最早），'\0' 结尾；越界返回 ""
+    const char *operator[](size_t i) const;
+    size_t length(size_t i) const;
+
+    // 追加一条；条数超过 maxCount 或正文区不足时丢弃最早的
+    void push(const char *text, size_t len, size_t maxCount);
+    void push(const String &text, size_t maxCount) { push(text.c_str(), text.length(), maxCount); }
+
+    void clear();
+
+    // 正文区容量、所在位置与已用字节数（含各条结尾的 '\0'）
+    size_t arenaBytes() const { return cap; }
+    MemPlace arenaPlace() const { return place; }
+    size_t usedBytes() const;
+    // 正文区中实际用到的前缀长度（最靠后一条的结尾）
+    size_t spanBytes() const;
+
+    // 按下标读取每一条所需的平均时间（ns），用于比较放置方式；arena 为正文区的副本
+    uint32_t benchReadNs(const char *arena, uint32_t rounds) const;
+    const char *arenaData() const { return arena; }
+
+private:
+    struct Entry
+    {
+        uint32_t off;
+        uint16_t len;
+    };
+
+    const Entry &entry(size_t i) const { return index[(head + i) % index.size()]; }
+    void dropOldest();
+
+    std::vector<Entry, PlacedAllocator<Entry, MEM_INTERNAL>> index; // 环形，head 为最早一条
+    size_t head = 0;
+    size_t count = 0;
+    char *arena = nullptr;
+    size_t cap = 0;
+    size_t tail = 0; // 最新一条之后的位置
+    MemPlace place = MEM_INTERNAL;
+};
+
+#endif // WM_MSG_HISTORY_H
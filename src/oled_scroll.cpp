@@ -0,0 +1,87 @@
+// oled_scroll.cpp
+// SSD1315 帧推送与硬件滚动实现
+//
+// 控制器 GDDRAM 共 8 页（每页 8 行 x 128 列）。显示起始行为 S 时，屏幕第 y 行显示 GDDRAM 第 (y + S) % 64 行。
+// 这里只允许 S 为 8 的倍数，于是屏幕第 p 页对应 GDDRAM 第 (p + S/8) % 8 页。
+// 模块保存一份 GDDRAM 影子副本：推送时把 u8g2 缓冲的每一页与它将要落到的 GDDRAM 页比较，
+// 相同则跳过。内容整体滚动 8 的倍数行时，先移动起始行，绝大部分页就已经在 GDDRAM 中就位，
+// 只有新露出的页（以及不随内容滚动的固定区域）需要经 I2C 重新写入。
+
+#include "oled_scroll.h"
+#include "trace.h"
+
+static const uint8_t OLED_PAGES = 8;
+static const uint8_t OLED_WIDTH = 128;
+
+static uint8_t shadow[OLED_PAGES][OLED_WIDTH]; // 按 GDDRAM 页存放控制器中的内容
+static bool shadowValid = false;
+static uint8_t startPage = 0;   // 当前显示起始行 / 8
+static bool startDirty = false; // 起始行已变更但尚未发送给控制器
+static uint8_t lastPushPages = 0;
+
+// 发送 SSD1315 “Set Display Start Line” 指令（0x40 | line）
+static void sendStartLine(uint8_t line)
+{
+    u8x8_t *u8x8 = u8g2.getU8x8();
+    u8x8_cad_StartTransfer(u8x8);
+    u8x8_cad_SendCmd(u8x8, 0x40 | (line & 0x3F));
+    u8x8_cad_EndTransfer(u8x8);
+}
+
+void oledScrollRows(int rows)
+{
+    if (rows == 0 || (rows % 8) != 0)
+        return;
+    int pages = (rows / 8) % OLED_PAGES;
+    if (pages < 0)
+        pages += OLED_PAGES;
+    startPage = (uint8_t)((startPage + pages) % OLED_PAGES);
+    startDirty = true;
+}
+
+void oledPushFrame()
+{
+    traceBegin(TR_OLED_PUSH);
+    uint8_t *buf = u8g2.getBufferPtr();
+
+    if (!shadowValid)
+    {
+        // 整帧传输：复位起始行后由 u8g2 按页顺序写入
+        startPage = 0;
+        startDirty = false;
+        sendStartLine(0);
+        u8g2.sendBuffer();
+        memcpy(shadow, buf, sizeof(shadow));
+        shadowValid = true;
+        lastPushPages = OLED_PAGES;
+        traceEnd(TR_OLED_PUSH, OLED_PAGES);
+        return;
+    }
+
+    if (startDirty)
+    {
+        sendStartLine(startPage * 8);
+        startDirty = false;
+    }
+
+    u8x8_t *u8x8 = u8g2.getU8x8();
+    const uint8_t tileW = u8g2.getBufferTileWidth();
+    uint8_t sent = 0;
+    for (uint8_t p = 0; p < OLED_PAGES; p++)
+    {
+        uint8_t ramPage = (uint8_t)((p + startPage) % OLED_PAGES);
+        uint8_t *src = buf + (size_t)p * OLED_WIDTH;
+        if (memcmp(shadow[ramPage], src, OLED_WIDTH) == 0)
+            continue;
+        u8x8_DrawTile(u8x8, 0, ramPage, tileW, src);
+        memcpy(shadow[ramPage], src, OLED_WIDTH);
+        sent++;
+    }
+    lastPushPages = sent;
+    traceEnd(TR_OLED_PUSH, sent);
+}
+
+uint8_t oledLastPushPages()
+{
+    return lastPushPages;
+}
@@ -0,0 +1,25 @@
+// oled_scroll.h
+// SSD1315 帧推送与硬件滚动子模块
+// 提供：按页（8 行）差分推送 u8g2 帧缓冲、利用控制器显示起始行实现整页硬件滚动
+
+#ifndef WM_OLED_SCROLL_H
+#define WM_OLED_SCROLL_H
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+
+// 将 u8g2 帧缓冲推送到 SSD1315，仅传输与控制器 GDDRAM 内容不同的页（替代 u8g2.sendBuffer()）
+void oledPushFrame();
+
+// 声明下一帧内容相对上一帧整体上移 rows 像素（负值为下移）。
+// rows 为 8 的倍数时通过设置显示起始行由控制器完成位移，随后的 oledPushFrame() 只需传输新露出的页；
+// 其它值被忽略（差分推送仍保证显示正确，只是没有节省）
+void oledScrollRows(int rows);
+
+// 统计：最近一次推送传输的页数（0..8），用于调试 I2C 流量
+uint8_t oledLastPushPages();
+
+// OLED 实例在 main.cpp 中定义
+extern U8G2_SSD1315_128X64_NONAME_F_HW_I2C u8g2;
+
+#endif // WM_OLED_SCROLL_H
@@ -0,0 +1,374 @@
+// power.cpp
+// 浅睡眠与能耗估算实现
+//
+// esp_light_sleep_start() 会暂停两个核上的所有任务，醒来后从调用处继续；esp_timer 与 millis()
+// 在睡眠期间由 RTC 时钟补偿。是否可以睡（队列为空、没有按住的键）由调用者判断。
+
+#include "power.h"
+#include "config.h"
+#include "logger.h"
+#include "keypad_scan.h"
+#include "trace.h"
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <driver/uart.h>
+#include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+
+static PowerStats stats;
+static bool uartWakeOk = false; // HC-12 的 RX 活动能唤醒（UART 唤醒或 RX 引脚 GPIO 唤醒）
+static int rxWakePin = -1;      // 改用 GPIO 唤醒时的 RX 引脚，-1 为 UART 唤醒
+static uint32_t holdUntil = 0;
+static PowerWake pendingWake = WAKE_NONE; // 尚未处理到事件的 UART/按键唤醒
+static int64_t wokeAtUs = 0;
+
+// 最近一次低功耗期（OLED 关闭期间），用于估算其平均电流
+static int64_t lowStartUs = 0;
+static uint64_t lowStartSleepUs = 0;
+static uint64_t lastLowUs = 0;
+static uint64_t lastLowSleepUs = 0;
+
+static void latencyAdd(WakeLatency &l, uint32_t us)
+{
+    l.count++;
+    l.lastUs = us;
+    l.sumUs += us;
+    if (us > l.maxUs)
+        l.maxUs = us;
+}
+
+// ESP32（经典款）的 UART 唤醒只在 RX 经 IO_MUX 直连时有效（UART0 为 GPIO3，UART1 为 GPIO9，后者是 flash 引脚）。
+// 经 GPIO 矩阵映射时唤醒 API 照样返回成功，却永远不会被 RX 唤醒
+static bool uartWakeUsable(int uartNum, int rxPin)
+{
+#if CONFIG_IDF_TARGET_ESP32
+    return (uartNum == 0 && rxPin == 3) || (uartNum == 1 && rxPin == 9);
+#else
+    return true;
+#endif
+}
+
+void powerInit(int uartNum, int rxPin)
+{
+    if (uartWakeUsable(uartNum, rxPin))
+    {
+        // 阈值为 RX 线上的上升沿数；前导字节 0x55 每字节有 4 个上升沿
+        uartWakeOk = uart_set_wakeup_threshold((uart_port_t)uartNum, 3) == ESP_OK &&
+                     esp_sleep_enable_uart_wakeup(uartNum) == ESP_OK;
+    }
+    else
+    {
+        // 改为 RX 引脚低电平唤醒（空闲为高，第一个起始位即唤醒），与按键共用 GPIO 唤醒源
+        rxWakePin = rxPin;
+        uartWakeOk = true;
+        LOGI(LM_POWER, "UART RX on GPIO%d is not on IO_MUX, waking on RX pin level", rxPin);
+    }
+    if (!uartWakeOk)
+        LOGW(LM_POWER, "UART wakeup not available, light sleep disabled");
+    esp_sleep_enable_gpio_wakeup();
+}
+
+bool powerMaySleep()
+{
+    return uartWakeOk && (int32_t)(millis() - holdUntil) >= 0;
+}
+
+PowerWake powerLightSleep(uint32_t maxMs)
+{
+    if (!powerMaySleep() || maxMs < LIGHT_SLEEP_MIN_MS)
+        return WAKE_NONE;
+
+    if (pendingWake != WAKE_NONE)
+    {
+        stats.wakeNoEvent++;
+        pendingWake = WAKE_NONE;
+    }
+
+    esp_sleep_enable_timer_wakeup((uint64_t)maxMs * 1000ULL);
+    keypadSleepPrepare();
+    if (rxWakePin >= 0)
+        gpio_wakeup_enable((gpio_num_t)rxWakePin, GPIO_INTR_LOW_LEVEL);
+    Serial.flush(); // 睡眠期间 UART0 时钟停止，未发完的调试输出会错乱
+
+    traceBegin(TR_SLEEP);
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = esp_light_sleep_start();
+    int64_t t1 = esp_timer_get_time();
+    traceResync(); // 睡眠期间周期计数器停止
+
+    if (rxWakePin >= 0)
+        gpio_wakeup_disable((gpio_num_t)rxWakePin);
+    bool keyHeld = keypadSleepResume();
+    if (err != ESP_OK)
+    {
+        traceEnd(TR_SLEEP);
+        return WAKE_NONE;
+    }
+
+    stats.sleeps++;
+    stats.sleepUs += (uint64_t)(t1 - t0);
+
+    PowerWake wake;
+    switch (esp_sleep_get_wakeup_cause())
+    {
+    case ESP_SLEEP_WAKEUP_TIMER:
+    {
+        wake = WAKE_TIMER;
+        stats.wakeTimer++;
+        int64_t late = (t1 - t0) - (int64_t)maxMs * 1000;
+        uint32_t lat = late > 0 ? (uint32_t)late : 0;
+        stats.lastLatencyUs = lat;
+        stats.latencySumUs += lat;
+        if (lat > stats.maxLatencyUs)
+            stats.maxLatencyUs = lat;
+        break;
+    }
+    case ESP_SLEEP_WAKEUP_UART:
+        wake = WAKE_UART;
+        stats.wakeUart++;
+        break;
+    case ESP_SLEEP_WAKEUP_GPIO:
+        // RX 走 GPIO 唤醒时与按键同一唤醒源：没有键按住即为 RX 起始位（按键远长于唤醒时间）
+        if (rxWakePin >= 0 && !keyHeld)
+        {
+            wake = WAKE_UART;
+            stats.wakeUart++;
+        }
+        else
+        {
+            wake = WAKE_KEY;
+            stats.wakeKey++;
+        }
+        break;
+    default:
+        wake = WAKE_OTHER;
+        break;
+    }
+
+    traceEnd(TR_SLEEP, wake);
+    if (wake == WAKE_UART || wake == WAKE_KEY)
+    {
+        holdUntil = millis() + LIGHT_SLEEP_RX_HOLD_MS;
+        pendingWake = wake;
+        wokeAtUs = t1;
+    }
+    return wake;
+}
+
+void powerEventHandled(PowerWake source)
+{
+    if (pendingWake == WAKE_NONE || pendingWake != source)
+        return;
+    uint32_t us = (uint32_t)(esp_timer_get_time() - wokeAtUs);
+    latencyAdd(source == WAKE_UART ? stats.uartHandle : stats.keyHandle, us);
+    pendingWake = WAKE_NONE;
+}
+
+const PowerStats &powerGetStats()
+{
+    return stats;
+}
+
+static void printHandleLatency(const char *name, const WakeLatency &l)
+{
+    uint32_t avg = l.count ? (uint32_t)(l.sumUs / l.count) : 0;
+    Serial.printf("[PWR] %s wake to handling: %lu times, last %lu us, avg %lu us, max %lu us\n", name,
+                  (unsigned long)l.count, (unsigned long)l.lastUs, (unsigned long)avg, (unsigned long)l.maxUs);
+}
+
+void powerPrintStats()
+{
+    uint32_t avgLat = stats.wakeTimer ? (uint32_t)(stats.latencySumUs / stats.wakeTimer) : 0;
+    Serial.printf("[PWR] light sleep: %lu times, %lu ms total; wake timer/uart/key %lu/%lu/%lu; "
+                  "timer wake latency avg %lu us, max %lu us\n",
+                  (unsigned long)stats.sleeps, (unsigned long)(stats.sleepUs / 1000),
+                  (unsigned long)stats.wakeTimer, (unsigned long)stats.wakeUart, (unsigned long)stats.wakeKey,
+                  (unsigned long)avgLat, (unsigned long)stats.maxLatencyUs);
+    printHandleLatency("uart", stats.uartHandle);
+    printHandleLatency("key", stats.keyHandle);
+    Serial.printf("[PWR] wakes without an event: %lu\n", (unsigned long)stats.wakeNoEvent);
+
+    // 最近一次低功耗期：浅睡眠 + HC-12 接收。按 POWER_MA_* 常数估算，不是实测（发送时间忽略）
+    if (lastLowUs == 0)
+        return;
+    float asleep = (float)lastLowSleepUs / (float)lastLowUs;
+    float estMa = POWER_MA_CPU_ACTIVE * (1.0f - asleep) + POWER_MA_CPU_SLEEP * asleep + POWER_MA_DISPLAY_OFF +
+                  POWER_MA_RADIO_RX;
+    Serial.printf("[PWR] last low-power period %.1f s, cpu asleep %.1f%%: estimated avg %.2f mA "
+                  "(from POWER_MA_* constants, not measured)\n",
+                  lastLowUs / 1e6, 100.0f * asleep, estMa);
+}
+
+void powerDeepSleep()
+{
+    // 浅睡眠用的 UART/GPIO 唤醒在深度睡眠中无效，只保留键盘的 EXT1 唤醒
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    keypadDeepSleepPrepare();
+    gpio_deep_sleep_hold_en();
+    Serial.flush();
+    esp_deep_sleep_start();
+}
+
+bool powerDeepSleepWoke()
+{
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_EXT1)
+        return false;
+    gpio_deep_sleep_hold_dis();
+    keypadDeepSleepRelease();
+    return true;
+}
+
+// --- 各状态时间与能耗估算 ---
+
+// 一个部件的状态时钟：当前状态从 sinceUs 开始，此前各状态的累计时间在 us[] 中
+struct StateClock
+{
+    uint8_t state;
+    int64_t sinceUs;
+    uint64_t us[RADIO_ST_COUNT];
+};
+
+static StateClock radioClock = {RADIO_ST_RX, 0, {}};
+static StateClock displayClock = {1, 0, {}}; // 0 关，1 开
+static int64_t energyStartUs = 0;
+static uint64_t sleepUsAtReset = 0;
+static portMUX_TYPE energyLock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const RADIO_STATE_NAMES[RADIO_ST_COUNT] = {"rx", "tx", "at", "sleep"};
+static const float RADIO_MA[RADIO_ST_COUNT] = {POWER_MA_RADIO_RX, POWER_MA_RADIO_TX, POWER_MA_RADIO_AT,
+                                               POWER_MA_RADIO_SLEEP};
+
+static void clockSet(StateClock &c, uint8_t state)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&energyLock);
+    if (c.state != state)
+    {
+        c.us[c.state] += (uint64_t)(now - c.sinceUs);
+        c.sinceUs = now;
+        c.state = state;
+    }
+    portEXIT_CRITICAL(&energyLock);
+}
+
+// 各状态累计时间（含当前状态已持续的部分）
+static void clockRead(const StateClock &c, uint64_t *out, size_t n, int64_t now)
+{
+    portENTER_CRITICAL(&energyLock);
+    for (size_t i = 0; i < n; i++)
+        out[i] = c.us[i];
+    out[c.state] += (uint64_t)(now - c.sinceUs);
+    portEXIT_CRITICAL(&energyLock);
+}
+
+void powerSetRadioState(PowerRadioState s)
+{
+    clockSet(radioClock, s);
+}
+
+void powerSetDisplayOn(bool on)
+{
+    clockSet(displayClock, on ? 1 : 0);
+    int64_t now = esp_timer_get_time();
+    if (!on)
+    {
+        lowStartUs = now;
+        lowStartSleepUs = stats.sleepUs;
+    }
+    else if (lowStartUs != 0)
+    {
+        lastLowUs = (uint64_t)(now - lowStartUs);
+        lastLowSleepUs = stats.sleepUs - lowStartSleepUs;
+        lowStartUs = 0;
+    }
+}
+
+// 一次快照：各部件各状态时间（us）
+struct EnergySnapshot
+{
+    uint64_t elapsedUs;
+    uint64_t cpuUs[2]; // 运行、浅睡眠
+    uint64_t displayUs[2]; // 关、开
+    uint64_t radioUs[RADIO_ST_COUNT];
+};
+
+static void energySnapshot(EnergySnapshot &s)
+{
+    int64_t now = esp_timer_get_time();
+    s.elapsedUs = (uint64_t)(now - energyStartUs);
+    s.cpuUs[1] = stats.sleepUs - sleepUsAtReset;
+    s.cpuUs[0] = s.elapsedUs > s.cpuUs[1] ? s.elapsedUs - s.cpuUs[1] : 0;
+    clockRead(displayClock, s.displayUs, 2, now);
+    clockRead(radioClock, s.radioUs, RADIO_ST_COUNT, now);
+}
+
+// us * mA -> uAh
+static float chargeUah(uint64_t us, float ma)
+{
+    return (float)us * ma / 3600000.0f;
+}
+
+static float totalUah(const EnergySnapshot &s)
+{
+    float uah = chargeUah(s.cpuUs[0], POWER_MA_CPU_ACTIVE) + chargeUah(s.cpuUs[1], POWER_MA_CPU_SLEEP) +
+                chargeUah(s.displayUs[0], POWER_MA_DISPLAY_OFF) + chargeUah(s.displayUs[1], POWER_MA_DISPLAY_ON);
+    for (size_t i = 0; i < RADIO_ST_COUNT; i++)
+        uah += chargeUah(s.radioUs[i], RADIO_MA[i]);
+    return uah;
+}
+
+uint32_t powerEnergyUah()
+{
+    EnergySnapshot s;
+    energySnapshot(s);
+    return (uint32_t)totalUah(s);
+}
+
+static void printStateLine(const char *part, const char *state, uint64_t us, uint64_t elapsedUs, float ma)
+{
+    Serial.printf("  %-8s %-7s %10.1f s %5.1f%% %8.3f mA %9.3f mAh\n", part, state, us / 1e6,
+                  elapsedUs ? 100.0 * us / elapsedUs : 0.0, ma, chargeUah(us, ma) / 1000.0f);
+}
+
+void powerPrintEnergy()
+{
+    EnergySnapshot s;
+    energySnapshot(s);
+    float uah = totalUah(s);
+    float hours = s.elapsedUs / 3.6e9f;
+    Serial.printf("[PWR] energy over %.1f s: %.3f mAh, avg %.2f mA\n", s.elapsedUs / 1e6, uah / 1000.0f,
+                  hours > 0 ? uah / 1000.0f / hours : 0.0f);
+    printStateLine("cpu", "active", s.cpuUs[0], s.elapsedUs, POWER_MA_CPU_ACTIVE);
+    printStateLine("cpu", "sleep", s.cpuUs[1], s.elapsedUs, POWER_MA_CPU_SLEEP);
+    printStateLine("display", "on", s.displayUs[1], s.elapsedUs, POWER_MA_DISPLAY_ON);
+    printStateLine("display", "off", s.displayUs[0], s.elapsedUs, POWER_MA_DISPLAY_OFF);
+    for (size_t i = 0; i < RADIO_ST_COUNT; i++)
+        printStateLine("radio", RADIO_STATE_NAMES[i], s.radioUs[i], s.elapsedUs, RADIO_MA[i]);
+}
+
+void powerLogEnergy()
+{
+    EnergySnapshot s;
+    energySnapshot(s);
+    uint32_t uah = (uint32_t)totalUah(s);
+    uint32_t secs = (uint32_t)(s.elapsedUs / 1000000);
+    uint32_t avgUa = secs ? (uint32_t)((uint64_t)uah * 3600 / secs) : 0;
+    uint32_t sleepPct = s.elapsedUs ? (uint32_t)(s.cpuUs[1] * 100 / s.elapsedUs) : 0;
+    LOGI(LM_POWER, "energy %lu uAh in %lu s, avg %lu uA, cpu asleep %lu%%", (unsigned long)uah, (unsigned long)secs,
+         (unsigned long)avgUa, (unsigned long)sleepPct);
+    LOGI(LM_POWER, "radio tx %lu ms, at %lu ms; display on %lu s", (unsigned long)(s.radioUs[RADIO_ST_TX] / 1000),
+         (unsigned long)(s.radioUs[RADIO_ST_AT] / 1000), (unsigned long)(s.displayUs[1] / 1000000));
+}
+
+void powerEnergyReset()
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&energyLock);
+    memset(radioClock.us, 0, sizeof(radioClock.us));
+    memset(displayClock.us, 0, sizeof(displayClock.us));
+    radioClock.sinceUs = now;
+    displayClock.sinceUs = now;
+    energyStartUs = now;
+    portEXIT_CRITICAL(&energyLock);
+    sleepUsAtReset = stats.sleepUs;
+}
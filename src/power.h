@@ -0,0 +1,113 @@
+// power.h
+// 低功耗：ESP32 浅睡眠（light sleep），HC-12 保持接收
+//
+// 低功耗模式下 OLED 关闭，HC-12 不再发送 AT+SLEEP（否则整机对网络失聪），
+// UI 任务在无事可做时调用 powerLightSleep() 进入浅睡眠，由以下事件唤醒：
+//   - HC-12 所在 UART 的 RX 活动（UART 唤醒；经典款 ESP32 上 RX 不在 IO_MUX 引脚时 UART 唤醒无效，
+//     改为 RX 引脚低电平的 GPIO 唤醒。触发唤醒的前几个字节会丢失，
+//     发送方因此在每帧前加唤醒前导，见 HC12_WAKE_PREAMBLE_LEN）
+//   - 键盘行引脚低电平（GPIO 唤醒）
+//   - 下一个调度截止时刻（定时器唤醒）
+//
+// 能耗估算：分别记录 HC-12（接收/发送/AT/睡眠）、OLED（开/关）与 CPU（运行/浅睡眠）在各状态的
+// 累计时间，乘以 config.h 中各状态电流（POWER_MA_*）估算 mAh。CPU 运行时间含 FreeRTOS 空闲
+// （WFI）；HC-12 发送时间按 UART 写出到 flush 完成计，空中速率低于串口波特率时会偏少。
+//
+// 唤醒到处理的延迟：UART/按键唤醒后，记录从 esp_light_sleep_start() 返回到 UI 任务取到第一帧数据
+// （含前导之后整帧的接收时间）或第一个按键事件的时间。退出低功耗时还按同一电流模型估算这段时间的
+// 平均电流（由 POWER_MA_* 常数算出，不是实测值）。
+
+#ifndef WM_POWER_H
+#define WM_POWER_H
+
+#include <Arduino.h>
+
+enum PowerWake : uint8_t
+{
+    WAKE_NONE,  // 未睡眠（条件不满足或睡眠失败）
+    WAKE_TIMER,
+    WAKE_UART,
+    WAKE_KEY,
+    WAKE_OTHER
+};
+
+// HC-12 状态（能耗统计用）
+enum PowerRadioState : uint8_t
+{
+    RADIO_ST_RX,    // 通信模式，收听/接收
+    RADIO_ST_TX,    // 发送
+    RADIO_ST_AT,    // AT 模式
+    RADIO_ST_SLEEP, // AT+SLEEP 之后
+    RADIO_ST_COUNT
+};
+
+// 唤醒到处理的延迟
+struct WakeLatency
+{
+    uint32_t count;
+    uint32_t lastUs;
+    uint32_t maxUs;
+    uint64_t sumUs;
+};
+
+struct PowerStats
+{
+    uint32_t sleeps;          // 进入浅睡眠次数
+    uint64_t sleepUs;         // 累计睡眠时间
+    uint32_t wakeTimer;       // 各唤醒源计数
+    uint32_t wakeUart;
+    uint32_t wakeKey;
+    uint32_t lastLatencyUs;   // 定时器唤醒：实际醒来时刻相对预定时刻的延迟
+    uint32_t maxLatencyUs;
+    uint64_t latencySumUs;    // 用于计算平均唤醒延迟（除以 wakeTimer）
+    WakeLatency uartHandle;   // UART 唤醒到 UI 任务取到第一帧数据
+    WakeLatency keyHandle;    // 按键唤醒到 UI 任务取到第一个按键事件
+    uint32_t wakeNoEvent;     // UART/按键唤醒后到下次睡眠都没有事件（噪声、帧不完整、按键抖动）
+};
+
+// 配置 HC-12 的 RX 唤醒（uartNum/rxPin 为 HC-12 使用的 UART 与 RX 引脚）：UART 唤醒只支持 UART0/1，
+// 经典款 ESP32 还要求 RX 在 IO_MUX 引脚上，否则改用 rxPin 的 GPIO 电平唤醒
+void powerInit(int uartNum, int rxPin);
+
+// 是否允许现在睡眠：UART/按键唤醒后保持清醒 LIGHT_SLEEP_RX_HOLD_MS，让整帧数据收完
+bool powerMaySleep();
+
+// 进入一次浅睡眠，最长 maxMs 毫秒；返回唤醒原因
+PowerWake powerLightSleep(uint32_t maxMs);
+
+// UI 任务取到一个事件时调用（WAKE_UART：收到的数据帧；WAKE_KEY：按键事件），
+// 若这是该来源唤醒后的第一个事件则记录唤醒到处理的延迟
+void powerEventHandled(PowerWake source);
+
+// 累计统计
+const PowerStats &powerGetStats();
+
+// 打印统计与最近一次低功耗期的平均电流对比到串口（退出低功耗模式时调用）
+void powerPrintStats();
+
+// --- 各状态时间与能耗估算 ---
+
+// 状态切换（HC12Module 与显示开关处调用；可在任意任务中调用）
+void powerSetRadioState(PowerRadioState s);
+void powerSetDisplayOn(bool on);
+
+// 自上次重置（或开机）以来的估算电量，单位 uAh
+uint32_t powerEnergyUah();
+
+// 打印各状态时间、电流与电量（控制台 `power`）
+void powerPrintEnergy();
+
+// 输出一行能耗摘要到日志（周期调用，见 POWER_REPORT_INTERVAL_MS）
+void powerLogEnergy();
+
+void powerEnergyReset();
+
+// --- 深度睡眠（见 rtc_state.h） ---
+
+// 只保留按键唤醒并进入深度睡眠，不返回；调用者先保存 RTC 快照、让 HC-12 睡眠并保持其 SET 引脚
+void powerDeepSleep();
+
+// 开机早期调用：由深度睡眠按键唤醒时释放睡眠期间保持的引脚并返回 true
+bool powerDeepSleepWoke();
+
+#endif // WM_POWER_H
@@ -0,0 +1,80 @@
+// radio_crypto.h
+// 无线帧认证加密：AES-128-CTR 加密 + 截断到 3 字节的 AES-CMAC（先加密后认证），每帧只多 7 字节。
+//
+// 空中格式（唤醒前导与 STX 之后，app_tasks.cpp 先加一个长度字节，接收方按它切分字节流）：
+//   seq     4 字节，小端；高 8 位为发送方节点标签，低 24 位为发送计数
+//   密文    与明文等长
+//   tag     3 字节，CMAC(K_mac, seq || 密文) 的前 3 字节
+//
+// - 密钥：config.h 的 RADIO_KEY 为全网共享的主密钥，开机时派生出加密密钥与认证密钥并展开一次；
+//   硬件路径把密钥装入 mbedtls 上下文（ESP32 上由 AES 外设执行），软件路径预先展开 44 个轮密钥字。
+//   RADIO_KEY 仍是公开的示例密钥时记录错误并关闭加密（明文收发）。
+// - 随机数：CTR 计数块由 seq 构成（节点标签 + 计数，即节点 ID 与序号派生），每个 seq 只用一次。
+//   发送计数保存在 NVS，每次按 RADIO_SEQ_RESERVE 预留一段，重启或深度睡眠后从预留段之后接着用，
+//   不会重复；首次使用时从随机位置开始。24 位计数用尽后停止发送（需更换密钥）。
+// - 节点标签：1..255，须在全网唯一，由 RADIO_NODE_TAG 或控制台 `radiotag`（存 NVS）配置；
+//   没有配置时记录错误并关闭加密。同一密钥下标签不可转给别的节点（计数可能重叠），需要时先换密钥。
+//   冲突是硬错误：本节点的标签出现在自己还没用到的计数上，或 RIP 更新表明同一标签属于两个节点 ID
+//   （cryptoCheckSender()），都会记录错误；此后该标签的帧计入 rx tag conflict 并丢弃，是本节点标签时停止发送。
+// - 防重放：每个发送方（按节点标签，最多 RADIO_REPLAY_PEERS 个）记录最大计数与其下 32 个的位图，
+//   重复或更早的帧丢弃。另为每个标签记录已接受的最大计数（下限），不在窗口中的发送方（首次见到、被挤出、
+//   本机重启后）低于下限的帧一律丢弃。下限在 RTC 内存中跨深度睡眠保持，在 NVS 中每 RADIO_FLOOR_SAVE_MS
+//   至多保存一次。剩余窗口：断电重启后，最后一次保存之后收到的帧可被重放一次；从未收到过的帧（例如
+//   本机关机期间的）可被补发一次。换密钥后下限清零。
+// - 先查重复帧缓存（dup_cache.h，命中即丢弃，不做认证），再校验 tag、查重放窗口、最后解密；
+//   校验失败与重放分别计入 `stats` 的 rx auth fail / rx replay。
+// - 密钥流池：无线任务空闲时为接下来 KEYSTREAM_POOL_FRAMES 个 seq 预先算好前 KEYSTREAM_POOL_BYTES 字节
+//   密钥流，发送时加密只剩异或（CMAC 依赖密文，仍在发送时计算）。整帧都在池中计入 ks pool hit，
+//   否则（池空或帧更长，超出部分现算）计入 ks pool miss。换密钥时池清空。
+//
+// RADIO_ENCRYPT 为 false 时明文收发（与旧固件互通）。所有节点的开关与密钥须一致。
+// 只在无线任务中加解密、补充密钥流池（开机阶段任务启动前的发送在 UI 任务中，此时无线任务尚未运行）。
+
+#ifndef WM_RADIO_CRYPTO_H
+#define WM_RADIO_CRYPTO_H
+
+#include <Arduino.h>
+
+constexpr size_t RADIO_CRYPTO_OVERHEAD = 7; // seq 4 + tag 3
+
+// 发送计数、防重放下限与节点标签所在的 NVS 命名空间
+constexpr const char *RADIO_NVS_NS = "radio";
+
+// 派生并展开密钥、从 NVS 恢复发送计数与防重放下限；nodeId 为本节点 RIP ID（ripInit() 之后调用）
+void cryptoInit(const char *nodeId);
+
+// 同上，使用指定的主密钥、节点标签与 NVS 命名空间（静态字符串）。测试用：传入独立的命名空间，
+// 不覆盖本机的发送计数与防重放下限。tag 为 0 或 key 为示例密钥时不启用加密
+void cryptoInitWith(const char *nodeId, const uint8_t key[16], uint8_t tag, const char *nvsNamespace = RADIO_NVS_NS);
+
+bool cryptoEnabled();
+
+// 加密并认证 plain[0..len)，写入 out（至少 len + RADIO_CRYPTO_OVERHEAD 字节）；返回帧长，
+// 计数用尽或本节点标签冲突时返回 0
+size_t cryptoSeal(const uint8_t *plain, size_t len, uint8_t *out);
+
+// 校验并解密一帧，明文写入 out[0..cap)，tag 非空时写入发送方标签；返回明文长度，
+// 太短、超过 cap、认证失败、重放或标签冲突时返回 -1
+int cryptoOpen(const uint8_t *frame, size_t len, uint8_t *out, size_t cap, uint8_t *tag = nullptr);
+
+// 标签为 tag 的帧中的 RIP 更新来自节点 id：绑定标签与节点，与已绑定的不同即为冲突（硬错误）。
+// 冲突时返回 false，该帧应丢弃
+bool cryptoCheckSender(uint8_t tag, const char *id, size_t len);
+
+// 补充密钥流池（无线任务每轮收发之后调用）
+void cryptoRefill();
+
+// 换用新的主密钥（至下次重启）；由无线任务在下次加解密前应用，同时清空密钥流池。未启用加密时返回 false
+bool cryptoRekey(const uint8_t key[16]);
+
+// 本节点标签（未启用加密时为配置值，0 为未配置）
+uint8_t cryptoNodeTag();
+
+// 把节点标签（1..255）存入 NVS，重启后生效；RADIO_NODE_TAG 不为 0 时以它为准
+bool cryptoSetNodeTag(uint8_t tag);
+
+// 比较硬件 AES 与软件 AES 在 16..256 字节负载上的 seal/open 耗时，以及密钥流已在池中时的 seal 耗时，
+// 打印到串口（控制台 `cryptobench`）
+void cryptoBench(uint32_t rounds);
+
+#endif // WM_RADIO_CRYPTO_H
@@ -2,6 +2,10 @@
 // 简易 RIP-like 协议实现（教学/模拟用途）
 
 #include "rip.h"
+#include "app_tasks.h"
+#include "metrics.h"
+#include "logger.h"
+#include "utf8.h"
 #include <esp_system.h>
 
 static std::vector<RouteEntry> routeTable;
@@ -28,34 +32,38 @@ static String generateSelfId()
 void ripInit()
 {
     routeTable.clear();
+    routeTable.reserve(RIP_MAX_ROUTES); // 之后增删路由不再分配
     lastUpdateTime = millis();
     if (selfId.length() == 0)
         selfId = generateSelfId();
-    Serial.print("RIP initialized, id=");
-    Serial.println(selfId);
+    LOGI(LM_RIP, "initialized, id=%s", logStr(selfId));
 }
 
-static void addOrUpdateRoute(const String &dest, uint16_t metric)
+// dest 为长度 len 的片段（不要求以 '\0' 结尾）；返回更新或新增的条目
+static RouteEntry &addOrUpdateRoute(const char *dest, size_t len, uint16_t metric)
 {
+    len = utf8Floor(dest, len, RIP_NODE_ID_MAX); // 过长的节点名在字符边界截断
     for (auto &e : routeTable)
     {
-        if (e.dest == dest)
+        if (strncmp(e.dest, dest, len) == 0 && e.dest[len] == '\0')
         {
             e.metric = metric;
             e.lastSeen = millis();
-            return;
+            return e;
         }
     }
     if (routeTable.size() >= RIP_MAX_ROUTES)
         routeTable.erase(routeTable.begin());
     RouteEntry ne;
-    ne.dest = dest;
+    memcpy(ne.dest, dest, len);
+    ne.dest[len] = '\0';
     ne.metric = metric;
     ne.lastSeen = millis();
     routeTable.push_back(ne);
+    return routeTable.back();
 }
 
-void ripLoop()
+uint32_t ripLoop()
 {
     unsigned long now = millis();
     // 老化
@@ -63,8 +71,7 @@ void ripLoop()
     {
         if (now - routeTable[i].lastSeen > ROUTE_TIMEOUT_MS)
         {
-            Serial.print("RIP: Removing stale route: ");
-            Serial.println(routeTable[i].dest);
+            LOGI(LM_RIP, "removing stale route %s", logStr(routeTable[i].dest));
             routeTable.erase(routeTable.begin() + i);
         }
     }
@@ -75,95 +82,135 @@ void ripLoop()
         ripSendUpdate();
         lastUpdateTime = now;
     }
+
+    // 下一次需要处理的时刻：下一次 UPDATE 或最早的路由过期
+    uint32_t next = UPDATE_INTERVAL_MS - (now - lastUpdateTime);
+    for (auto &e : routeTable)
+    {
+        uint32_t left = ROUTE_TIMEOUT_MS - (now - e.lastSeen) + 1;
+        if (left < next)
+            next = left;
+    }
+    return next;
 }
 
 // 格式： RIP|UPDATE|node1:metric,node2:metric
 void ripSendUpdate()
 {
-    String payload = "RIP|UPDATE|";
-    // 将本节点自身用唯一 ID 广播，metric=1
-    payload += selfId;
-    payload += ":1";
-    // 附带已知路由
+    // 将本节点自身用唯一 ID 广播，metric=1；附带已知路由，放不下一帧的条目本轮省略
+    char payload[RADIO_FRAME_MAX + 1];
+    int n = snprintf(payload, sizeof(payload), "RIP|UPDATE|%s:1", selfId.c_str());
     for (auto &e : routeTable)
     {
-        payload += ",";
-        payload += e.dest;
-        payload += ":";
-        payload += String(e.metric);
+        char item[RIP_NODE_ID_MAX + 8];
+        int m = snprintf(item, sizeof(item), ",%s:%u", e.dest, (unsigned)e.metric);
+        if (n + m >= (int)sizeof(payload))
+            break;
+        memcpy(payload + n, item, m + 1);
+        n += m;
     }
-    // 通过 HC-12 广播
-    hc12.setMode(HC12Module::COMM_MODE);
-    hc12.sendData(payload);
-    Serial.print("RIP: Sent UPDATE: ");
-    Serial.println(payload);
+    // 通过无线任务广播
+    bool ok = radioSend(payload, n);
+    if (ok)
+        metricInc(MC_RIP_SENT);
+    LOGD(LM_RIP, "update %d bytes, %u routes: %s", n, routeTable.size(), ok ? "queued" : "queue full");
 }
 
-bool ripHandlePacket(const String &packet, const String &from)
+bool ripHandlePacket(const char *packet, size_t len)
 {
-    if (!packet.startsWith("RIP|"))
+    if (len < 4 || memcmp(packet, "RIP|", 4) != 0)
         return false;
-    Serial.print("RIP: Handling packet: ");
-    Serial.println(packet);
+    LOGD(LM_RIP, "packet %u bytes", len);
 
     // 简单解析
     // RIP|UPDATE|node:metric,node2:metric
-    int p1 = packet.indexOf('|');
-    int p2 = packet.indexOf('|', p1 + 1);
-    if (p1 < 0 || p2 < 0)
+    const char *end = packet + len;
+    const char *cmd = packet + 4;
+    const char *p2 = (const char *)memchr(cmd, '|', end - cmd);
+    if (!p2)
+    {
+        metricInc(MC_RX_IGNORED);
         return true; // 吃掉格式不对的 RIP 报文
+    }
 
-    String cmd = packet.substring(p1 + 1, p2);
-    String body = packet.substring(p2 + 1);
-
-    if (cmd == "UPDATE")
+    if (p2 - cmd == 6 && memcmp(cmd, "UPDATE", 6) == 0)
     {
+        metricInc(MC_RIP_RECV);
         // body like node:metric,node:metric
-        int idx = 0;
-        while (idx < body.length())
+        const char *part = p2 + 1;
+        while (part < end)
         {
-            int comma = body.indexOf(',', idx);
-            String part;
-            if (comma < 0)
-            {
-                part = body.substring(idx);
-                idx = body.length();
-            }
-            else
+            const char *comma = (const char *)memchr(part, ',', end - part);
+            const char *partEnd = comma ? comma : end;
+            const char *colon = (const char *)memchr(part, ':', partEnd - part);
+            if (colon && colon > part)
             {
-                part = body.substring(idx, comma);
-                idx = comma + 1;
-            }
-            int colon = part.indexOf(':');
-            if (colon > 0)
-            {
-                String node = part.substring(0, colon);
-                String mstr = part.substring(colon + 1);
-                uint16_t metric = (uint16_t)mstr.toInt();
+                uint16_t metric = 0;
+                for (const char *d = colon + 1; d < partEnd && *d >= '0' && *d <= '9'; d++)
+                    metric = (uint16_t)(metric * 10 + (*d - '0'));
                 // 增加跳数惩罚（通过此节点传递 +1），但这里我们只把收到条目直接记录
-                addOrUpdateRoute(node, metric + 1);
-                Serial.print("RIP: Add/Update route: ");
-                Serial.print(node);
-                Serial.print(" metric=");
-                Serial.println(metric + 1);
+                addOrUpdateRoute(part, colon - part, metric + 1);
+                LOGD(LM_RIP, "route %s metric %u", logStr(part, colon - part), metric + 1);
             }
+            part = partEnd + 1;
         }
     }
+    else
+    {
+        metricInc(MC_RX_IGNORED);
+    }
 
     return true; // 已处理
 }
 
-String ripGetRoutesSummary()
+bool ripUpdateSender(const char *packet, size_t len, const char **id, size_t *idLen)
+{
+    static const char PREFIX[] = "RIP|UPDATE|";
+    const size_t n = sizeof(PREFIX) - 1;
+    if (len <= n || memcmp(packet, PREFIX, n) != 0)
+        return false;
+    // 第一项为发送方自身（metric 1），见 ripSendUpdate()
+    const char *colon = (const char *)memchr(packet + n, ':', len - n);
+    if (!colon || colon == packet + n)
+        return false;
+    *id = packet + n;
+    *idLen = colon - *id;
+    return true;
+}
+
+const String &ripSelfId()
+{
+    return selfId;
+}
+
+size_t ripFormatRoutesSummary(char *buf, size_t cap)
 {
-    String s = "RIP routes:";
+    if (cap == 0)
+        return 0;
+    size_t n = strlcpy(buf, "RIP routes:", cap);
     for (auto &e : routeTable)
     {
-        s += " ";
-        s += e.dest;
-        s += ":";
-        s += String(e.metric);
+        if (n >= cap - 1)
+            break;
+        int m = snprintf(buf + n, cap - n, " %s:%u", e.dest, (unsigned)e.metric);
+        n = min(n + (size_t)m, cap - 1);
     }
-    return s;
+    // snprintf 截断时可能切在多字节节点名中间
+    n = utf8Complete(buf, min(n, cap - 1));
+    buf[n] = '\0';
+    return n;
+}
+
+String ripGetRoutesSummary()
+{
+    char buf[RADIO_FRAME_MAX];
+    ripFormatRoutesSummary(buf, sizeof(buf));
+    return String(buf);
+}
+
+size_t ripRouteCount()
+{
+    return routeTable.size();
 }
 
 // 添加对 RIP 功能的完整实现
@@ -178,7 +225,15 @@ std::vector<RouteEntry> ripFetchAllRoutes()
 void ripClearRoutes()
 {
     routeTable.clear();
-    Serial.println("RIP: Route table cleared.");
+    LOGI(LM_RIP, "route table cleared");
+}
+
+bool ripRestoreRoute(const char *dest, uint16_t metric, uint32_t ageMs)
+{
+    if (ageMs >= ROUTE_TIMEOUT_MS)
+        return false;
+    addOrUpdateRoute(dest, strnlen(dest, RIP_NODE_ID_MAX), metric).lastSeen = millis() - ageMs;
+    return true;
 }
 
 // 定义一个函数，用于手动删除特定路由
@@ -186,11 +241,10 @@ bool ripRemoveRoute(const String &dest)
 {
     for (int i = 0; i < routeTable.size(); ++i)
     {
-        if (routeTable[i].dest == dest)
+        if (dest == routeTable[i].dest)
         {
             routeTable.erase(routeTable.begin() + i);
-            Serial.print("RIP: Removed route to ");
-            Serial.println(dest);
+            LOGI(LM_RIP, "removed route to %s", logStr(dest));
             return true;
         }
     }
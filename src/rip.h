@@ -9,10 +9,13 @@
 #include <vector>
 #include "HC12_Module.h"
 
+// 节点 ID 最大长度（本机为 12 位十六进制 MAC，更长的 ID 被截断）
+const size_t RIP_NODE_ID_MAX = 16;
+
 // 定义路由条目结构体，使其在全局范围内可见
 struct RouteEntry
 {
-    String dest;
+    char dest[RIP_NODE_ID_MAX + 1];
     uint16_t metric;
     unsigned long lastSeen; // millis()
 };
@@ -20,18 +23,31 @@ struct RouteEntry
 // 初始化 RIP 模块（定时器、路由表）
 void ripInit();
 
-// 在主循环中周期调用（发送更新、老化路由）
-void ripLoop();
+// 周期处理（发送更新、老化路由）；返回距下一次需要调用的毫秒数
+uint32_t ripLoop();
 
 // 处理收到的报文；如果是 RIP 报文则处理并返回 true（表示已消费），否则返回 false
-bool ripHandlePacket(const String &packet, const String &from = "");
+// 原地解析，不分配堆内存
+bool ripHandlePacket(const char *packet, size_t len);
+
+// RIP 更新报文的发送方节点 ID（第一项）；不是 UPDATE 时返回 false。id 指向 packet 内部
+bool ripUpdateSender(const char *packet, size_t len, const char **id, size_t *idLen);
 
 // 手动触发发送一次路由更新（用于调试/命令行）
 void ripSendUpdate();
 
+// 本节点 ID（由 MAC 派生，ripInit() 后有效）
+const String &ripSelfId();
+
 // 查询当前路由表的摘要（用于 UI/调试）
 String ripGetRoutesSummary();
 
+// 同上，写入 buf（超出部分截断），返回写入长度；供每帧重绘等热路径使用
+size_t ripFormatRoutesSummary(char *buf, size_t cap);
+
+// 当前路由条目数（邻居数；不复制路由表）
+size_t ripRouteCount();
+
 // 新增函数声明
 // 获取所有路由的详细信息
 std::vector<RouteEntry> ripFetchAllRoutes();
@@ -39,6 +55,9 @@ std::vector<RouteEntry> ripFetchAllRoutes();
 // 清空路由表
 void ripClearRoutes();
 
+// 恢复一条 ageMs 毫秒前最后见到的路由（深度睡眠唤醒后由 RTC 快照恢复）；已过期则忽略并返回 false
+bool ripRestoreRoute(const char *dest, uint16_t metric, uint32_t ageMs);
+
 // 手动删除特定路由
 bool ripRemoveRoute(const String &dest);
 
@@ -0,0 +1,190 @@
+// rtc_state.cpp
+// 深度睡眠快照实现
+
+#include "rtc_state.h"
+#include "config.h"
+#include "logger.h"
+#include "rip.h"
+#include "input_method/input_method.h"
+#include "utf8.h"
+#include <algorithm>
+#include <esp_attr.h>
+#include <esp_rom_crc.h>
+#include <sys/time.h>
+
+// 定义在 main.cpp
+extern bool recvMode;
+extern size_t maxMessageHistory;
+extern int chatPage;
+extern int chatPageSize;
+extern int chatScrollPx;
+extern bool chatFullscreen;
+extern bool rcvPersist;
+extern bool engUppercase;
+extern bool symbolMode;
+extern int candidateWindowStart;
+
+static const uint32_t RTC_MAGIC = 0x52544D57; // "WMTR"
+static const uint16_t RTC_VERSION = 1;
+
+struct RtcRoute
+{
+    char dest[RIP_NODE_ID_MAX + 1];
+    uint8_t metric;
+    uint32_t ageMs; // 睡眠时距上次见到的毫秒数
+};
+
+struct RtcSnapshot
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    int64_t sleptAtUs; // gettimeofday()：RTC 时钟在深度睡眠期间继续走
+
+    // HC-12
+    int32_t hc12Baud;
+    uint8_t hc12Ok;
+
+    // 输入法
+    uint8_t inputMode;
+    uint8_t composing;
+    uint8_t engUppercase;
+    uint8_t symbolMode;
+    int16_t candidateIndex;
+    int16_t candidateWindowStart;
+    char pinyin[RTC_PINYIN_MAX + 1];
+    char input[RTC_INPUT_MAX + 1];
+
+    // 聊天与接收设置
+    uint8_t recvMode;
+    uint8_t chatFullscreen;
+    uint8_t rcvPersist;
+    int16_t chatPage;
+    int16_t chatPageSize;
+    int32_t chatScrollPx;
+    uint16_t maxMessageHistory;
+
+    // 路由
+    uint8_t routeCount;
+    RtcRoute routes[RTC_ROUTES_MAX];
+
+    uint32_t crc; // 之前全部字段
+};
+
+RTC_DATA_ATTR static RtcSnapshot snap;
+static bool restoredRadioOk = false;
+static uint32_t restoredSleptMs = 0;
+
+static uint32_t snapshotCrc()
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)&snap, offsetof(RtcSnapshot, crc));
+}
+
+static int64_t wallUs()
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+void rtcStateSave(bool radioOk)
+{
+    memset(&snap, 0, sizeof(snap));
+    snap.magic = RTC_MAGIC;
+    snap.version = RTC_VERSION;
+    snap.size = sizeof(RtcSnapshot);
+
+    snap.hc12Baud = HC12_BAUD_RATE;
+    snap.hc12Ok = radioOk;
+
+    snap.inputMode = (uint8_t)inputMode;
+    snap.composing = composing;
+    snap.engUppercase = engUppercase;
+    snap.symbolMode = symbolMode;
+    snap.candidateIndex = (int16_t)candidateIndex;
+    snap.candidateWindowStart = (int16_t)candidateWindowStart;
+    utf8Copy(snap.pinyin, sizeof(snap.pinyin), pinyinBuffer.c_str(), pinyinBuffer.length());
+    utf8Copy(snap.input, sizeof(snap.input), inputBuffer.c_str(), inputBuffer.length());
+    if (inputBuffer.length() > RTC_INPUT_MAX)
+        LOGW(LM_MAIN, "rtc: input truncated to %u of %u bytes", strlen(snap.input), inputBuffer.length());
+
+    snap.recvMode = recvMode;
+    snap.chatFullscreen = chatFullscreen;
+    snap.rcvPersist = rcvPersist;
+    snap.chatPage = (int16_t)chatPage;
+    snap.chatPageSize = (int16_t)chatPageSize;
+    snap.chatScrollPx = chatScrollPx;
+    snap.maxMessageHistory = (uint16_t)maxMessageHistory;
+
+    // 只保留最近见到的路由：更早的条目醒来时多半已过期
+    std::vector<RouteEntry> routes = ripFetchAllRoutes();
+    unsigned long now = millis();
+    std::sort(routes.begin(), routes.end(), [](const RouteEntry &a, const RouteEntry &b)
+              { return (long)(a.lastSeen - b.lastSeen) > 0; });
+    for (const RouteEntry &e : routes)
+    {
+        if (snap.routeCount >= RTC_ROUTES_MAX)
+            break;
+        RtcRoute &r = snap.routes[snap.routeCount++];
+        memcpy(r.dest, e.dest, sizeof(r.dest));
+        r.metric = (uint8_t)min<uint16_t>(e.metric, 0xFF);
+        r.ageMs = now - e.lastSeen;
+    }
+
+    snap.sleptAtUs = wallUs();
+    snap.crc = snapshotCrc();
+    LOGI(LM_MAIN, "rtc: saved %u bytes, %u routes, input %u bytes", sizeof(snap), snap.routeCount,
+         strlen(snap.input));
+}
+
+bool rtcStateRestore()
+{
+    if (snap.magic != RTC_MAGIC || snap.version != RTC_VERSION || snap.size != sizeof(RtcSnapshot) ||
+        snap.crc != snapshotCrc())
+        return false;
+    snap.magic = 0; // 只恢复一次
+
+    int64_t slept = wallUs() - snap.sleptAtUs;
+    restoredSleptMs = slept > 0 ? (uint32_t)min<int64_t>(slept / 1000, UINT32_MAX) : 0;
+    restoredRadioOk = snap.hc12Ok;
+    HC12_BAUD_RATE = snap.hc12Baud;
+
+    inputMode = (InputMode)snap.inputMode;
+    composing = snap.composing;
+    engUppercase = snap.engUppercase;
+    symbolMode = snap.symbolMode;
+    candidateIndex = snap.candidateIndex;
+    candidateWindowStart = snap.candidateWindowStart;
+    pinyinBuffer = snap.pinyin;
+    inputBuffer = snap.input;
+
+    recvMode = snap.recvMode;
+    chatFullscreen = snap.chatFullscreen;
+    rcvPersist = snap.rcvPersist;
+    chatPage = snap.chatPage;
+    chatPageSize = snap.chatPageSize;
+    chatScrollPx = snap.chatScrollPx;
+    maxMessageHistory = snap.maxMessageHistory;
+
+    size_t kept = 0;
+    for (uint8_t i = 0; i < snap.routeCount; i++)
+    {
+        const RtcRoute &r = snap.routes[i];
+        uint32_t age = r.ageMs + restoredSleptMs;
+        if (age >= r.ageMs && ripRestoreRoute(r.dest, r.metric, age))
+            kept++;
+    }
+    LOGI(LM_MAIN, "rtc: resumed after %u ms asleep, %u/%u routes still fresh, HC-12 at %d baud", restoredSleptMs,
+         kept, snap.routeCount, HC12_BAUD_RATE);
+    return true;
+}
+
+bool rtcStateRadioOk()
+{
+    return restoredRadioOk;
+}
+
+uint32_t rtcStateSleptMs()
+{
+    return restoredSleptMs;
+}
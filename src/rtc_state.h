@@ -0,0 +1,25 @@
+// rtc_state.h
+// 深度睡眠快照：进入深度睡眠前把关键状态写入 RTC 慢速内存（RTC_DATA_ATTR，深度睡眠期间保持），
+// 按键唤醒后 setup() 直接恢复，跳过设置加载与 HC-12 波特率检测，首帧在几十毫秒内画出。
+//
+// 快照内容：输入法模式与输入/拼音缓冲、聊天视口位置与接收设置、HC-12 波特率，
+// 以及最近见到的 RTC_ROUTES_MAX 条路由（恢复时按睡眠时长老化，已过期的丢弃）。
+// 快照带魔数、版本、长度与 CRC；恢复一次后即作废，断电或固件布局变化时自动失效。
+// 词库重新映射 flash 分区（见 pinyin_dict.h），字频与消息历史仍从 SPIFFS 加载。
+
+#ifndef WM_RTC_STATE_H
+#define WM_RTC_STATE_H
+
+#include <Arduino.h>
+
+// 采集当前状态写入快照（UI 任务，进入深度睡眠前调用）；radioOk 为 HC-12 当前是否可用
+void rtcStateSave(bool radioOk);
+
+// 快照有效时恢复各全局状态（含 HC12_BAUD_RATE 与路由，需在 ripInit() 之后调用）并返回 true
+bool rtcStateRestore();
+
+// 最近一次恢复的快照信息
+bool rtcStateRadioOk();
+uint32_t rtcStateSleptMs();
+
+#endif // WM_RTC_STATE_H
@@ -0,0 +1,197 @@
+// scheduler.cpp
+// 协作式定时调度器实现
+//
+// 任务存放在固定槽位中，最小堆只保存槽位下标并按截止时刻排序；每个槽位记录自己在堆中的位置，
+// 因此改期与取消都是 O(log n)。SchedId = (代数 << 8) | 槽位，槽位复用后旧 id 自动失效。
+// 时间比较使用有符号差值，millis() 回绕后仍然正确。
+
+#include "scheduler.h"
+
+struct SchedJob
+{
+    SchedFn fn;
+    void *arg;
+    uint32_t deadline;
+    uint32_t period; // 0 为一次性任务
+    uint32_t gen;
+    int8_t heapPos;  // -1 表示不在堆中（正在执行或空闲）
+    bool used;
+};
+
+static SchedJob jobs[SCHED_MAX_JOBS];
+static uint8_t heap[SCHED_MAX_JOBS];
+static uint8_t heapSize = 0;
+static uint32_t nextGen = 1;
+
+static bool before(uint8_t a, uint8_t b)
+{
+    return (int32_t)(jobs[a].deadline - jobs[b].deadline) < 0;
+}
+
+static void heapSet(uint8_t pos, uint8_t slot)
+{
+    heap[pos] = slot;
+    jobs[slot].heapPos = (int8_t)pos;
+}
+
+static void siftUp(uint8_t pos)
+{
+    uint8_t slot = heap[pos];
+    while (pos > 0)
+    {
+        uint8_t parent = (uint8_t)((pos - 1) / 2);
+        if (!before(slot, heap[parent]))
+            break;
+        heapSet(pos, heap[parent]);
+        pos = parent;
+    }
+    heapSet(pos, slot);
+}
+
+static void siftDown(uint8_t pos)
+{
+    uint8_t slot = heap[pos];
+    for (;;)
+    {
+        uint8_t child = (uint8_t)(pos * 2 + 1);
+        if (child >= heapSize)
+            break;
+        if (child + 1 < heapSize && before(heap[child + 1], heap[child]))
+            child++;
+        if (!before(heap[child], slot))
+            break;
+        heapSet(pos, heap[child]);
+        pos = child;
+    }
+    heapSet(pos, slot);
+}
+
+static void heapInsert(uint8_t slot)
+{
+    heapSet(heapSize, slot);
+    heapSize++;
+    siftUp((uint8_t)(heapSize - 1));
+}
+
+static void heapRemove(uint8_t slot)
+{
+    uint8_t pos = (uint8_t)jobs[slot].heapPos;
+    jobs[slot].heapPos = -1;
+    heapSize--;
+    if (pos == heapSize)
+        return;
+    uint8_t moved = heap[heapSize];
+    heapSet(pos, moved);
+    siftDown(pos);
+    siftUp((uint8_t)jobs[moved].heapPos);
+}
+
+// 校验 id 并返回槽位，无效时返回 -1
+static int slotOf(SchedId id)
+{
+    if (id < 0)
+        return -1;
+    int slot = id & 0xFF;
+    if (slot >= (int)SCHED_MAX_JOBS || !jobs[slot].used || jobs[slot].gen != ((uint32_t)id >> 8))
+        return -1;
+    return slot;
+}
+
+static SchedId addJob(uint32_t delayMs, uint32_t period, SchedFn fn, void *arg)
+{
+    for (uint8_t slot = 0; slot < SCHED_MAX_JOBS; slot++)
+    {
+        SchedJob &j = jobs[slot];
+        if (j.used)
+            continue;
+        j.used = true;
+        j.fn = fn;
+        j.arg = arg;
+        j.period = period;
+        j.deadline = millis() + delayMs;
+        j.gen = nextGen;
+        nextGen = (nextGen + 1) & 0x7FFFFF;
+        if (nextGen == 0)
+            nextGen = 1;
+        heapInsert(slot);
+        return (SchedId)((j.gen << 8) | slot);
+    }
+    return SCHED_INVALID;
+}
+
+SchedId schedAfter(uint32_t delayMs, SchedFn fn, void *arg)
+{
+    return addJob(delayMs, 0, fn, arg);
+}
+
+SchedId schedEvery(uint32_t periodMs, SchedFn fn, void *arg)
+{
+    if (periodMs == 0)
+        return SCHED_INVALID;
+    return addJob(periodMs, periodMs, fn, arg);
+}
+
+bool schedReschedule(SchedId id, uint32_t delayMs)
+{
+    int slot = slotOf(id);
+    if (slot < 0)
+        return false;
+    SchedJob &j = jobs[slot];
+    j.deadline = millis() + delayMs;
+    if (j.heapPos >= 0)
+    {
+        uint8_t pos = (uint8_t)j.heapPos;
+        siftDown(pos);
+        siftUp((uint8_t)j.heapPos);
+    }
+    else
+    {
+        // 在自身回调中改期：重新入堆
+        heapInsert((uint8_t)slot);
+    }
+    return true;
+}
+
+bool schedCancel(SchedId id)
+{
+    int slot = slotOf(id);
+    if (slot < 0)
+        return false;
+    if (jobs[slot].heapPos >= 0)
+        heapRemove((uint8_t)slot);
+    jobs[slot].used = false;
+    return true;
+}
+
+uint32_t schedRunDue()
+{
+    for (;;)
+    {
+        if (heapSize == 0)
+            return SCHED_NO_DEADLINE;
+        uint32_t now = millis();
+        uint8_t slot = heap[0];
+        int32_t left = (int32_t)(jobs[slot].deadline - now);
+        if (left > 0)
+            return (uint32_t)left;
+
+        SchedJob &j = jobs[slot];
+        uint32_t gen = j.gen;
+        heapRemove(slot);
+        j.fn(j.arg);
+
+        // 回调中可能已取消（槽位甚至被复用）或改期（已重新入堆）
+        if (!j.used || j.gen != gen || j.heapPos >= 0)
+            continue;
+        if (j.period == 0)
+        {
+            j.used = false;
+            continue;
+        }
+        j.deadline += j.period;
+        now = millis();
+        if ((int32_t)(j.deadline - now) <= 0)
+            j.deadline = now + j.period; // 落后超过一个周期：不补跑
+        heapInsert(slot);
+    }
+}
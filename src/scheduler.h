@@ -0,0 +1,34 @@
+// scheduler.h
+// 协作式定时调度器：固定容量最小堆，支持一次性与周期任务
+//
+// 只在 UI 任务（loop）中使用：回调在 schedRunDue() 内同步执行，回调中可以再调度、改期或取消
+// （包括取消自身）。schedRunDue() 返回距下一个截止时刻的毫秒数，供 loop 阻塞等待。
+
+#ifndef WM_SCHEDULER_H
+#define WM_SCHEDULER_H
+
+#include <Arduino.h>
+
+typedef void (*SchedFn)(void *arg);
+typedef int32_t SchedId;
+
+constexpr SchedId SCHED_INVALID = -1;
+constexpr size_t SCHED_MAX_JOBS = 16;
+constexpr uint32_t SCHED_NO_DEADLINE = 0xFFFFFFFFUL;
+
+// delayMs 毫秒后执行一次；容量用尽时返回 SCHED_INVALID
+SchedId schedAfter(uint32_t delayMs, SchedFn fn, void *arg = nullptr);
+
+// 每 periodMs 毫秒执行一次（首次在 periodMs 后）；周期按截止时刻累加，不随回调耗时漂移
+SchedId schedEvery(uint32_t periodMs, SchedFn fn, void *arg = nullptr);
+
+// 将仍在等待的任务改为 delayMs 毫秒后执行；任务已执行完（一次性）或已取消时返回 false
+bool schedReschedule(SchedId id, uint32_t delayMs);
+
+// 取消任务；id 无效或任务已结束时返回 false
+bool schedCancel(SchedId id);
+
+// 执行所有已到期的任务，返回距下一个截止时刻的毫秒数（无任务时为 SCHED_NO_DEADLINE）
+uint32_t schedRunDue();
+
+#endif // WM_SCHEDULER_H
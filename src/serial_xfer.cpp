@@ -0,0 +1,473 @@
+// serial_xfer.cpp
+// 串口批量传输实现（协议见 serial_xfer.h）
+//
+// 发送方最多保留 XFER_WINDOW 帧未确认；超时未收到新的累计确认则从最早未确认帧起全部重发。
+// GET 重发时按偏移重新读取文件，不需要缓存整个窗口。接收方只接受期望的下一帧，
+// 乱序或重复帧丢弃并重发当前 ACK。
+
+#include "serial_xfer.h"
+#include "config.h"
+#include "app_tasks.h"
+#include <SPIFFS.h>
+#include <esp_rom_crc.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static const uint8_t SYNC0 = 0x7E;
+static const uint8_t SYNC1 = 0xA5;
+static const uint8_t PROTOCOL_VERSION = 1;
+static const size_t PAYLOAD_MAX = XFER_CHUNK;
+
+struct XferFrame
+{
+    uint8_t type;
+    uint8_t seq;
+    uint16_t len;
+    uint8_t payload[PAYLOAD_MAX];
+};
+
+// 一次会话的累计统计，退出传输模式后打印
+struct XferStats
+{
+    uint32_t transfers;
+    uint32_t bytes;
+    uint32_t busyMs;    // 传输文件所用时间（不含命令间空闲）
+    uint32_t resent;    // 重发的数据帧
+    uint32_t badFrames; // CRC 错误或长度非法的帧
+};
+
+static volatile bool active = false;
+static uint32_t xferBaud = 0;
+static XferStats stats;
+
+// 帧缓冲较大，放在静态区而不是任务栈上
+static XferFrame rx;
+static bool rxPending = false; // rx 中已有一帧待命令循环处理
+static uint8_t txBuf[XFER_CHUNK];
+
+static uint8_t inBuf[256];
+static size_t inPos = 0;
+static size_t inLen = 0;
+
+// 读一个字节，deadline 前无数据返回 -1；批量从串口驱动取数，避免逐字节加锁
+static int readByte(uint32_t deadline)
+{
+    while (inPos >= inLen)
+    {
+        int avail = Serial.available();
+        if (avail > 0)
+        {
+            inLen = Serial.read(inBuf, min((size_t)avail, sizeof(inBuf)));
+            inPos = 0;
+            continue;
+        }
+        if ((int32_t)(millis() - deadline) >= 0)
+            return -1;
+        vTaskDelay(1);
+    }
+    return inBuf[inPos++];
+}
+
+static bool readFrame(XferFrame &f, uint32_t timeoutMs)
+{
+    uint32_t deadline = millis() + timeoutMs;
+    for (;;)
+    {
+        int c = readByte(deadline);
+        if (c < 0)
+            return false;
+        if (c != SYNC0)
+            continue;
+        do
+        {
+            c = readByte(deadline);
+        } while (c == SYNC0);
+        if (c < 0)
+            return false;
+        if (c != SYNC1)
+            continue;
+
+        uint8_t hdr[4];
+        for (size_t i = 0; i < sizeof(hdr); i++)
+        {
+            if ((c = readByte(deadline)) < 0)
+                return false;
+            hdr[i] = (uint8_t)c;
+        }
+        f.type = hdr[0];
+        f.seq = hdr[1];
+        f.len = (uint16_t)(hdr[2] | (hdr[3] << 8));
+        if (f.len > PAYLOAD_MAX)
+        {
+            stats.badFrames++;
+            continue;
+        }
+        for (size_t i = 0; i < f.len; i++)
+        {
+            if ((c = readByte(deadline)) < 0)
+                return false;
+            f.payload[i] = (uint8_t)c;
+        }
+        uint32_t got = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            if ((c = readByte(deadline)) < 0)
+                return false;
+            got |= (uint32_t)c << (8 * i);
+        }
+        uint32_t crc = esp_rom_crc32_le(0, hdr, sizeof(hdr));
+        crc = esp_rom_crc32_le(crc, f.payload, f.len);
+        if (crc != got)
+        {
+            stats.badFrames++;
+            continue;
+        }
+        return true;
+    }
+}
+
+static void sendFrame(uint8_t type, uint8_t seq, const uint8_t *payload, uint16_t len)
+{
+    uint8_t hdr[6] = {SYNC0, SYNC1, type, seq, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8)};
+    uint32_t crc = esp_rom_crc32_le(0, hdr + 2, 4);
+    crc = esp_rom_crc32_le(crc, payload, len);
+    uint8_t tail[4] = {(uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24)};
+    Serial.write(hdr, sizeof(hdr));
+    if (len)
+        Serial.write(payload, len);
+    Serial.write(tail, sizeof(tail));
+}
+
+static void sendAck(uint8_t seq)
+{
+    sendFrame(XFER_ACK, seq, nullptr, 0);
+}
+
+static void sendErr(const char *msg)
+{
+    sendFrame(XFER_ERR, 0, (const uint8_t *)msg, (uint16_t)strlen(msg));
+}
+
+static void sendSize(uint32_t size)
+{
+    uint8_t p[4] = {(uint8_t)size, (uint8_t)(size >> 8), (uint8_t)(size >> 16), (uint8_t)(size >> 24)};
+    sendFrame(XFER_SIZE, 0, p, sizeof(p));
+}
+
+// 把 payload 当作以 '\0' 结尾的路径取出
+static String payloadPath(const uint8_t *p, size_t len)
+{
+    String s;
+    s.concat((const char *)p, len);
+    return s;
+}
+
+// --- 发送（GET / LIST） ---
+
+// 数据来源：文件或内存中的文本（目录列表）
+struct XferSource
+{
+    File file;
+    const String *text;
+    size_t size;
+};
+
+static size_t sourceRead(XferSource &src, size_t off, uint8_t *buf, size_t n)
+{
+    if (src.text)
+    {
+        memcpy(buf, src.text->c_str() + off, n);
+        return n;
+    }
+    if (!src.file.seek(off))
+        return 0;
+    return src.file.read(buf, n);
+}
+
+// 按滑动窗口发送整个来源，最后一帧为空（结束帧）；成功返回 true
+static bool sendStream(XferSource &src)
+{
+    const uint32_t total = (src.size + XFER_CHUNK - 1) / XFER_CHUNK + 1;
+    uint32_t base = 0; // 已确认的帧数
+    uint32_t next = 0; // 下一帧序号
+    int retries = 0;
+
+    while (base < total)
+    {
+        while (next < total && next - base < XFER_WINDOW)
+        {
+            size_t off = (size_t)next * XFER_CHUNK;
+            size_t n = next == total - 1 ? 0 : min((size_t)XFER_CHUNK, src.size - off);
+            if (n && sourceRead(src, off, txBuf, n) != n)
+            {
+                sendErr("read failed");
+                return false;
+            }
+            sendFrame(XFER_DATA, (uint8_t)next, txBuf, (uint16_t)n);
+            next++;
+        }
+
+        if (!readFrame(rx, XFER_RESEND_MS))
+        {
+            if (++retries > XFER_MAX_RETRIES)
+                return false;
+            stats.resent += next - base;
+            next = base;
+            continue;
+        }
+
+        if (rx.type == XFER_ACK)
+        {
+            uint32_t acked = base + (uint8_t)(rx.seq - (uint8_t)base);
+            if (acked > base && acked <= next)
+            {
+                base = acked;
+                retries = 0;
+            }
+        }
+        else if (rx.type != XFER_DATA)
+        {
+            // 主机只在收完后才发新命令：只剩结束帧未确认时视为确认丢失
+            rxPending = true;
+            return base == total - 1 && next == total;
+        }
+    }
+    return true;
+}
+
+static void streamSource(XferSource &src)
+{
+    uint32_t t0 = millis();
+    sendSize(src.size);
+    if (sendStream(src))
+    {
+        stats.transfers++;
+        stats.bytes += src.size;
+    }
+    stats.busyMs += millis() - t0;
+}
+
+static void handleList()
+{
+    String dir = rx.len ? payloadPath(rx.payload, rx.len) : String("/");
+    File root = SPIFFS.open(dir);
+    if (!root || !root.isDirectory())
+    {
+        sendErr("not a directory");
+        return;
+    }
+    String text;
+    for (File f = root.openNextFile(); f; f = root.openNextFile())
+    {
+        text += f.path();
+        text += '\t';
+        text += (unsigned long)f.size();
+        text += '\n';
+    }
+    XferSource src;
+    src.text = &text;
+    src.size = text.length();
+    streamSource(src);
+}
+
+static void handleGet()
+{
+    String path = payloadPath(rx.payload, rx.len);
+    XferSource src;
+    src.text = nullptr;
+    src.file = SPIFFS.open(path, FILE_READ);
+    if (!src.file || src.file.isDirectory())
+    {
+        sendErr("not found");
+        return;
+    }
+    src.size = src.file.size();
+    streamSource(src);
+    src.file.close();
+}
+
+// --- 接收（PUT） ---
+
+// 接收 size 字节写入 f；成功时 endSeq 为结束帧序号，失败返回错误信息
+static const char *recvStream(File &f, uint32_t size, uint8_t &endSeq)
+{
+    uint32_t count = 0;
+    uint32_t written = 0;
+    sendAck(0);
+    for (;;)
+    {
+        if (!readFrame(rx, XFER_IDLE_TIMEOUT_MS))
+            return "timeout";
+        if (rx.type == XFER_PUT && count == 0)
+        {
+            sendAck(0); // 就绪确认丢失，主机重发了 PUT
+            continue;
+        }
+        if (rx.type == XFER_BYE)
+        {
+            rxPending = true;
+            return "aborted";
+        }
+        if (rx.type != XFER_DATA)
+            continue;
+        if (rx.seq != (uint8_t)count)
+        {
+            sendAck((uint8_t)count);
+            continue;
+        }
+        if (rx.len == 0)
+        {
+            if (written != size)
+                return "size mismatch";
+            endSeq = rx.seq;
+            return nullptr;
+        }
+        if (written + rx.len > size)
+            return "size mismatch";
+        if (f.write(rx.payload, rx.len) != rx.len)
+            return "write failed";
+        written += rx.len;
+        count++;
+        sendAck((uint8_t)count);
+    }
+}
+
+static void handlePut()
+{
+    if (rx.len < 5)
+    {
+        sendErr("bad request");
+        return;
+    }
+    uint32_t size = rx.payload[0] | (rx.payload[1] << 8) | (rx.payload[2] << 16) | ((uint32_t)rx.payload[3] << 24);
+    String path = payloadPath(rx.payload + 4, rx.len - 4);
+    String tmp = path + ".tmp";
+    // SPIFFS 文件名（含路径）最长 31 字节
+    if (path[0] != '/' || tmp.length() > 31)
+    {
+        sendErr("bad path");
+        return;
+    }
+    if (SPIFFS.totalBytes() - SPIFFS.usedBytes() < size)
+    {
+        sendErr("no space");
+        return;
+    }
+    File f = SPIFFS.open(tmp, FILE_WRITE);
+    if (!f)
+    {
+        sendErr("open failed");
+        return;
+    }
+
+    uint32_t t0 = millis();
+    uint8_t endSeq = 0;
+    const char *err = recvStream(f, size, endSeq);
+    f.close();
+    if (!err)
+    {
+        SPIFFS.remove(path);
+        if (!SPIFFS.rename(tmp, path))
+            err = "rename failed";
+    }
+    if (err)
+    {
+        SPIFFS.remove(tmp);
+        if (!rxPending)
+            sendErr(err);
+    }
+    else
+    {
+        sendAck((uint8_t)(endSeq + 1));
+        stats.transfers++;
+        stats.bytes += size;
+    }
+    stats.busyMs += millis() - t0;
+}
+
+// --- 任务 ---
+
+static void xferTaskMain(void *)
+{
+    Serial.flush(); // 先以原波特率发完 "XFER ..." 提示
+    Serial.updateBaudRate(xferBaud);
+    SPIFFS.begin(true);
+    memset(&stats, 0, sizeof(stats));
+    rxPending = false;
+    inPos = inLen = 0;
+
+    for (;;)
+    {
+        if (!rxPending && !readFrame(rx, XFER_IDLE_TIMEOUT_MS))
+            break;
+        rxPending = false;
+
+        if (rx.type == XFER_BYE)
+        {
+            sendFrame(XFER_BYE, 0, nullptr, 0);
+            break;
+        }
+        switch (rx.type)
+        {
+        case XFER_HELLO:
+        {
+            uint8_t p[4] = {PROTOCOL_VERSION, (uint8_t)XFER_WINDOW, (uint8_t)(XFER_CHUNK & 0xFF), (uint8_t)(XFER_CHUNK >> 8)};
+            sendFrame(XFER_HELLO, 0, p, sizeof(p));
+            break;
+        }
+        case XFER_LIST:
+            handleList();
+            break;
+        case XFER_GET:
+            handleGet();
+            break;
+        case XFER_PUT:
+            handlePut();
+            break;
+        case XFER_DATA:
+            // PUT 结束帧的确认丢失后主机会重发结束帧
+            if (rx.len == 0)
+                sendAck((uint8_t)(rx.seq + 1));
+            break;
+        default:
+            break;
+        }
+    }
+
+    Serial.flush();
+    Serial.updateBaudRate(SERIAL_CONSOLE_BAUD);
+    while (Serial.available())
+        Serial.read();
+    Serial.onReceive(uiNotify);
+    active = false;
+
+    uint32_t kbps10 = stats.busyMs ? (uint32_t)((uint64_t)stats.bytes * 10000 / 1024 / stats.busyMs) : 0;
+    Serial.printf("[XFER] done: %lu transfers, %lu B in %lu ms (%lu.%lu KB/s), resent %lu frames, %lu bad frames\n",
+                  (unsigned long)stats.transfers, (unsigned long)stats.bytes, (unsigned long)stats.busyMs,
+                  (unsigned long)(kbps10 / 10), (unsigned long)(kbps10 % 10), (unsigned long)stats.resent,
+                  (unsigned long)stats.badFrames);
+    uiNotify();
+    vTaskDelete(nullptr);
+}
+
+bool xferStart(uint32_t baud)
+{
+    if (active)
+        return false;
+    active = true;
+    xferBaud = baud;
+    // 传输期间串口数据不再唤醒 UI 任务
+    Serial.onReceive(nullptr);
+    if (xTaskCreatePinnedToCore(xferTaskMain, "xfer", 4096, nullptr, XFER_TASK_PRIO, nullptr, 0) != pdPASS)
+    {
+        Serial.onReceive(uiNotify);
+        active = false;
+        return false;
+    }
+    return true;
+}
+
+bool xferActive()
+{
+    return active;
+}
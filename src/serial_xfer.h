@@ -0,0 +1,48 @@
+// serial_xfer.h
+// USB 串口批量传输：二进制分帧、CRC32 校验、滑动窗口（回退 N 帧重传）
+//
+// 控制台命令 `xfer [波特率]` 进入传输模式：设备打印 "XFER <波特率>" 后切换串口波特率，
+// 由独立任务接管串口，直到收到 BYE 或空闲 XFER_IDLE_TIMEOUT_MS 后恢复控制台。
+// 主机端工具见 tools/wmxfer.py。
+//
+// 帧格式（多字节字段均为小端）：
+//   7E A5 | type:u8 | seq:u8 | len:u16 | payload[len] | crc32(type..payload)
+// 同步字节之外的杂散输出（如其它任务的调试打印）会因 CRC 不符而被跳过。
+//
+//   type   方向      payload
+//   HELLO  双向      主机：空；设备：version:u8 window:u8 chunk:u16
+//   LIST   主机→设备 目录（空为 "/"），设备以 SIZE + DATA 流返回 "路径\t大小\n" 文本
+//   GET    主机→设备 路径，设备回 SIZE size:u32，随后发送 DATA
+//   PUT    主机→设备 size:u32 + 路径，设备回 ACK(0) 后主机发送 DATA
+//   DATA   双向      seq 按帧递增（模 256），payload 为空表示文件结束
+//   ACK    双向      seq 为接收方期望的下一帧（累计确认）
+//   ERR    设备→主机 错误信息
+//   BYE    双向      退出传输模式
+//
+// PUT 先写入 "<路径>.tmp"，收到结束帧且长度一致后再替换原文件。
+
+#ifndef WM_SERIAL_XFER_H
+#define WM_SERIAL_XFER_H
+
+#include <Arduino.h>
+
+enum XferFrameType : uint8_t
+{
+    XFER_HELLO = 0x01,
+    XFER_LIST = 0x02,
+    XFER_GET = 0x03,
+    XFER_PUT = 0x04,
+    XFER_DATA = 0x05,
+    XFER_ACK = 0x06,
+    XFER_ERR = 0x07,
+    XFER_BYE = 0x08,
+    XFER_SIZE = 0x09
+};
+
+// 启动传输任务并切换到 baud；已在传输模式时返回 false（在控制台命令中调用）
+bool xferStart(uint32_t baud);
+
+// 传输模式中串口由传输任务独占，控制台不得读取
+bool xferActive();
+
+#endif // WM_SERIAL_XFER_H
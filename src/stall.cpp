@@ -0,0 +1,175 @@
+// stall.cpp
+// loop() 卡顿检测实现；区段栈与每轮最慢区段只由 UI 任务读写，日志读取也在 UI 任务（控制台）中
+
+#include "stall.h"
+#include "config.h"
+#include "logger.h"
+#include "metrics.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct StallFrame
+{
+    const char *name;
+    const char *file;
+    uint16_t line;
+    uint32_t caller;
+    uint32_t startUs;
+};
+
+static TaskHandle_t loopTask = nullptr;
+static StallFrame frames[STALL_DEPTH];
+static int depth = 0;
+
+// 本轮中最慢的区段（depth 越深越具体：内外层耗时相近时保留内层）
+static StallReport worst;
+static int worstDepth = -1;
+
+static StallReport reports[STALL_LOG_LEN];
+static size_t reportHead = 0;
+static size_t reportCount = 0;
+
+// Xtensa 窗口调用的返回地址高 2 位是窗口增量，还原为代码地址并指回 call 指令
+uint32_t stallCallerAddress(void *ra)
+{
+#if defined(__XTENSA__)
+    uint32_t pc = (uint32_t)ra;
+    return ((pc & 0x3FFFFFFF) | 0x40000000) - 3;
+#else
+    return (uint32_t)(uintptr_t)ra;
+#endif
+}
+
+void stallInit()
+{
+    loopTask = xTaskGetCurrentTaskHandle();
+}
+
+StallScope::StallScope(const char *name, const char *file, int line, void *returnAddress) : slot(-1)
+{
+    if (!loopTask || xTaskGetCurrentTaskHandle() != loopTask || depth >= (int)STALL_DEPTH)
+        return;
+    slot = (int8_t)depth++;
+    StallFrame &f = frames[slot];
+    f.name = name;
+    f.file = file;
+    f.line = (uint16_t)line;
+    f.caller = stallCallerAddress(returnAddress);
+    f.startUs = micros();
+}
+
+StallScope::~StallScope()
+{
+    if (slot < 0)
+        return;
+    depth = slot;
+    const StallFrame &f = frames[slot];
+    uint32_t ms = (micros() - f.startUs) / 1000;
+    if (ms < STALL_BUDGET_MS)
+        return;
+    // 更深的区段已经解释了这次卡顿，除非外层明显更慢（还有别的耗时）
+    if (worstDepth > slot && ms < worst.sectionMs + STALL_BUDGET_MS)
+        return;
+    // 同层或更外层的区段：保留更慢的一个
+    if (worstDepth >= 0 && worstDepth <= slot && ms <= worst.sectionMs)
+        return;
+    worst.sectionMs = ms;
+    worst.section = f.name;
+    worst.parent = slot > 0 ? frames[slot - 1].name : nullptr;
+    worst.file = f.file;
+    worst.line = f.line;
+    worst.caller = f.caller;
+    worstDepth = slot;
+}
+
+void stallLoopBegin()
+{
+    worstDepth = -1;
+    worst.section = nullptr;
+    worst.sectionMs = 0;
+}
+
+void stallLoopEnd(uint32_t loopUs)
+{
+    uint32_t ms = loopUs / 1000;
+    if (ms < STALL_BUDGET_MS)
+        return;
+    if (worstDepth < 0)
+    {
+        worst.section = nullptr;
+        worst.parent = nullptr;
+        worst.file = nullptr;
+        worst.line = 0;
+        worst.caller = 0;
+        worst.sectionMs = 0;
+    }
+    worst.atMs = millis();
+    worst.loopMs = ms;
+    reports[reportHead] = worst;
+    reportHead = (reportHead + 1) % STALL_LOG_LEN;
+    if (reportCount < STALL_LOG_LEN)
+        reportCount++;
+    metricInc(MC_LOOP_STALLS);
+    if (worst.section)
+        LOGW(LM_MAIN, "stall: loop %lu ms, %s %lu ms", (unsigned long)ms, worst.section,
+             (unsigned long)worst.sectionMs);
+    else
+        LOGW(LM_MAIN, "stall: loop %lu ms, no instrumented section", (unsigned long)ms);
+}
+
+const char *stallSection()
+{
+    if (xTaskGetCurrentTaskHandle() != loopTask || depth == 0)
+        return nullptr;
+    return frames[depth - 1].name;
+}
+
+uint32_t stallCount()
+{
+    return metricGet(MC_LOOP_STALLS);
+}
+
+size_t stallLogSize()
+{
+    return reportCount;
+}
+
+bool stallGet(size_t i, StallReport &out)
+{
+    if (i >= reportCount)
+        return false;
+    out = reports[(reportHead + STALL_LOG_LEN - reportCount + i) % STALL_LOG_LEN];
+    return true;
+}
+
+void stallClear()
+{
+    reportHead = 0;
+    reportCount = 0;
+}
+
+static const char *baseName(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+void stallPrint()
+{
+    Serial.printf("stalls: %lu total, budget %lu ms, last %u:\n", (unsigned long)stallCount(),
+                  (unsigned long)STALL_BUDGET_MS, (unsigned)reportCount);
+    StallReport r;
+    for (size_t i = 0; stallGet(i, r); i++)
+    {
+        Serial.printf("  t=%lu ms loop %lu ms: ", (unsigned long)r.atMs, (unsigned long)r.loopMs);
+        if (!r.section)
+        {
+            Serial.println("(no instrumented section)");
+            continue;
+        }
+        Serial.printf("%s %lu ms", r.section, (unsigned long)r.sectionMs);
+        if (r.parent)
+            Serial.printf(" in %s", r.parent);
+        Serial.printf(" at %s:%u caller 0x%08lx\n", baseName(r.file), (unsigned)r.line, (unsigned long)r.caller);
+    }
+}
@@ -0,0 +1,69 @@
+// stall.h
+// loop() 卡顿检测：每轮结束时把耗时与 STALL_BUDGET_MS 比较，超出则记录这一轮中耗时最长的
+// 已插桩区段（名称、耗时、所在源码位置、调用者地址与外层区段），保存在内存中的小环形日志里，
+// 控制台 `stalls` 查看。
+//
+// 区段只在 UI 任务（loop 任务）中生效，其它任务中构造 StallScope 不做任何事，
+// 因此 sendATCommand() 等同时被无线任务调用的函数也可以插桩。
+// 检测在每轮结束时进行；真正卡死（loop 不再返回）由 ESP-IDF 任务看门狗处理。
+//
+// 调用者地址可用 addr2line 解析：
+//   xtensa-esp32-elf-addr2line -pfiaC -e .pio/build/<env>/firmware.elf 0x400d1234
+
+#ifndef WM_STALL_H
+#define WM_STALL_H
+
+#include <Arduino.h>
+
+struct StallReport
+{
+    uint32_t atMs;      // 卡顿发生时的 millis()
+    uint32_t loopMs;    // 该轮 loop 总耗时
+    uint32_t sectionMs; // 区段耗时；无插桩区段时为 0
+    const char *section; // 区段名；nullptr 表示未落在任何插桩区段内
+    const char *parent;  // 外层区段名，可为 nullptr
+    const char *file;
+    uint16_t line;
+    uint32_t caller; // 区段所在函数的返回地址（即调用点）
+};
+
+// 在 setup() 中调用（记录 UI 任务句柄）
+void stallInit();
+
+// loop() 开始与处理结束（等待/睡眠之前）时调用；loopUs 为本轮处理耗时
+void stallLoopBegin();
+void stallLoopEnd(uint32_t loopUs);
+
+// 区段进入/退出（通过 STALL_SECTION 使用）
+class StallScope
+{
+public:
+    StallScope(const char *name, const char *file, int line, void *returnAddress);
+    ~StallScope();
+
+private:
+    int8_t slot; // 区段栈中的位置，-1 表示未记录
+};
+
+// 在函数开头使用：记录区段名、源码位置与调用者
+#define STALL_SECTION(name) StallScope stallScope(name, __FILE__, __LINE__, __builtin_return_address(0))
+
+// 把 __builtin_return_address(0) 还原为调用指令地址，供 addr2line 解析
+uint32_t stallCallerAddress(void *returnAddress);
+
+// 当前最内层的区段名；不在 UI 任务中或不在任何区段内时为 nullptr（不分配、不加锁，可在 malloc 钩子中调用）
+const char *stallSection();
+
+// 已记录的卡顿总数与环形日志中保留的条数
+uint32_t stallCount();
+size_t stallLogSize();
+
+// 取第 i 条（0 为最早）
+bool stallGet(size_t i, StallReport &out);
+
+void stallClear();
+
+// 打印全部记录到串口（控制台使用）
+void stallPrint();
+
+#endif // WM_STALL_H
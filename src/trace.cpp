@@ -0,0 +1,127 @@
+// trace.cpp
+// 事件追踪环形缓冲实现
+
+#include "trace.h"
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static const char *const TRACE_NAMES[TR_COUNT] = {
+    "key", "candidates", "draw", "oled_push", "rx", "tx", "at", "flash_write", "flash_read", "sleep"};
+
+#ifdef ENABLE_TRACE
+
+// 每核的时间锚点：tsUs = us + (当前周期数 - cc) / mhz
+struct TraceAnchor
+{
+    bool valid;
+    uint32_t cc;
+    uint32_t tick;
+    uint32_t mhz;
+    uint64_t us;
+};
+
+static TraceEvent ring[TRACE_EVENTS];
+static size_t head = 0;  // 下一个写入位置
+static size_t count = 0;
+static uint32_t dropped = 0;
+static volatile bool enabled = true;
+static TraceAnchor anchors[portNUM_PROCESSORS];
+static portMUX_TYPE traceLock = portMUX_INITIALIZER_UNLOCKED;
+
+void traceRecord(TraceId id, TracePhase phase, uint32_t arg)
+{
+    if (!enabled)
+        return;
+
+    portENTER_CRITICAL(&traceLock);
+    uint8_t core = (uint8_t)xPortGetCoreID();
+    uint32_t cc = ESP.getCycleCount();
+    uint32_t tick = xTaskGetTickCount();
+    TraceAnchor &a = anchors[core];
+    if (!a.valid || tick - a.tick >= pdMS_TO_TICKS(TRACE_ANCHOR_MS))
+    {
+        a.us = (uint64_t)esp_timer_get_time();
+        a.cc = cc;
+        a.tick = tick;
+        a.mhz = getCpuFrequencyMhz();
+        a.valid = true;
+    }
+
+    TraceEvent &e = ring[head];
+    e.tsUs = (uint32_t)(a.us + (cc - a.cc) / a.mhz);
+    e.id = id;
+    e.phase = phase;
+    e.core = core;
+    e.reserved = 0;
+    e.arg = arg;
+    head = (head + 1) % TRACE_EVENTS;
+    if (count < TRACE_EVENTS)
+        count++;
+    else
+        dropped++;
+    portEXIT_CRITICAL(&traceLock);
+}
+
+void traceResync()
+{
+    portENTER_CRITICAL(&traceLock);
+    for (auto &a : anchors)
+        a.valid = false;
+    portEXIT_CRITICAL(&traceLock);
+}
+
+void traceSetEnabled(bool on)
+{
+    enabled = on;
+}
+
+bool traceEnabled()
+{
+    return enabled;
+}
+
+size_t traceCount()
+{
+    return count;
+}
+
+uint32_t traceDropped()
+{
+    return dropped;
+}
+
+bool traceGet(size_t i, TraceEvent &out)
+{
+    portENTER_CRITICAL(&traceLock);
+    bool ok = i < count;
+    if (ok)
+        out = ring[(head + TRACE_EVENTS - count + i) % TRACE_EVENTS];
+    portEXIT_CRITICAL(&traceLock);
+    return ok;
+}
+
+void traceClear()
+{
+    portENTER_CRITICAL(&traceLock);
+    head = 0;
+    count = 0;
+    dropped = 0;
+    portEXIT_CRITICAL(&traceLock);
+}
+
+#else
+
+void traceSetEnabled(bool) {}
+bool traceEnabled() { return false; }
+size_t traceCount() { return 0; }
+uint32_t traceDropped() { return 0; }
+bool traceGet(size_t, TraceEvent &) { return false; }
+void traceClear() {}
+
+#endif
+
+const char *traceName(uint8_t id)
+{
+    return id < TR_COUNT ? TRACE_NAMES[id] : "?";
+}
@@ -0,0 +1,96 @@
+// trace.h
+// 事件追踪：定长环形缓冲记录 begin/end/instant 事件，控制台 `trace dump` 导出，
+// tools/trace2chrome.py 转换为 Chrome / Perfetto 可打开的 trace JSON
+//
+// 时间戳取自 CPU 周期计数器（每核独立、约 18 秒回绕、浅睡眠时停止）：每核保存一个
+// (周期数, esp_timer 微秒) 锚点，每 TRACE_ANCHOR_MS 或浅睡眠醒来后重新取锚点，
+// 因此两个核的事件落在同一条微秒时间轴上。记录一次事件约为一次自旋锁临界区的开销；
+// 只在任务上下文中调用（不在中断中）。
+//
+// 未定义 ENABLE_TRACE（config.h）时所有记录调用编译为空。
+
+#ifndef WM_TRACE_H
+#define WM_TRACE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+enum TraceId : uint8_t
+{
+    TR_KEY,        // 处理一个按键事件（arg = 键值）
+    TR_CANDIDATES, // updateCandidates()
+    TR_DRAW,       // drawUI() 组帧
+    TR_OLED_PUSH,  // I2C 推送帧缓冲（arg = 传输的页数，整帧为 8）
+    TR_RX,         // 无线任务读取一帧（arg = 字节数）
+    TR_TX,         // 无线任务发送一帧（arg = 字节数）
+    TR_AT,         // sendATCommand()
+    TR_FLASH_WRITE, // SPIFFS 写文件（arg = 字节数）
+    TR_FLASH_READ,  // SPIFFS 读文件/加载词库
+    TR_SLEEP,      // 浅睡眠（arg = 唤醒原因）
+    TR_COUNT
+};
+
+enum TracePhase : uint8_t
+{
+    TRACE_BEGIN = 'B',
+    TRACE_END = 'E',
+    TRACE_INSTANT = 'I'
+};
+
+struct TraceEvent
+{
+    uint32_t tsUs; // 开机以来的微秒数（低 32 位，约 71 分钟回绕，主机端展开）
+    uint8_t id;    // TraceId
+    uint8_t phase; // TracePhase
+    uint8_t core;
+    uint8_t reserved;
+    uint32_t arg;
+};
+
+#ifdef ENABLE_TRACE
+
+void traceRecord(TraceId id, TracePhase phase, uint32_t arg = 0);
+
+// 浅睡眠醒来后调用：周期计数器在睡眠期间停止，需要重新取锚点
+void traceResync();
+
+#else
+
+static inline void traceRecord(TraceId, TracePhase, uint32_t = 0) {}
+static inline void traceResync() {}
+
+#endif
+
+static inline void traceBegin(TraceId id, uint32_t arg = 0) { traceRecord(id, TRACE_BEGIN, arg); }
+static inline void traceEnd(TraceId id, uint32_t arg = 0) { traceRecord(id, TRACE_END, arg); }
+static inline void traceInstant(TraceId id, uint32_t arg = 0) { traceRecord(id, TRACE_INSTANT, arg); }
+
+// 作用域追踪：构造时 begin，析构时 end
+class TraceScope
+{
+public:
+    explicit TraceScope(TraceId id, uint32_t arg = 0) : traceId(id) { traceBegin(id, arg); }
+    ~TraceScope() { traceEnd(traceId); }
+
+private:
+    TraceId traceId;
+};
+
+// --- 导出（控制台使用） ---
+
+// 暂停/恢复记录；导出期间暂停，使缓冲内容保持不变
+void traceSetEnabled(bool on);
+bool traceEnabled();
+
+// 缓冲中的事件数与因回绕被覆盖的事件数
+size_t traceCount();
+uint32_t traceDropped();
+
+// 取第 i 个事件（0 为最早）
+bool traceGet(size_t i, TraceEvent &out);
+
+void traceClear();
+
+const char *traceName(uint8_t id);
+
+#endif // WM_TRACE_H
@@ -0,0 +1,207 @@
+// utf8.cpp
+// UTF-8 文本内核实现
+
+#include "utf8.h"
+#include <string.h>
+
+// 一次处理一个机器字；memcpy 读取，不要求对齐
+typedef size_t Word;
+static const Word HIGH_BITS = (Word)~(Word)0 / 0xFF * 0x80; // 每字节最高位
+
+static inline Word loadWord(const char *p)
+{
+    Word w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+// 多字节序列的长度（首字节），非法首字节返回 0
+static inline size_t seqLen(uint8_t c)
+{
+    if (c < 0x80)
+        return 1;
+    if (c >= 0xC2 && c <= 0xDF)
+        return 2;
+    if ((c & 0xF0) == 0xE0)
+        return 3;
+    if (c >= 0xF0 && c <= 0xF4)
+        return 4;
+    return 0; // 续字节、C0/C1（过长的 2 字节编码）、F5 以上
+}
+
+bool utf8Valid(const char *p, size_t len)
+{
+    const uint8_t *s = (const uint8_t *)p;
+    size_t i = 0;
+    while (i < len)
+    {
+        // ASCII 快路径：整字无最高位
+        if (s[i] < 0x80)
+        {
+            while (i + sizeof(Word) <= len && (loadWord(p + i) & HIGH_BITS) == 0)
+                i += sizeof(Word);
+            while (i < len && s[i] < 0x80)
+                i++;
+            if (i == len)
+                break;
+        }
+        uint8_t c = s[i];
+        // 常用汉字（U+1000..U+CFFF）的 3 字节序列无需范围检查
+        if (c >= 0xE1 && c <= 0xEC && i + 2 < len && utf8IsCont(s[i + 1]) && utf8IsCont(s[i + 2]))
+        {
+            i += 3;
+            continue;
+        }
+        size_t n = seqLen(c);
+        if (n == 0 || i + n > len)
+            return false;
+        uint8_t c1 = s[i + 1];
+        if (!utf8IsCont(c1))
+            return false;
+        // 第二字节的范围排除过长编码、代理区与超出 U+10FFFF 的码点
+        if ((c == 0xE0 && c1 < 0xA0) || (c == 0xED && c1 > 0x9F) || (c == 0xF0 && c1 < 0x90) ||
+            (c == 0xF4 && c1 > 0x8F))
+            return false;
+        for (size_t k = 2; k < n; k++)
+        {
+            if (!utf8IsCont(s[i + k]))
+                return false;
+        }
+        i += n;
+    }
+    return true;
+}
+
+size_t utf8Count(const char *p, size_t len)
+{
+    const uint8_t *s = (const uint8_t *)p;
+    size_t cont = 0;
+    size_t i = 0;
+    for (; i + sizeof(Word) <= len; i += sizeof(Word))
+    {
+        Word w = loadWord(p + i);
+        if ((w & HIGH_BITS) == 0)
+            continue; // 整字 ASCII
+        // 续字节：最高位为 1 且次高位为 0
+        Word m = w & ~(w << 1) & HIGH_BITS;
+        cont += (size_t)__builtin_popcountl((unsigned long)m);
+    }
+    for (; i < len; i++)
+        cont += utf8IsCont(s[i]);
+    return len - cont;
+}
+
+size_t utf8Floor(const char *p, size_t len, size_t n)
+{
+    if (n >= len)
+        return len;
+    while (n > 0 && utf8IsCont((uint8_t)p[n]))
+        n--;
+    return n;
+}
+
+size_t utf8Complete(const char *p, size_t len)
+{
+    if (len == 0)
+        return 0;
+    size_t start = utf8Prev(p, len);
+    size_t n = seqLen((uint8_t)p[start]);
+    return n != 0 && start + n > len ? start : len;
+}
+
+size_t utf8Next(const char *p, size_t len, size_t i)
+{
+    i++;
+    while (i < len && utf8IsCont((uint8_t)p[i]))
+        i++;
+    return i;
+}
+
+size_t utf8Prev(const char *p, size_t i)
+{
+    if (i == 0)
+        return 0;
+    // 最多退过 3 个续字节，避免在乱码中退得太远
+    size_t stop = i > 4 ? i - 4 : 0;
+    i--;
+    while (i > stop && utf8IsCont((uint8_t)p[i]))
+        i--;
+    return i;
+}
+
+uint32_t utf8Decode(const char *p, size_t len, size_t *i)
+{
+    const uint8_t *s = (const uint8_t *)p + *i;
+    size_t avail = len - *i;
+    uint8_t c = s[0];
+    size_t n = seqLen(c);
+    if (n == 1)
+    {
+        (*i)++;
+        return c;
+    }
+    if (n == 0 || n > avail)
+    {
+        (*i)++;
+        return 0xFFFD;
+    }
+    uint32_t cp = c & (0x7F >> n);
+    for (size_t k = 1; k < n; k++)
+    {
+        if (!utf8IsCont(s[k]))
+        {
+            (*i)++;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (s[k] & 0x3F);
+    }
+    *i += n;
+    return cp;
+}
+
+size_t utf8Copy(char *dst, size_t cap, const char *src, size_t len)
+{
+    if (cap == 0)
+        return 0;
+    size_t n = utf8Floor(src, len, cap - 1);
+    memmove(dst, src, n);
+    dst[n] = '\0';
+    return n;
+}
+
+size_t utf8FitWidth(const char *p, size_t len, int maxPx, Utf8WidthFn width, void *ctx, int *px)
+{
+    int used = 0;
+    size_t i = 0;
+    while (i < len)
+    {
+        size_t next = i;
+        int w = width(utf8Decode(p, len, &next), ctx);
+        if (used + w > maxPx)
+            break;
+        used += w;
+        i = next;
+    }
+    if (px)
+        *px = used;
+    return i;
+}
+
+size_t utf8FitWidthTail(const char *p, size_t len, int maxPx, Utf8WidthFn width, void *ctx, int *px)
+{
+    int used = 0;
+    size_t start = len;
+    while (start > 0)
+    {
+        size_t prev = utf8Prev(p, start);
+        size_t k = prev;
+        int w = width(utf8Decode(p, start, &k), ctx);
+        if (used + w > maxPx)
+            break;
+        used += w;
+        start = prev;
+    }
+    if (px)
+        *px = used;
+    return start;
+}
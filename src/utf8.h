@@ -0,0 +1,54 @@
+// utf8.h
+// UTF-8 文本内核：校验、计数、按字符边界切分与按像素宽度截断，全部不分配内存。
+//
+// 所有函数都按 (指针, 字节长度) 处理，不要求 '\0' 结尾；下标与返回值均为字节偏移。
+// 校验与计数一次取一个机器字（ESP32 上 4 字节），整字都是 ASCII 时直接跳过，
+// 中英文混排的聊天消息大多走这条快路径。
+// 不依赖 Arduino，可在主机上编译：bench/utf8_bench.cpp 比较与逐字节实现的吞吐量。
+
+#ifndef WM_UTF8_H
+#define WM_UTF8_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 续字节（10xxxxxx）
+static inline bool utf8IsCont(uint8_t c)
+{
+    return (c & 0xC0) == 0x80;
+}
+
+// 是否为合法 UTF-8：拒绝截断的序列、孤立续字节、过长编码、代理区与 U+10FFFF 以上的码点
+bool utf8Valid(const char *p, size_t len);
+
+// 码点个数（= 非续字节数；对非法输入也有定义）
+size_t utf8Count(const char *p, size_t len);
+
+// 不大于 n 的最大字符边界，用于安全截断；n 超过 len 时按 len
+size_t utf8Floor(const char *p, size_t len, size_t n);
+
+// 去掉末尾不完整的多字节序列后的长度（例如 snprintf 截断的输出）
+size_t utf8Complete(const char *p, size_t len);
+
+// i 之后下一个字符的起点（i < len）
+size_t utf8Next(const char *p, size_t len, size_t i);
+
+// i 之前一个字符的起点（i > 0），用于退格
+size_t utf8Prev(const char *p, size_t i);
+
+// 解码 *i 处的码点并前移 *i；非法序列返回 U+FFFD 并只前移一个字节
+uint32_t utf8Decode(const char *p, size_t len, size_t *i);
+
+// 把 src[0..len) 复制到 dst（容量 cap，含结尾 '\0'），放不下时在字符边界截断；返回复制的字节数
+size_t utf8Copy(char *dst, size_t cap, const char *src, size_t len);
+
+// 字形宽度（像素），例如 U8g2 当前字体的 u8g2_GetGlyphWidth
+typedef int (*Utf8WidthFn)(uint32_t cp, void *ctx);
+
+// 宽度不超过 maxPx 的最长前缀的字节数；px 非空时写入该前缀的宽度
+size_t utf8FitWidth(const char *p, size_t len, int maxPx, Utf8WidthFn width, void *ctx, int *px = nullptr);
+
+// 宽度不超过 maxPx 的最长后缀的起点；px 非空时写入该后缀的宽度
+size_t utf8FitWidthTail(const char *p, size_t len, int maxPx, Utf8WidthFn width, void *ctx, int *px = nullptr);
+
+#endif // WM_UTF8_H
@@ -0,0 +1,232 @@
+/*
+ * alloc_interpose.c
+ * 主机端分配统计（与固件 src/alloc_count.h 对应）：LD_PRELOAD 拦截 malloc/calloc/realloc/free，
+ * 按调用者地址累计次数与字节数，进程退出时把字节数最多的调用点（含符号名）打印到 stderr。
+ * 经 operator new 的分配归到 new 的调用者（std::string、std::map 等的成员函数）。
+ * 用于在 PC 上运行与固件共用的代码（如 bench/ 下的基准程序）时定位反复分配的来源。
+ *
+ *     gcc -O2 -shared -fPIC -o alloc_interpose.so tools/alloc_interpose.c -ldl
+ *     LD_PRELOAD=./alloc_interpose.so ./bench_prog
+ *     ALLOC_TOP=32 LD_PRELOAD=./alloc_interpose.so ./bench_prog   # 打印的调用点数（默认 16）
+ *
+ * 符号名未还原，可经 c++filt 查看：... 2>&1 >/dev/null | c++filt
+ * 被测程序用 -g -fno-omit-frame-pointer 编译时，可用 addr2line -e <程序> <地址> 查看源码行
+ * （PIE 程序先减去输出中的模块基址）。
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SITES_MAX 4096
+
+struct site
+{
+    uintptr_t caller;
+    unsigned long count;
+    unsigned long long bytes;
+};
+
+static struct site sites[SITES_MAX];
+static unsigned long overflow_count, frees;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *(*real_malloc)(size_t);
+static void *(*real_calloc)(size_t, size_t);
+static void *(*real_realloc)(void *, size_t);
+static void (*real_free)(void *);
+static uintptr_t new_begin[2]; /* operator new / new[] 的入口 */
+
+/* dlsym 自身可能调用 calloc：解析期间从静态缓冲分配 */
+static char bootstrap[4096];
+static size_t bootstrap_used;
+static __thread int in_hook;
+
+static void resolve(void)
+{
+    if (real_malloc)
+        return;
+    in_hook = 1;
+    real_calloc = dlsym(RTLD_NEXT, "calloc");
+    real_realloc = dlsym(RTLD_NEXT, "realloc");
+    real_free = dlsym(RTLD_NEXT, "free");
+    real_malloc = dlsym(RTLD_NEXT, "malloc");
+    new_begin[0] = (uintptr_t)dlsym(RTLD_DEFAULT, "_Znwm");
+    new_begin[1] = (uintptr_t)dlsym(RTLD_DEFAULT, "_Znam");
+    in_hook = 0;
+}
+
+static void *bootstrap_alloc(size_t size)
+{
+    size = (size + 15) & ~(size_t)15;
+    if (bootstrap_used + size > sizeof(bootstrap))
+        return NULL;
+    void *p = bootstrap + bootstrap_used;
+    bootstrap_used += size;
+    return p;
+}
+
+static int is_bootstrap(void *p)
+{
+    return (char *)p >= bootstrap && (char *)p < bootstrap + sizeof(bootstrap);
+}
+
+static int inside_new(uintptr_t pc)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (new_begin[i] && pc >= new_begin[i] && pc < new_begin[i] + 64)
+            return 1;
+    }
+    return 0;
+}
+
+static void record(void *ret, size_t bytes)
+{
+    if (in_hook)
+        return;
+    uintptr_t caller = (uintptr_t)ret;
+    if (inside_new(caller))
+    {
+        /* frames: record, malloc, operator new, 调用者（new[] 可能多经一层 new） */
+        void *frames[6];
+        in_hook = 1; /* 首次 backtrace 会加载 libgcc_s 并分配 */
+        int n = backtrace(frames, 6);
+        in_hook = 0;
+        for (int i = 2; i < n; i++)
+        {
+            if (!inside_new((uintptr_t)frames[i]))
+            {
+                caller = (uintptr_t)frames[i];
+                break;
+            }
+        }
+    }
+    size_t h = (caller >> 2) % SITES_MAX;
+    pthread_mutex_lock(&lock);
+    size_t i;
+    for (i = 0; i < SITES_MAX; i++)
+    {
+        struct site *s = &sites[(h + i) % SITES_MAX];
+        if (s->count == 0)
+            s->caller = caller;
+        if (s->caller == caller)
+        {
+            s->count++;
+            s->bytes += bytes;
+            break;
+        }
+    }
+    if (i == SITES_MAX)
+        overflow_count++;
+    pthread_mutex_unlock(&lock);
+}
+
+void *malloc(size_t size)
+{
+    if (!real_malloc)
+    {
+        if (in_hook)
+            return bootstrap_alloc(size);
+        resolve();
+    }
+    record(__builtin_return_address(0), size);
+    return real_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    if (!real_calloc)
+    {
+        if (in_hook)
+            return bootstrap_alloc(n * size); /* 静态缓冲已清零 */
+        resolve();
+    }
+    record(__builtin_return_address(0), n * size);
+    return real_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (!real_realloc)
+        resolve();
+    if (is_bootstrap(ptr))
+    {
+        void *p = malloc(size);
+        if (p)
+            memcpy(p, ptr, size);
+        return p;
+    }
+    if (size)
+        record(__builtin_return_address(0), size);
+    else if (ptr)
+        __atomic_add_fetch(&frees, 1, __ATOMIC_RELAXED);
+    return real_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    if (!ptr || is_bootstrap(ptr))
+        return;
+    if (!real_free)
+        resolve();
+    __atomic_add_fetch(&frees, 1, __ATOMIC_RELAXED);
+    real_free(ptr);
+}
+
+static int by_bytes(const void *a, const void *b)
+{
+    const struct site *x = a, *y = b;
+    return x->bytes < y->bytes ? 1 : x->bytes > y->bytes ? -1 : 0;
+}
+
+__attribute__((destructor)) static void report(void)
+{
+    in_hook = 1; /* 报告期间的分配（qsort、stdio）不计入 */
+    const char *env = getenv("ALLOC_TOP");
+    int top = env ? atoi(env) : 16;
+    unsigned long total = 0;
+    unsigned long long bytes = 0;
+    size_t used = 0;
+
+    pthread_mutex_lock(&lock);
+    for (size_t i = 0; i < SITES_MAX; i++)
+    {
+        if (sites[i].count)
+        {
+            total += sites[i].count;
+            bytes += sites[i].bytes;
+            sites[used++] = sites[i];
+        }
+    }
+    qsort(sites, used, sizeof(sites[0]), by_bytes);
+    fprintf(stderr, "alloc_interpose: %lu allocs, %llu bytes, %lu frees, %zu sites\n", total, bytes, frees, used);
+    for (size_t i = 0; i < used && (int)i < top; i++)
+    {
+        Dl_info info;
+        const char *sym = "?", *mod = "?";
+        uintptr_t off = 0, base = 0;
+        if (dladdr((void *)sites[i].caller, &info))
+        {
+            if (info.dli_sname)
+            {
+                sym = info.dli_sname;
+                off = sites[i].caller - (uintptr_t)info.dli_saddr;
+            }
+            if (info.dli_fname)
+                mod = strrchr(info.dli_fname, '/') ? strrchr(info.dli_fname, '/') + 1 : info.dli_fname;
+            base = (uintptr_t)info.dli_fbase;
+        }
+        fprintf(stderr, "  %#14lx %8lu x %12llu B  %s+%#lx (%s+%#lx)\n", (unsigned long)sites[i].caller,
+                sites[i].count, sites[i].bytes, sym, (unsigned long)off, mod,
+                (unsigned long)(sites[i].caller - base));
+    }
+    if (overflow_count)
+        fprintf(stderr, "  (site table full: %lu allocs not attributed)\n", overflow_count);
+    pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+"""
+构建时把 data/pinyin.json 转换为免解析的二进制词库 data/pinyin.bin
+
+作为 PlatformIO 的 pre 脚本运行（见 platformio_template.ini 的 extra_scripts），
+也可以单独运行：
+    python tools/build_dict.py [--json data/pinyin.json] [--out data/pinyin.bin] [--compress auto|yes|no]
+                               [--block-keys 32] [--bench]
+
+固件把它烧写在独立的 flash 分区 `pinyin`（partitions.csv）中，开机映射后直接按拼音二分查找
+（见 src/input_method/pinyin_dict.h），不再逐行解析 JSON、去声调、构建 std::map。输出只在内容变化时重写。
+更新词库无需重新烧写固件：
+    pio run -t uploaddict          由本脚本注册的目标，用 esptool 把 pinyin.bin 写到分区
+    pio run -t uploadfs            随 SPIFFS 上传，固件下次开机时校验后写入分区
+
+默认输出不压缩的格式 1，固件映射后零拷贝查找、不占 RAM；只有格式 1 放不下 `pinyin` 分区时
+（或 --compress yes）才输出分块压缩的格式 2，代价是块缓存与解压时临时分配的解压器（见 pinyin_dict.h）。
+
+格式 1（小端）：
+    头部 16 字节：'WMPY'、u16 版本（1）、u16 拼音数、u32 汉字区字节数、u32 头部之后全部内容的 CRC-32
+    拼音表：每项 16 字节，char[8] 无声调拼音（'\\0' 填充）、u32 汉字区偏移、u16 汉字数、u16 字节数；
+            按拼音字节序升序排列
+    汉字区：各拼音的候选字 UTF-8 依次拼接，同一拼音内保持 JSON 中的顺序并去重
+
+格式 2（小端）：
+    头部 28 字节：'WMPY'、u16 版本（2）、u16 拼音数、u16 块数、u16 每块拼音数、u16 最大块解压字节数、u16 保留、
+                  u32 压缩数据字节数、u32 解压后总字节数、u32 头部之后全部内容的 CRC-32
+    块索引：每块 16 字节，char[8] 块内第一个拼音、u32 压缩数据偏移、u16 压缩字节数、u16 解压字节数
+    压缩数据：各块依次拼接，每块单独用 raw deflate 压缩（固件用 ROM 中的 tinfl 解压），
+              查找只解压命中的一块
+    块解压后：拼音表（每项 16 字节，char[8] 无声调拼音（'\\0' 填充）、u32 块内汉字偏移、u16 汉字数、
+              u16 字节数），之后是这些拼音的候选字 UTF-8
+    拼音全局按字节序升序排列；同一拼音内保持 JSON 中的顺序并去重
+
+    python tools/build_dict.py --bench 在主机上比较不同块大小的压缩率与查找延迟。
+"""
+
+import argparse
+import json
+from bisect import bisect_right
+from collections import OrderedDict
+import os
+import random
+import struct
+import sys
+import time
+import zlib
+
+MAGIC = b"WMPY"
+VERSION_FLAT = 1
+VERSION_PACKED = 2
+KEY_LEN = 8
+BLOCK_KEYS = 32  # 每块拼音数：越大压缩率越高，但每次未命中缓存时解压越多
+HEADER_FLAT = struct.Struct("<4sHHII")
+HEADER = struct.Struct("<4sHHHHHHIII")
+BLOCK = struct.Struct("<%dsIHH" % KEY_LEN)
+ENTRY = struct.Struct("<%dsIHH" % KEY_LEN)
+
+# 与原固件 removeTones() 相同的替换表
+TONES = {
+    "ā": "a", "á": "a", "ǎ": "a", "à": "a",
+    "ē": "e", "é": "e", "ě": "e", "è": "e",
+    "ī": "i", "í": "i", "ǐ": "i", "ì": "i",
+    "ō": "o", "ó": "o", "ǒ": "o", "ò": "o",
+    "ū": "u", "ú": "u", "ǔ": "u", "ù": "u",
+    "ü": "v", "ǖ": "v", "ǘ": "v", "ǚ": "v", "ǜ": "v",
+    "ń": "n", "ň": "n",
+    "ɡ": "g", "ŋ": "ng", "ɑ": "a", "ɨ": "i", "ɯ": "u",
+}
+
+
+def remove_tones(pinyin):
+    return "".join(TONES.get(c, c) for c in pinyin).lower()
+
+
+def collect(entries):
+    """pinyin.json 的对象列表 -> {无声调拼音: [汉字, ...]}"""
+    table = {}
+    for e in entries:
+        ch = e.get("char", "")
+        if not ch:
+            continue
+        for py in e.get("pinyin", []):
+            key = remove_tones(py)
+            if not key:
+                continue
+            if len(key.encode("utf-8")) >= KEY_LEN:
+                raise SystemExit("build_dict: pinyin '%s' longer than %d bytes" % (key, KEY_LEN - 1))
+            chars = table.setdefault(key, [])
+            if ch not in chars:
+                chars.append(ch)
+    return table
+
+
+def raw_blocks(table, block_keys):
+    """按拼音排序后每 block_keys 个一块，返回 [(第一个拼音, 解压后的块内容)]"""
+    keys = sorted(table, key=lambda k: k.encode("utf-8"))
+    blocks = []
+    for start in range(0, len(keys), block_keys):
+        index, blob = bytearray(), bytearray()
+        for key in keys[start:start + block_keys]:
+            data = "".join(table[key]).encode("utf-8")
+            index += ENTRY.pack(key.encode("utf-8"), len(blob), len(table[key]), len(data))
+            blob += data
+        blocks.append((keys[start].encode("utf-8"), bytes(index + blob)))
+    return blocks
+
+
+def deflate(data):
+    c = zlib.compressobj(9, zlib.DEFLATED, -15)
+    return c.compress(data) + c.flush()
+
+
+def build_flat(table):
+    """不压缩的格式 1，返回 (二进制内容, 拼音数, 映射数)"""
+    body = raw_blocks(table, max(len(table), 1))[0][1] if table else b""
+    hanzi_bytes = len(body) - len(table) * ENTRY.size
+    header = HEADER_FLAT.pack(MAGIC, VERSION_FLAT, len(table), hanzi_bytes, zlib.crc32(body) & 0xFFFFFFFF)
+    return header + body, len(table), sum(len(v) for v in table.values())
+
+
+def build(table, block_keys=BLOCK_KEYS):
+    """分块压缩的格式 2，返回 (二进制内容, 拼音数, 映射数)"""
+    blocks = raw_blocks(table, block_keys)
+    index, packed, raw_total, max_raw = bytearray(), bytearray(), 0, 0
+    for first, raw in blocks:
+        z = deflate(raw)
+        if len(raw) > 0xFFFF or len(z) > 0xFFFF:
+            raise SystemExit("build_dict: block of %d bytes too large, lower --block-keys" % len(raw))
+        index += BLOCK.pack(first, len(packed), len(z), len(raw))
+        packed += z
+        raw_total += len(raw)
+        max_raw = max(max_raw, len(raw))
+    body = bytes(index + packed)
+    header = HEADER.pack(MAGIC, VERSION_PACKED, len(table), len(blocks), block_keys, max_raw, 0, len(packed), raw_total,
+                         zlib.crc32(body) & 0xFFFFFFFF)
+    return header + body, len(table), sum(len(v) for v in table.values())
+
+
+def bench(table, cache_blocks=4):
+    """不同块大小下的压缩率，以及按输入过程模拟的查找延迟：miss 为每次都解压，avg 为带 LRU 块缓存"""
+    keys = sorted(table, key=lambda k: k.encode("utf-8"))
+    raw_size = len(build_flat(table)[0])  # 不压缩的格式 1
+    typed = list(keys)
+    random.Random(1).shuffle(typed)  # 按随机顺序"输入"每个拼音，逐个前缀查找
+    queries = [k[:n] for k in typed for n in range(1, len(k) + 1)]
+    print("%d pinyin keys, %d queries, cache %d blocks" % (len(keys), len(queries), cache_blocks))
+    print("%10s %8s %8s %7s %9s %9s %8s" % ("block keys", "blocks", "bytes", "ratio", "miss us", "avg us", "hit %"))
+    for bk in (8, 16, 32, 64, 128):
+        blocks = [(first, deflate(raw)) for first, raw in raw_blocks(table, bk)]
+        size = len(build(table, bk)[0])
+        firsts = [f for f, _ in blocks]
+
+        def lookup(py, cache):
+            # 与固件相同：按块首拼音定位块，再在块内查找；未命中缓存时解压
+            b = max(0, bisect_right(firsts, py.encode("utf-8")) - 1)
+            if b in cache:
+                cache.move_to_end(b)
+                return True
+            cache[b] = zlib.decompress(blocks[b][1], -15)
+            if len(cache) > cache_blocks:
+                cache.popitem(last=False)
+            return False
+
+        t0 = time.perf_counter()
+        for py in queries:
+            lookup(py, OrderedDict())
+        miss_us = (time.perf_counter() - t0) * 1e6 / len(queries)
+        cache, hits = OrderedDict(), 0
+        t0 = time.perf_counter()
+        for py in queries:
+            hits += lookup(py, cache)
+        avg_us = (time.perf_counter() - t0) * 1e6 / len(queries)
+        print("%10d %8d %8d %6.1f%% %9.1f %9.1f %7.1f%%" % (bk, len(blocks), size, 100.0 * size / raw_size, miss_us,
+                                                         avg_us, 100.0 * hits / len(queries)))
+    print("uncompressed: %d bytes; latencies are host CPU times, run `membench` on the device for real numbers"
+          % raw_size)
+
+
+def generate(json_path, out_path, block_keys=BLOCK_KEYS, compress="auto", limit=None):
+    """compress 为 auto 时只在格式 1 超过 limit（分区大小）时压缩"""
+    if not os.path.exists(json_path):
+        print("build_dict: %s not found, skipping" % json_path)
+        return False
+    with open(json_path, encoding="utf-8") as f:
+        table = collect(json.load(f))
+    data, keys, mappings = build_flat(table)
+    if compress == "yes" or (compress == "auto" and limit is not None and len(data) > limit):
+        flat = len(data)
+        data, keys, mappings = build(table, block_keys)
+        print("build_dict: %d bytes uncompressed, writing %d-byte compressed format" % (flat, len(data)))
+    if os.path.exists(out_path):
+        with open(out_path, "rb") as f:
+            if f.read() == data:
+                return True
+    with open(out_path, "wb") as f:
+        f.write(data)
+    print("build_dict: %d pinyin keys, %d mappings, %d bytes -> %s" % (keys, mappings, len(data), out_path))
+    return True
+
+
+def partition_entry(csv_path, name):
+    """partitions.csv 中分区 name 的 (偏移字符串如 0x270000, 字节数)；找不到返回 None"""
+    if not os.path.exists(csv_path):
+        return None
+    with open(csv_path, encoding="utf-8") as f:
+        for line in f:
+            cols = [c.strip() for c in line.split("#", 1)[0].split(",")]
+            if len(cols) >= 5 and cols[0] == name:
+                size = cols[4].upper()
+                scale = {"K": 1024, "M": 1024 * 1024}.get(size[-1:], 1)
+                return cols[3], int(size.rstrip("KM"), 0) * scale
+    return None
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("--json", default=os.path.join(root, "data", "pinyin.json"))
+    ap.add_argument("--out", default=os.path.join(root, "data", "pinyin.bin"))
+    ap.add_argument("--compress", choices=("auto", "yes", "no"), default="auto",
+                    help="compressed blocks: auto only when the flat format outgrows the pinyin partition")
+    ap.add_argument("--block-keys", type=int, default=BLOCK_KEYS, help="pinyin keys per compressed block")
+    ap.add_argument("--bench", action="store_true", help="compare block sizes on the host instead of writing")
+    args = ap.parse_args()
+    if args.bench:
+        with open(args.json, encoding="utf-8") as f:
+            bench(collect(json.load(f)))
+        return 0
+    part = partition_entry(os.path.join(root, "partitions.csv"), "pinyin")
+    return 0 if generate(args.json, args.out, args.block_keys, args.compress, part[1] if part else None) else 1
+
+
+try:
+    Import("env")  # noqa: F821  (PlatformIO / SCons)
+except NameError:
+    env = None
+
+if env is not None:
+    _data = os.path.join(env.subst("$PROJECT_DIR"), "data")
+    _bin = os.path.join(_data, "pinyin.bin")
+    _part = partition_entry(os.path.join(env.subst("$PROJECT_DIR"), "partitions.csv"), "pinyin")
+    generate(os.path.join(_data, "pinyin.json"), _bin, limit=_part[1] if _part else None)
+    if _part:
+        env.AddCustomTarget(
+            name="uploaddict",
+            dependencies=None,
+            actions=['"$PYTHONEXE" "$UPLOADER" --chip $BOARD_MCU --port "$UPLOAD_PORT" --baud $UPLOAD_SPEED '
+                     'write_flash %s "%s"' % (_part[0], _bin)],
+            title="Upload dictionary",
+            description="Write data/pinyin.bin to the pinyin partition",
+        )
+elif __name__ == "__main__":
+    sys.exit(main())
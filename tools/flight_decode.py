@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+解码控制台 `flight dump` 导出的飞行记录器数据（src/flight_rec.h），输出 CSV，可选绘图
+
+    # 从串口日志文件转换
+    python tools/flight_decode.py monitor.log -o flight.csv
+    # 直接连接设备：发送 `flight dump` 并读取输出（需要 pyserial）
+    python tools/flight_decode.py --port /dev/ttyUSB0 -o flight.csv --plot flight.png
+
+输入格式（见 src/console.cpp）：
+    FLIGHT 1 records=<n> interval=<秒> size=32
+    F <64 个十六进制字符>
+    -- end --
+日志中有多段导出时使用最后一段；CRC 不符的记录被丢弃。
+
+链路丢包估算：每个邻居每 --rip-interval 秒广播一次 RIP 更新，
+loss = 1 - 收到的更新数 / (邻居数 × 采样间隔 / RIP 间隔)。路由表含多跳条目时偏高，只看趋势。
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import time
+import zlib
+
+# 与 FlightRecord 一致（小端，32 字节）
+RECORD = struct.Struct("<IIBBBBHHHHHHHHHH")
+FIELDS = ["seq", "uptime_s", "boot", "neighbors", "flags", "sleep_pct", "rx_frames", "tx_frames", "rx_lost",
+          "tx_failed", "rip_recv", "stalls", "heap_free", "heap_largest", "energy_uah", "crc"]
+FLAG_LOW_POWER = 1
+FLAG_BOOT = 2
+
+
+def parse_dump(lines):
+    """返回 (interval, [bytes])"""
+    interval, records, current = None, None, None
+    for raw in lines:
+        line = raw.strip()
+        if line.startswith("FLIGHT "):
+            fields = dict(f.split("=", 1) for f in line.split()[2:] if "=" in f)
+            current = (int(fields.get("interval", "60")), [])
+        elif current is not None and line.startswith("F "):
+            try:
+                data = bytes.fromhex(line[2:])
+            except ValueError:
+                continue
+            if len(data) == RECORD.size:
+                current[1].append(data)
+        elif current is not None and line == "-- end --":
+            interval, records = current
+            current = None
+    if current is not None:  # 导出被截断：仍使用已收到的部分
+        interval, records = current
+    if records is None:
+        raise SystemExit("no flight dump found in input")
+    return interval, records
+
+
+def decode(records, interval, rip_interval):
+    rows, bad = [], 0
+    t = 0.0  # 跨次开机连续的时间轴（小时）；开机之间的断电时长未知，按一个采样间隔计
+    last = None
+    for data in records:
+        rec = dict(zip(FIELDS, RECORD.unpack(data)))
+        if rec["crc"] != zlib.crc32(data[:RECORD.size - 2]) & 0xFFFF:
+            bad += 1
+            continue
+        if last is not None:
+            same_boot = rec["boot"] == last["boot"] and not rec["flags"] & FLAG_BOOT
+            step = rec["uptime_s"] - last["uptime_s"] if same_boot else interval
+            t += max(step, 0) / 3600.0
+        rec["t_hours"] = round(t, 4)
+        rec["heap_free"] *= 16
+        rec["heap_largest"] *= 16
+        rec["low_power"] = int(bool(rec["flags"] & FLAG_LOW_POWER))
+        expected = rec["neighbors"] * interval / rip_interval
+        rec["rip_loss"] = round(max(0.0, 1.0 - rec["rip_recv"] / expected), 3) if expected else ""
+        rows.append(rec)
+        last = rec
+    return rows, bad
+
+
+def plot(rows, path):
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        raise SystemExit("matplotlib is required for --plot: pip install matplotlib")
+    t = [r["t_hours"] for r in rows]
+    panels = [
+        ("frames / sample", [("rx_frames", "rx"), ("tx_frames", "tx"), ("rx_lost", "rx lost"), ("tx_failed", "tx failed")]),
+        ("link", [("neighbors", "neighbors"), ("rip_loss", "rip loss (est.)")]),
+        ("heap (bytes)", [("heap_free", "free"), ("heap_largest", "largest block")]),
+        ("power", [("energy_uah", "uAh / sample"), ("sleep_pct", "cpu asleep %")]),
+        ("loop stalls", [("stalls", "stalls")]),
+    ]
+    fig, axes = plt.subplots(len(panels), 1, sharex=True, figsize=(10, 2.2 * len(panels)))
+    for ax, (title, series) in zip(axes, panels):
+        for key, label in series:
+            ax.plot(t, [r[key] if r[key] != "" else float("nan") for r in rows], label=label, linewidth=1)
+        for r in rows:
+            if r["flags"] & FLAG_BOOT:
+                ax.axvline(r["t_hours"], color="grey", linestyle=":", linewidth=0.8)
+        ax.set_ylabel(title)
+        ax.legend(loc="upper left", fontsize="small")
+    axes[-1].set_xlabel("hours (dotted lines: reboot)")
+    fig.tight_layout()
+    fig.savefig(path, dpi=120)
+
+
+def read_from_port(port, baud, timeout):
+    try:
+        import serial
+    except ImportError:
+        raise SystemExit("pyserial is required for --port: pip install pyserial")
+    ser = serial.Serial()
+    ser.port = port
+    ser.baudrate = baud
+    ser.dtr = False  # 不复位开发板
+    ser.rts = False
+    ser.timeout = 0.5
+    ser.open()
+    ser.reset_input_buffer()
+    ser.write(b"\r\nflight dump\r\n")
+    lines, started = [], False
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        line = ser.readline().decode(errors="replace")
+        if not line:
+            continue
+        started = started or line.startswith("FLIGHT ")
+        if started:
+            lines.append(line)
+            if line.strip() == "-- end --":
+                break
+    ser.close()
+    return lines
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Decode a WirelessMessage flight recorder dump to CSV")
+    ap.add_argument("log", nargs="?", help="serial log containing `flight dump` output (default: stdin)")
+    ap.add_argument("-o", "--output", default="flight.csv")
+    ap.add_argument("--plot", help="also write a PNG chart to this path (needs matplotlib)")
+    ap.add_argument("--rip-interval", type=float, default=10.0, help="RIP update period in seconds (src/rip.cpp)")
+    ap.add_argument("--port", help="read the dump directly from this serial port")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--timeout", type=float, default=60.0, help="seconds to wait for the dump with --port")
+    args = ap.parse_args()
+
+    if args.port:
+        lines = read_from_port(args.port, args.baud, args.timeout)
+    elif args.log:
+        with open(args.log, encoding="utf-8", errors="replace") as f:
+            lines = f.readlines()
+    else:
+        lines = sys.stdin.readlines()
+
+    interval, records = parse_dump(lines)
+    rows, bad = decode(records, interval, args.rip_interval)
+    columns = ["t_hours"] + [f for f in FIELDS if f != "crc"] + ["low_power", "rip_loss"]
+    with open(args.output, "w", newline="", encoding="utf-8") as f:
+        w = csv.DictWriter(f, fieldnames=columns, extrasaction="ignore")
+        w.writeheader()
+        w.writerows(rows)
+    if args.plot and rows:
+        plot(rows, args.plot)
+    span = rows[-1]["t_hours"] if rows else 0.0
+    print("%d records (%d bad) over %.1f h -> %s" % (len(rows), bad, span, args.output))
+
+
+if __name__ == "__main__":
+    main()
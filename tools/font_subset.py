@@ -0,0 +1,367 @@
+#!/usr/bin/env python3
+"""
+构建时字体裁剪：从 u8g2_font_wqy12_t_gb2312 中只保留词库、界面字符串与基本字集的字形
+
+基本字集（默认 GB2312 一级汉字 3755 个）覆盖经无线收到或由控制台 `send` 输入、
+但不在词库中的常用字，避免这些字显示为空白；--base none 只保留词库与界面字符。
+
+作为 PlatformIO 的 pre 脚本运行（见 platformio_template.ini 的 extra_scripts），
+也可以单独运行：
+    python tools/font_subset.py --font-src <U8g2>/src/clib/u8g2_fonts.c [--base gb2312-1|none]
+
+输出 src/generated/font_cjk.cpp（定义 wm_font_cjk），并为构建追加 WM_FONT_SUBSET 宏；
+找不到 U8g2 源码（例如首次构建库尚未安装）时删除生成文件，固件回退到完整字体。
+
+u8g2 字体格式：23 字节头部；随后是编码 < 0x100 的字形链表；再是 unicode 跳转表
+（每项 2 字节偏移 + 2 字节该块最大编码，以 0xFFFF 结束）与按块排列的字形。
+u8g2 先线性扫描跳转表找到第一个“最大编码 >= 目标”的块，再在块内线性比较，
+因此块内字形顺序可以任意：这里按字频排列，让常用字最先被命中。
+"""
+
+import argparse
+import glob
+import json
+import os
+import re
+import sys
+
+FONT_NAME = "u8g2_font_wqy12_t_gb2312"
+OUT_SYMBOL = "wm_font_cjk"
+HEADER_SIZE = 23
+BLOCK_SIZES = (8, 12, 16, 24, 32, 48, 64, 96, 128)
+DEFAULT_BASE = "gb2312-1"
+
+
+# ---------------------------------------------------------------------------
+# 读取 u8g2_fonts.c 中的字体数组
+
+
+def _decode_c_string(body):
+    """解码单个 C 字符串字面量内容（不含引号）"""
+    out = bytearray()
+    i = 0
+    n = len(body)
+    simple = {"n": 10, "t": 9, "r": 13, "\\": 92, '"': 34, "'": 39, "?": 63, "a": 7, "b": 8, "f": 12, "v": 11}
+    while i < n:
+        c = body[i]
+        if c != "\\":
+            out += c.encode("latin-1")
+            i += 1
+            continue
+        i += 1
+        c = body[i]
+        if c in "01234567":
+            j = i
+            while j < n and j < i + 3 and body[j] in "01234567":
+                j += 1
+            out.append(int(body[i:j], 8) & 0xFF)
+            i = j
+        elif c == "x":
+            j = i + 1
+            while j < n and body[j] in "0123456789abcdefABCDEF":
+                j += 1
+            out.append(int(body[i + 1 : j], 16) & 0xFF)
+            i = j
+        else:
+            out.append(simple[c])
+            i += 1
+    return bytes(out)
+
+
+def extract_font_bytes(path, name):
+    with open(path, "r", encoding="latin-1") as f:
+        src = f.read()
+    m = re.search(r"\b" + re.escape(name) + r"\s*\[\s*\d*\s*\][^=]*=", src)
+    if not m:
+        raise ValueError("font %s not found in %s" % (name, path))
+    # 逐个读取相邻的字符串字面量，直到语句结束（字面量内部也可能出现 ';'）
+    token = re.compile(r'\s*"((?:[^"\\\n]|\\.)*)"')
+    out = bytearray()
+    pos = m.end()
+    while True:
+        t = token.match(src, pos)
+        if not t:
+            break
+        out += _decode_c_string(t.group(1))
+        pos = t.end()
+    return bytes(out)
+
+
+# ---------------------------------------------------------------------------
+# 解析与重建 u8g2 字体
+
+
+def _word(data, pos):
+    return (data[pos] << 8) | data[pos + 1]
+
+
+def parse_font(data):
+    """返回 (头部, 低位字形区原始字节, [(编码, 字形字节)])"""
+    header = bytearray(data[:HEADER_SIZE])
+    start_unicode = _word(data, 21)
+    if start_unicode == 0:
+        raise ValueError("font has no unicode section")
+    lower = data[HEADER_SIZE : HEADER_SIZE + start_unicode]
+
+    table = HEADER_SIZE + start_unicode
+    glyphs = []
+    pos = table + _word(data, table)
+    while True:
+        enc = _word(data, pos)
+        if enc == 0:
+            break
+        size = data[pos + 2]
+        glyphs.append((enc, bytes(data[pos : pos + size])))
+        pos += size
+    return header, lower, glyphs
+
+
+def build_font(header, lower, blocks):
+    """blocks: [[(编码, 字形字节), ...], ...]，块间按编码升序，块内顺序即查找顺序"""
+    table = bytearray()
+    body = bytearray()
+    entry_count = len(blocks) + 1
+    prev = 0
+    offset = entry_count * 4
+    for blk in blocks:
+        table += bytes([(offset - prev) >> 8 & 0xFF, (offset - prev) & 0xFF])
+        last = max(enc for enc, _ in blk)
+        table += bytes([last >> 8, last & 0xFF])
+        prev = offset
+        for _, g in blk:
+            body += g
+            offset += len(g)
+    # 结束项指向终止符，使超出范围的编码立即失败
+    table += bytes([(offset - prev) >> 8 & 0xFF, (offset - prev) & 0xFF, 0xFF, 0xFF])
+    body += b"\x00\x00"
+    if offset - prev > 0xFFFF:
+        raise ValueError("unicode block too large")
+    return bytes(header) + bytes(lower) + bytes(table) + bytes(body)
+
+
+def lookup_probes(font, encoding):
+    """按 u8g2_font_get_glyph_data() 的方式查找，返回 (是否找到, 比较次数)"""
+    table = HEADER_SIZE + _word(font, 21)
+    pos = table
+    probes = 0
+    while True:
+        pos += _word(font, table)
+        e = _word(font, table + 2)
+        table += 4
+        probes += 1
+        if e >= encoding:
+            break
+    while True:
+        e = _word(font, pos)
+        probes += 1
+        if e == 0:
+            return False, probes
+        if e == encoding:
+            return True, probes
+        pos += font[pos + 2]
+
+
+def expected_probes(font, weights):
+    total = sum(weights.values())
+    cost = 0.0
+    for enc, w in weights.items():
+        found, probes = lookup_probes(font, enc)
+        if not found:
+            raise ValueError("glyph U+%04X lost in subset" % enc)
+        cost += w * probes
+    return cost / total
+
+
+# ---------------------------------------------------------------------------
+# 字符集合与字频
+
+
+def dictionary_chars(dict_path):
+    """返回 {码点: 权重}，权重按字频等级与序号递减（近似 Zipf 分布）"""
+    with open(dict_path, "r", encoding="utf-8") as f:
+        entries = json.load(f)
+    ranked = sorted(entries, key=lambda e: (e.get("frequency", 9), e.get("index", 0)))
+    weights = {}
+    for rank, e in enumerate(ranked, 1):
+        for ch in e.get("char", ""):
+            cp = ord(ch)
+            if cp >= 0x100 and cp not in weights:
+                weights[cp] = 1.0 / rank
+    return weights
+
+
+def base_chars(name):
+    """基本字集的码点；gb2312-1 为 GB2312 一级汉字（区 16..55，按拼音排序的常用字）"""
+    if name == "none":
+        return set()
+    if name != "gb2312-1":
+        raise ValueError("unknown base set %s" % name)
+    chars = set()
+    for hi in range(0xB0, 0xD8):
+        for lo in range(0xA1, 0xFF):
+            if hi == 0xD7 and lo > 0xF9:  # 55 区只到 89 位
+                break
+            chars.add(ord(bytes([hi, lo]).decode("gb2312")))
+    return chars
+
+
+def _strip_comments(src):
+    out = []
+    i = 0
+    n = len(src)
+    while i < n:
+        c = src[i]
+        if c == '"' or c == "'":
+            j = i + 1
+            while j < n and src[j] != c:
+                j += 2 if src[j] == "\\" else 1
+            out.append(src[i : j + 1])
+            i = j + 1
+        elif src.startswith("//", i):
+            i = src.find("\n", i)
+            i = n if i < 0 else i
+        elif src.startswith("/*", i):
+            i = src.find("*/", i + 2)
+            i = n if i < 0 else i + 2
+        else:
+            out.append(c)
+            i += 1
+    return "".join(out)
+
+
+def ui_chars(src_dir):
+    """收集源码字符串字面量中出现的非 ASCII 字符（界面提示等）"""
+    chars = set()
+    for path in glob.glob(os.path.join(src_dir, "**", "*.*"), recursive=True):
+        if not path.endswith((".cpp", ".h", ".c")) or os.sep + "generated" + os.sep in path:
+            continue
+        with open(path, "r", encoding="utf-8", errors="ignore") as f:
+            code = _strip_comments(f.read())
+        for lit in re.findall(r'"((?:[^"\\\n]|\\.)*)"', code):
+            chars.update(ord(ch) for ch in lit if ord(ch) >= 0x100)
+    return chars
+
+
+# ---------------------------------------------------------------------------
+
+
+def make_subset(font, weights, extra):
+    header, lower, glyphs = parse_font(font)
+    keep = set(weights) | set(extra)
+    kept = [(enc, g) for enc, g in glyphs if enc in keep]
+    # 界面字符可能不在词库中：给一个与最低频词库字相同的权重
+    floor = min(weights.values()) if weights else 1.0
+    w = {enc: weights.get(enc, floor) for enc, _ in kept}
+
+    best = None
+    for size in BLOCK_SIZES:
+        blocks = [kept[i : i + size] for i in range(0, len(kept), size)]
+        blocks = [sorted(b, key=lambda g: -w[g[0]]) for b in blocks]
+        out = build_font(header, lower, blocks)
+        cost = expected_probes(out, w)
+        if best is None or cost < best[1]:
+            best = (out, cost, size)
+
+    full_cost = expected_probes(font, w)
+    return {
+        "font": best[0],
+        "block": best[2],
+        "glyphs": len(kept),
+        "full_glyphs": len(glyphs),
+        "full_size": len(font),
+        "size": len(best[0]),
+        "full_probes": full_cost,
+        "probes": best[1],
+        "missing": sorted(keep - {enc for enc, _ in kept}),
+    }
+
+
+def render_cpp(data):
+    lines = [
+        "// 由 tools/font_subset.py 生成，请勿手工修改",
+        "#include <U8g2lib.h>",
+        "",
+        "extern const uint8_t %s[%d];" % (OUT_SYMBOL, len(data)),
+        'const uint8_t %s[%d] U8G2_FONT_SECTION("%s") = {' % (OUT_SYMBOL, len(data), OUT_SYMBOL),
+    ]
+    for i in range(0, len(data), 16):
+        lines.append("    " + ",".join("0x%02x" % b for b in data[i : i + 16]) + ",")
+    lines.append("};")
+    return "\r\n".join(lines) + "\r\n"
+
+
+def write_if_changed(path, text):
+    if os.path.exists(path):
+        with open(path, "r", encoding="utf-8", newline="") as f:
+            if f.read() == text:
+                return
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, "w", encoding="utf-8", newline="") as f:
+        f.write(text)
+
+
+def generate(project_dir, font_src, out_path, base=DEFAULT_BASE):
+    """生成子集字体；成功返回 True，无法生成时删除旧输出并返回 False"""
+    if not font_src or not os.path.exists(font_src):
+        if os.path.exists(out_path):
+            os.remove(out_path)
+        print("font_subset: U8g2 source not found, using full %s" % FONT_NAME)
+        return False
+
+    weights = dictionary_chars(os.path.join(project_dir, "data", "pinyin.json"))
+    extra = ui_chars(os.path.join(project_dir, "src")) | base_chars(base)
+    res = make_subset(extract_font_bytes(font_src, FONT_NAME), weights, extra)
+    write_if_changed(out_path, render_cpp(res["font"]))
+
+    saved = res["full_size"] - res["size"]
+    print(
+        "font_subset: %d/%d glyphs (base set %s), %d -> %d bytes (saved %d bytes, %.1f%%)"
+        % (res["glyphs"], res["full_glyphs"], base, res["full_size"], res["size"], saved, 100.0 * saved / res["full_size"])
+    )
+    print(
+        "font_subset: expected glyph lookup probes %.1f -> %.1f (%.1fx, block size %d)"
+        % (res["full_probes"], res["probes"], res["full_probes"] / res["probes"], res["block"])
+    )
+    if res["missing"]:
+        print("font_subset: %d source chars not in %s (ignored): %s"
+              % (len(res["missing"]), FONT_NAME, "".join(chr(c) for c in res["missing"][:20])))
+    return True
+
+
+def find_font_source(libdeps_dir, env_name):
+    candidates = []
+    if libdeps_dir:
+        candidates.append(os.path.join(libdeps_dir, env_name or "*", "U8g2", "src", "clib", "u8g2_fonts.c"))
+    candidates.append(os.path.join(os.path.expanduser("~"), ".platformio", "lib", "U8g2*", "src", "clib", "u8g2_fonts.c"))
+    for pattern in candidates:
+        found = sorted(glob.glob(pattern))
+        if found:
+            return found[0]
+    return None
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("--font-src", help="path to U8g2 src/clib/u8g2_fonts.c")
+    ap.add_argument("--project", default=root)
+    ap.add_argument("--out", default=os.path.join(root, "src", "generated", "font_cjk.cpp"))
+    ap.add_argument("--base", default=DEFAULT_BASE, choices=("gb2312-1", "none"),
+                    help="glyphs always kept besides dictionary and UI chars (default %(default)s)")
+    args = ap.parse_args()
+    font_src = args.font_src or find_font_source(os.path.join(args.project, ".pio", "libdeps"), None)
+    return 0 if generate(args.project, font_src, args.out, args.base) else 1
+
+
+try:
+    Import("env")  # noqa: F821  (PlatformIO / SCons)
+except NameError:
+    env = None
+
+if env is not None:
+    _project = env.subst("$PROJECT_DIR")
+    _src = find_font_source(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"))
+    if generate(_project, _src, os.path.join(_project, "src", "generated", "font_cjk.cpp")):
+        env.Append(CPPDEFINES=["WM_FONT_SUBSET"])
+elif __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+把控制台 `trace dump` 的输出转换为 Chrome trace JSON（chrome://tracing 或 https://ui.perfetto.dev 打开）
+
+    # 从串口日志文件（例如 pio device monitor 的输出另存）转换
+    python tools/trace2chrome.py monitor.log -o trace.json
+    # 直接连接设备：发送 `trace dump` 并读取输出（需要 pyserial）
+    python tools/trace2chrome.py --port /dev/ttyUSB0 -o trace.json
+
+输入格式（见 src/console.cpp 与 src/trace.h）：
+    TRACE 1 events=<n> dropped=<n> names=key,candidates,...
+    T <时间戳us> <核> <B|E|I> <事件id> <参数>
+    -- end --
+日志中有多段导出时使用最后一段；夹杂的其它调试输出被忽略。
+每个核显示为一条线程轨道；缓冲回绕导致缺少开头 B 的 E 事件被丢弃。
+"""
+
+import argparse
+import json
+import sys
+import time
+
+
+def parse_dump(lines):
+    """返回 (names, events)；events 为 (ts, core, phase, id, arg) 列表"""
+    names, events, current = None, None, None
+    for raw in lines:
+        line = raw.strip()
+        if line.startswith("TRACE "):
+            fields = dict(f.split("=", 1) for f in line.split()[2:] if "=" in f)
+            current = (fields.get("names", "").split(","), [])
+        elif current is not None and line.startswith("T "):
+            parts = line.split()
+            if len(parts) != 6:
+                continue
+            try:
+                current[1].append((int(parts[1]), int(parts[2]), parts[3], int(parts[4]), int(parts[5])))
+            except ValueError:
+                continue
+        elif current is not None and line == "-- end --":
+            names, events = current
+            current = None
+    if current is not None:  # 导出被截断：仍使用已收到的部分
+        names, events = current
+    if names is None:
+        raise SystemExit("no trace dump found in input")
+    return names, events
+
+
+def unwrap(events):
+    """时间戳为 32 位微秒，约 71 分钟回绕；按出现顺序展开"""
+    out, offset, last = [], 0, None
+    for ts, core, ph, eid, arg in events:
+        if last is not None and ts + offset < last - (1 << 31):
+            offset += 1 << 32
+        last = ts + offset
+        out.append((last, core, ph, eid, arg))
+    return out
+
+
+def to_chrome(names, events):
+    trace = [{"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "WirelessMessage"}}]
+    cores = sorted({e[1] for e in events})
+    for core in cores:
+        trace.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": core, "args": {"name": "core %d" % core}})
+    base = events[0][0] if events else 0
+    depth = {}
+    for ts, core, ph, eid, arg in events:
+        name = names[eid] if eid < len(names) else "id%d" % eid
+        ev = {"name": name, "pid": 1, "tid": core, "ts": ts - base}
+        if ph == "B":
+            depth[core] = depth.get(core, 0) + 1
+            ev["ph"] = "B"
+        elif ph == "E":
+            if depth.get(core, 0) == 0:
+                continue
+            depth[core] -= 1
+            ev["ph"] = "E"
+        else:
+            ev["ph"] = "i"
+            ev["s"] = "t"
+        if arg:
+            ev["args"] = {"arg": arg}
+        trace.append(ev)
+    return {"traceEvents": trace, "displayTimeUnit": "ms"}
+
+
+def read_from_port(port, baud, timeout):
+    try:
+        import serial
+    except ImportError:
+        raise SystemExit("pyserial is required for --port: pip install pyserial")
+    ser = serial.Serial()
+    ser.port = port
+    ser.baudrate = baud
+    ser.dtr = False  # 不复位开发板
+    ser.rts = False
+    ser.timeout = 0.5
+    ser.open()
+    ser.reset_input_buffer()
+    ser.write(b"\r\ntrace dump\r\n")
+    lines, started = [], False
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        line = ser.readline().decode(errors="replace")
+        if not line:
+            continue
+        started = started or line.startswith("TRACE ")
+        if started:
+            lines.append(line)
+            if line.strip() == "-- end --":
+                break
+    ser.close()
+    return lines
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Convert a WirelessMessage trace dump to Chrome trace JSON")
+    ap.add_argument("log", nargs="?", help="serial log containing `trace dump` output (default: stdin)")
+    ap.add_argument("-o", "--output", default="trace.json")
+    ap.add_argument("--port", help="read the dump directly from this serial port")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--timeout", type=float, default=30.0, help="seconds to wait for the dump with --port")
+    args = ap.parse_args()
+
+    if args.port:
+        lines = read_from_port(args.port, args.baud, args.timeout)
+    elif args.log:
+        with open(args.log, encoding="utf-8", errors="replace") as f:
+            lines = f.readlines()
+    else:
+        lines = sys.stdin.readlines()
+
+    names, events = parse_dump(lines)
+    events = unwrap(events)
+    with open(args.output, "w", encoding="utf-8") as f:
+        json.dump(to_chrome(names, events), f)
+    span = (events[-1][0] - events[0][0]) / 1000.0 if events else 0.0
+    print("%d events over %.1f ms -> %s" % (len(events), span, args.output))
+
+
+if __name__ == "__main__":
+    main()
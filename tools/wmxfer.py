@@ -0,0 +1,256 @@
+#!/usr/bin/env python3
+"""
+通过 USB 串口与设备文件系统（SPIFFS）交换文件，无需重新烧写 SPIFFS 镜像
+
+    python tools/wmxfer.py -p /dev/ttyUSB0 ls
+    python tools/wmxfer.py -p /dev/ttyUSB0 get /history.txt history.txt
+    python tools/wmxfer.py -p /dev/ttyUSB0 put data/pinyin.bin /pinyin.bin
+
+先在控制台波特率下发送 `xfer <波特率>`，设备回 "XFER <波特率>" 后双方切换到高波特率，
+之后使用 src/serial_xfer.h 中描述的分帧协议（CRC32 + 回退 N 帧滑动窗口）。
+传输完成后打印吞吐量；设备退出传输模式时也会在控制台打印本次会话的统计。
+
+依赖 pyserial（PlatformIO 自带）。
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+import zlib
+
+try:
+    import serial
+except ImportError:  # pragma: no cover
+    sys.exit("pyserial is required: pip install pyserial")
+
+SYNC = b"\x7e\xa5"
+HELLO, LIST, GET, PUT, DATA, ACK, ERR, BYE, SIZE = range(1, 10)
+TYPE_NAMES = {HELLO: "HELLO", LIST: "LIST", GET: "GET", PUT: "PUT", DATA: "DATA",
+              ACK: "ACK", ERR: "ERR", BYE: "BYE", SIZE: "SIZE"}
+
+
+class XferError(Exception):
+    pass
+
+
+class Link:
+    """分帧收发；杂散字节（设备调试输出）与校验失败的帧被跳过"""
+
+    def __init__(self, ser, max_payload=1024):
+        self.ser = ser
+        self.max_payload = max_payload
+        self.buf = bytearray()
+        self.bad_frames = 0
+
+    def send(self, ftype, seq=0, payload=b""):
+        body = struct.pack("<BBH", ftype, seq & 0xFF, len(payload)) + payload
+        self.ser.write(SYNC + body + struct.pack("<I", zlib.crc32(body)))
+
+    def _fill(self, deadline):
+        n = max(1, self.ser.in_waiting)
+        self.ser.timeout = max(0.0, min(0.05, deadline - time.monotonic()))
+        self.buf += self.ser.read(n)
+
+    def recv(self, timeout):
+        """返回 (type, seq, payload)；超时返回 None"""
+        deadline = time.monotonic() + timeout
+        while True:
+            i = self.buf.find(SYNC)
+            if i < 0:
+                del self.buf[:max(0, len(self.buf) - 1)]
+            else:
+                del self.buf[:i]
+                if len(self.buf) >= 6:
+                    ftype, seq, length = struct.unpack_from("<BBH", self.buf, 2)
+                    if length > self.max_payload:
+                        self.bad_frames += 1
+                        del self.buf[:2]
+                        continue
+                    if len(self.buf) >= 6 + length + 4:
+                        body = bytes(self.buf[2:6 + length])
+                        (crc,) = struct.unpack_from("<I", self.buf, 6 + length)
+                        if crc != zlib.crc32(body):
+                            self.bad_frames += 1
+                            del self.buf[:2]
+                            continue
+                        del self.buf[:6 + length + 4]
+                        return ftype, seq, body[4:]
+            if time.monotonic() >= deadline:
+                return None
+            self._fill(deadline)
+
+    def request(self, ftype, payload, expect, timeout, retries=5):
+        """发送请求直到收到 expect 中的一种帧；ERR 抛出异常"""
+        for _ in range(retries):
+            self.send(ftype, 0, payload)
+            end = time.monotonic() + timeout
+            while True:
+                frame = self.recv(max(0.0, end - time.monotonic()))
+                if frame is None:
+                    break
+                if frame[0] == ERR:
+                    raise XferError(frame[2].decode(errors="replace"))
+                if frame[0] in expect:
+                    return frame
+        raise XferError("no reply to %s" % TYPE_NAMES[ftype])
+
+
+class Session:
+    def __init__(self, port, console_baud, baud, timeout):
+        self.timeout = timeout
+        self.ser = serial.Serial()
+        self.ser.port = port
+        self.ser.baudrate = console_baud
+        # 不拉 DTR/RTS，否则多数开发板会复位
+        self.ser.dtr = False
+        self.ser.rts = False
+        self.ser.open()
+        self.link = Link(self.ser)
+        self._enter(baud)
+        self.retransmits = 0
+
+    def _enter(self, baud):
+        self.ser.reset_input_buffer()
+        self.ser.write(b"\r\nxfer %d\r\n" % baud)
+        token = b"XFER %d" % baud
+        seen = b""
+        deadline = time.monotonic() + 3.0
+        while token not in seen:
+            if time.monotonic() > deadline:
+                raise XferError("device did not enter xfer mode (is the console idle?)")
+            self.ser.timeout = 0.1
+            seen = (seen + self.ser.read(256))[-256:]
+        self.ser.flush()
+        time.sleep(0.05)
+        self.ser.baudrate = baud
+        self.ser.reset_input_buffer()
+        _, _, p = self.link.request(HELLO, b"", (HELLO,), 0.3, retries=10)
+        version, self.window, self.chunk = struct.unpack_from("<BBH", p)
+        self.link.max_payload = max(self.chunk, 1024)
+        print("connected: protocol v%d, window %d, chunk %d, %d baud" % (version, self.window, self.chunk, baud))
+
+    def close(self):
+        try:
+            self.link.request(BYE, b"", (BYE,), 0.3, retries=3)
+        except XferError:
+            pass
+        self.ser.close()
+
+    # --- 接收（设备发送） ---
+
+    def _recv_stream(self, ftype, payload):
+        _, _, p = self.link.request(ftype, payload, (SIZE,), self.timeout)
+        (size,) = struct.unpack("<I", p)
+        data = bytearray()
+        expected = 0
+        while True:
+            frame = self.link.recv(self.timeout)
+            if frame is None:
+                raise XferError("timeout after %d of %d bytes" % (len(data), size))
+            ftype, seq, p = frame
+            if ftype == ERR:
+                raise XferError(p.decode(errors="replace"))
+            if ftype != DATA:
+                continue
+            if seq != expected & 0xFF:
+                self.link.send(ACK, expected)
+                continue
+            expected += 1
+            self.link.send(ACK, expected)
+            if not p:
+                break
+            data += p
+        if len(data) != size:
+            raise XferError("size mismatch: got %d of %d bytes" % (len(data), size))
+        return bytes(data)
+
+    def list(self, path="/"):
+        return self._recv_stream(LIST, path.encode()).decode(errors="replace")
+
+    def get(self, path):
+        return self._recv_stream(GET, path.encode())
+
+    # --- 发送（设备接收） ---
+
+    def put(self, path, data):
+        self.link.request(PUT, struct.pack("<I", len(data)) + path.encode(), (ACK,), self.timeout)
+        chunks = [data[i:i + self.chunk] for i in range(0, len(data), self.chunk)] + [b""]
+        total = len(chunks)
+        base = nxt = 0
+        retries = 0
+        while base < total:
+            while nxt < total and nxt - base < self.window:
+                self.link.send(DATA, nxt, chunks[nxt])
+                nxt += 1
+            frame = self.link.recv(self.timeout)
+            if frame is None:
+                retries += 1
+                if retries > 10:
+                    raise XferError("no acknowledgement, giving up at %d of %d bytes" % (base * self.chunk, len(data)))
+                self.retransmits += nxt - base
+                nxt = base
+                continue
+            ftype, seq, p = frame
+            if ftype == ERR:
+                raise XferError(p.decode(errors="replace"))
+            if ftype == ACK:
+                acked = base + ((seq - base) & 0xFF)
+                if base < acked <= nxt:
+                    base = acked
+                    retries = 0
+
+
+def _rate(nbytes, seconds):
+    return "%d B in %.2f s, %.1f KB/s" % (nbytes, seconds, nbytes / 1024.0 / max(seconds, 1e-6))
+
+
+def main():
+    ap = argparse.ArgumentParser(description="WirelessMessage file transfer over USB serial")
+    ap.add_argument("-p", "--port", required=True, help="serial port, e.g. /dev/ttyUSB0")
+    ap.add_argument("-b", "--baud", type=int, default=921600, help="transfer baud rate (default 921600)")
+    ap.add_argument("--console-baud", type=int, default=115200, help="console baud rate (default 115200)")
+    ap.add_argument("--timeout", type=float, default=1.0, help="acknowledgement timeout in seconds")
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    p_ls = sub.add_parser("ls", help="list files")
+    p_ls.add_argument("path", nargs="?", default="/")
+    p_get = sub.add_parser("get", help="download a file")
+    p_get.add_argument("remote")
+    p_get.add_argument("local", nargs="?")
+    p_put = sub.add_parser("put", help="upload a file")
+    p_put.add_argument("local")
+    p_put.add_argument("remote", nargs="?")
+    args = ap.parse_args()
+
+    try:
+        s = Session(args.port, args.console_baud, args.baud, args.timeout)
+    except (XferError, serial.SerialException) as e:
+        sys.exit("error: %s" % e)
+    try:
+        t0 = time.monotonic()
+        if args.cmd == "ls":
+            sys.stdout.write(s.list(args.path))
+        elif args.cmd == "get":
+            data = s.get(args.remote)
+            local = args.local or os.path.basename(args.remote)
+            with open(local, "wb") as f:
+                f.write(data)
+            print("get %s -> %s: %s" % (args.remote, local, _rate(len(data), time.monotonic() - t0)))
+        elif args.cmd == "put":
+            with open(args.local, "rb") as f:
+                data = f.read()
+            remote = args.remote or "/" + os.path.basename(args.local)
+            s.put(remote, data)
+            print("put %s -> %s: %s, %d frames resent" % (
+                args.local, remote, _rate(len(data), time.monotonic() - t0), s.retransmits))
+        if s.link.bad_frames:
+            print("%d bad frames skipped" % s.link.bad_frames)
+    except XferError as e:
+        sys.exit("error: %s" % e)
+    finally:
+        s.close()
+
+
+if __name__ == "__main__":
+    main()